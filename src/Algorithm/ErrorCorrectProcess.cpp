@@ -272,24 +272,57 @@ ErrorCorrectResult ErrorCorrectProcess::kmerCorrection(const SequenceWorkItem& w
         std::vector<int> countVector(nk, 0);
         std::vector<int> solidVector(n, 0);
 
+        // Find the kmers that are not in the cache for this read,
+        // taking their counts from the kmer table or the shared cache when possible
+        std::vector<int> uncachedIdx;
         for(int i = 0; i < nk; ++i)
         {
             std::string kmer = readSequence.substr(i, m_params.kmerLength);
+            if(kmerCache.find(kmer) != kmerCache.end())
+                continue;
+
+            size_t count;
+            if(m_params.pKmerTable != NULL)
+                kmerCache[kmer] = m_params.pKmerTable->count(kmer.c_str());
+            else if(m_params.pKmerCache != NULL && m_params.pKmerCache->lookup(kmer.c_str(), count))
+                kmerCache[kmer] = count;
+            else
+                uncachedIdx.push_back(i);
+        }
 
-            // First check if this kmer is in the cache
-            // If its not, find its count from the fm-index and cache it
-            int count = 0;
-            KmerCountMap::iterator iter = kmerCache.find(kmer);
-
-            if(iter != kmerCache.end())
+        if(!uncachedIdx.empty())
+        {
+            // Count each run of adjacent uncached kmers in one pass over the read so
+            // the searches for overlapping kmers are shared. After the first round this
+            // is the range around the last correction.
+            std::vector<size_t> counts;
+            size_t runStart = 0;
+            while(runStart < uncachedIdx.size())
             {
-                count = iter->second;
+                size_t runEnd = runStart + 1;
+                while(runEnd < uncachedIdx.size() && uncachedIdx[runEnd] == uncachedIdx[runEnd - 1] + 1)
+                    ++runEnd;
+
+                std::string run = readSequence.substr(uncachedIdx[runStart], runEnd - runStart + m_params.kmerLength - 1);
+                std::vector<size_t> runCounts;
+                BWTAlgorithms::countKmerOccurrences(run, m_params.kmerLength, m_params.indices, runCounts);
+                counts.insert(counts.end(), runCounts.begin(), runCounts.end());
+                runStart = runEnd;
             }
-            else
+
+            for(size_t i = 0; i < uncachedIdx.size(); ++i)
             {
-                count = BWTAlgorithms::countSequenceOccurrences(kmer, m_params.indices);
-                kmerCache.insert(std::make_pair(kmer, count));
+                std::string kmer = readSequence.substr(uncachedIdx[i], m_params.kmerLength);
+                kmerCache[kmer] = counts[i];
+                if(m_params.pKmerCache != NULL)
+                    m_params.pKmerCache->insert(kmer.c_str(), counts[i]);
             }
+        }
+
+        for(int i = 0; i < nk; ++i)
+        {
+            std::string kmer = readSequence.substr(i, m_params.kmerLength);
+            int count = kmerCache.find(kmer)->second;
 
             // Get the phred score for the last base of the kmer
             int phred = minPhredVector[i];
@@ -383,13 +416,52 @@ bool ErrorCorrectProcess::attemptKmerCorrection(size_t i, size_t k_idx, size_t m
     std::cout << "i: " << i << " k-idx: " << k_idx << " " << kmer << " " << reverseComplement(kmer) << "\n";
 #endif
 
+    // Count all the alternative kmers that are not in the kmer table
+    // or the shared cache at once
+    std::vector<std::string> alternativeKmers;
+    std::vector<char> alternativeBases;
+    std::vector<size_t> alternativeCounts;
+    std::vector<std::string> uncachedKmers;
+    std::vector<size_t> uncachedIdx;
     for(int j = 0; j < DNA_ALPHABET::size; ++j)
     {
         char currBase = ALPHABET[j];
         if(currBase == originalBase)
             continue;
         kmer[base_idx] = currBase;
-        size_t count = BWTAlgorithms::countSequenceOccurrences(kmer, m_params.indices);
+
+        size_t count = 0;
+        if(m_params.pKmerTable != NULL)
+        {
+            count = m_params.pKmerTable->count(kmer.c_str());
+        }
+        else if(m_params.pKmerCache == NULL || !m_params.pKmerCache->lookup(kmer.c_str(), count))
+        {
+            uncachedKmers.push_back(kmer);
+            uncachedIdx.push_back(alternativeKmers.size());
+        }
+
+        alternativeKmers.push_back(kmer);
+        alternativeBases.push_back(currBase);
+        alternativeCounts.push_back(count);
+    }
+
+    if(!uncachedKmers.empty())
+    {
+        std::vector<size_t> uncachedCounts;
+        BWTAlgorithms::countSequenceOccurrencesBatch(uncachedKmers, m_params.indices, uncachedCounts);
+        for(size_t j = 0; j < uncachedKmers.size(); ++j)
+        {
+            alternativeCounts[uncachedIdx[j]] = uncachedCounts[j];
+            if(m_params.pKmerCache != NULL)
+                m_params.pKmerCache->insert(uncachedKmers[j].c_str(), uncachedCounts[j]);
+        }
+    }
+
+    for(size_t j = 0; j < alternativeKmers.size(); ++j)
+    {
+        char currBase = alternativeBases[j];
+        size_t count = alternativeCounts[j];
 
 #if KMER_TESTING
         printf("%c %zu\n", currBase, count);
@@ -17,6 +17,8 @@
 #include "MultiOverlap.h"
 #include "Metrics.h"
 #include "BWTIndexSet.h"
+#include "KmerCountCache.h"
+#include "KmerCountTable.h"
 #include "SampledSuffixArray.h"
 #include "multiple_alignment.h"
 
@@ -59,6 +61,13 @@ struct ErrorCorrectParameters
     int kmerLength;
     int countOffset;
 
+    // Counts shared by all the correction threads, or NULL
+    KmerCountCache* pKmerCache;
+
+    // Precomputed counts of all the kmers, or NULL. If set, the
+    // kmer counts are read from the table instead of the FM-index.
+    const KmerCountTable* pKmerTable;
+
     // output options
     bool printOverlaps;
 };
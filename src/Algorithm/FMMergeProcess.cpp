@@ -63,7 +63,7 @@ FMMergeResult FMMergeProcess::process(const SequenceWorkItem& item)
         ssID << "IDX-" << readInterval.lower;
         std::string rootID = ssID.str();
         
-        Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(rootID, readString);
+        Vertex* pVertex = pGraph->createVertex(rootID, readString);
         pGraph->addVertex(pVertex);
 
         // Add the root vertex to the result structure
@@ -262,7 +262,7 @@ void FMMergeProcess::addCandidates(StringGraph* pGraph, const Vertex* pX, const
             // Generate the new vertex
             if(pY == NULL)
             {
-                pY = new(pGraph->getVertexAllocator()) Vertex(vertexID, vertexSeq);
+                pY = pGraph->createVertex(vertexID, vertexSeq);
                 pGraph->addVertex(pY);
             }
 
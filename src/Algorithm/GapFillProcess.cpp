@@ -154,7 +154,10 @@ GapFillReturnCode GapFillProcess::processGap(size_t k, int estimatedSize, const
 
     HaplotypeBuilder builder;
     builder.setTerminals(startAnchor, endAnchor);
-    builder.setIndex(m_parameters.pBWT, m_parameters.pRevBWT);
+    if(m_parameters.bothStrands)
+        builder.setBothStrandsIndex(m_parameters.pBWT);
+    else
+        builder.setIndex(m_parameters.pBWT, m_parameters.pRevBWT);
     builder.setKmerParameters(k, m_parameters.kmerThreshold);
     HaplotypeBuilderReturnCode code = builder.run();
     
@@ -208,7 +211,17 @@ AnchorSequence GapFillProcess::findAnchor(size_t k, const std::string& scaffold,
         if(testSeq.find_first_not_of("ACGT") != std::string::npos)
             continue;
 
-        size_t count = BWTAlgorithms::countSequenceOccurrencesWithCache(testSeq, m_parameters.pBWT, m_parameters.pBWTCache);
+        // An index of both strands already counts the reverse complement
+        size_t count;
+        if(m_parameters.bothStrands)
+        {
+            BWTInterval interval = BWTAlgorithms::findIntervalWithCache(m_parameters.pBWT, m_parameters.pBWTCache, testSeq);
+            count = interval.isValid() ? interval.size() : 0;
+        }
+        else
+        {
+            count = BWTAlgorithms::countSequenceOccurrencesWithCache(testSeq, m_parameters.pBWT, m_parameters.pBWTCache);
+        }
         if(count > m_parameters.kmerThreshold)
         {
             anchor.sequence = testSeq;
@@ -33,6 +33,9 @@ struct GapFillParameters
 
     const BWTIntervalCache* pBWTCache;
     const BWTIntervalCache* pRevBWTCache;
+
+    // pBWT holds both strands of the reads (sga index --both-strands)
+    bool bothStrands;
     
     size_t startKmer;
     size_t endKmer;
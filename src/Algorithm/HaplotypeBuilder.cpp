@@ -16,7 +16,8 @@
 //
 //
 //
-HaplotypeBuilder::HaplotypeBuilder() : m_pStartVertex(NULL), m_pJoinVertex(NULL), m_kmerThreshold(1), m_kmerSize(51)
+HaplotypeBuilder::HaplotypeBuilder() : m_pBWT(NULL), m_pRevBWT(NULL), m_bothStrands(false),
+                                       m_pStartVertex(NULL), m_pJoinVertex(NULL), m_kmerThreshold(1), m_kmerSize(51)
 {
     m_pGraph = new StringGraph;
 }
@@ -41,10 +42,10 @@ void HaplotypeBuilder::setTerminals(const AnchorSequence& leftAnchor, const Anch
     // As we are creating a de Bruijn graph, we use the sequence
     // of the vertex as its ID
     assert(leftAnchor.sequence != rightAnchor.sequence);
-    Vertex* pLeftVertex = new(m_pGraph->getVertexAllocator()) Vertex(leftAnchor.sequence, leftAnchor.sequence);
+    Vertex* pLeftVertex = m_pGraph->createVertex(leftAnchor.sequence, leftAnchor.sequence);
     addVertex(pLeftVertex, leftAnchor.count);
 
-    Vertex* pRightVertex = new(m_pGraph->getVertexAllocator()) Vertex(rightAnchor.sequence, rightAnchor.sequence);
+    Vertex* pRightVertex = m_pGraph->createVertex(rightAnchor.sequence, rightAnchor.sequence);
     addVertex(pRightVertex, rightAnchor.count);
 
     // Add the vertex to the extension queue
@@ -59,6 +60,15 @@ void HaplotypeBuilder::setIndex(const BWT* pBWT, const BWT* pRBWT)
 {
     m_pBWT = pBWT;
     m_pRevBWT = pRBWT;
+    m_bothStrands = false;
+}
+
+//
+void HaplotypeBuilder::setBothStrandsIndex(const BWT* pBWT)
+{
+    m_pBWT = pBWT;
+    m_pRevBWT = NULL;
+    m_bothStrands = true;
 }
 
 // Run the bubble construction process
@@ -89,7 +99,9 @@ HaplotypeBuilderReturnCode HaplotypeBuilder::run()
         // Calculate de Bruijn extensions for this node
         std::string vertStr = curr.pVertex->getSeq().toString();
         AlphaCount64 extensionCounts;
-        if(m_pRevBWT != NULL)
+        if(m_bothStrands)
+            extensionCounts = BWTAlgorithms::calculateDeBruijnExtensionsBothStrands(vertStr, m_pBWT, curr.direction);
+        else if(m_pRevBWT != NULL)
             extensionCounts = BWTAlgorithms::calculateDeBruijnExtensions(vertStr, m_pBWT, m_pRevBWT, curr.direction);
         else
             extensionCounts = BWTAlgorithms::calculateDeBruijnExtensionsSingleIndex(vertStr, m_pBWT, curr.direction);
@@ -109,7 +121,7 @@ HaplotypeBuilderReturnCode HaplotypeBuilder::run()
             bool joinFound = pVertex != NULL && pVertex == m_pJoinVertex;
             if(!joinFound && pVertex == NULL)
             {
-                pVertex = new(m_pGraph->getVertexAllocator()) Vertex(newStr, newStr);
+                pVertex = m_pGraph->createVertex(newStr, newStr);
                 addVertex(pVertex, count);
                 m_queue.push(BuilderExtensionNode(pVertex, curr.direction));
                 num_added += 1;
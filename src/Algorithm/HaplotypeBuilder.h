@@ -59,6 +59,9 @@ class HaplotypeBuilder
         void setTerminals(const AnchorSequence& leftAnchor, const AnchorSequence& rightAnchor);
         void setIndex(const BWT* pBWT, const BWT* pRBWT);
 
+        // Use a single index of both strands of the reads (sga index --both-strands)
+        void setBothStrandsIndex(const BWT* pBWT);
+
         // Set the threshold of kmer occurrences to use it as an edge
         void setKmerParameters(size_t k, size_t t);
     
@@ -87,6 +90,7 @@ class HaplotypeBuilder
         //
         const BWT* m_pBWT;
         const BWT* m_pRevBWT;
+        bool m_bothStrands;
 
         StringGraph* m_pGraph;
         StrIntMap m_vertexCoverageMap;
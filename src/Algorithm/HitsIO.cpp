@@ -0,0 +1,195 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// HitsIO - Read and write the overlap blocks found
+// for each read in a binary .hits file.
+//
+#include "HitsIO.h"
+
+// Bits of the flags byte of a block
+static const uint8_t HITS_QUERYREV = 0x1;
+static const uint8_t HITS_TARGETREV = 0x2;
+static const uint8_t HITS_QUERYCOMP = 0x4;
+
+//
+static inline void putUnsigned(std::string& out, uint64_t v)
+{
+    while(v >= 0x80)
+    {
+        out.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+
+//
+static inline void putSigned(std::string& out, int64_t v)
+{
+    putUnsigned(out, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+//
+static inline void putInterval(std::string& out, const BWTInterval& interval)
+{
+    putSigned(out, interval.lower);
+    putSigned(out, interval.upper - interval.lower);
+}
+
+// The get functions return false if the value runs past pEnd
+static inline bool getUnsigned(const char*& p, const char* pEnd, uint64_t& v)
+{
+    v = 0;
+    for(int shift = 0; p < pEnd && shift < 64; shift += 7)
+    {
+        uint8_t c = *p++;
+        v |= (uint64_t)(c & 0x7F) << shift;
+        if((c & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+//
+static inline bool getSigned(const char*& p, const char* pEnd, int64_t& v)
+{
+    uint64_t u;
+    if(!getUnsigned(p, pEnd, u))
+        return false;
+    v = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+    return true;
+}
+
+//
+static inline bool getInterval(const char*& p, const char* pEnd, BWTInterval& interval)
+{
+    int64_t diff;
+    if(!getSigned(p, pEnd, interval.lower) || !getSigned(p, pEnd, diff))
+        return false;
+    interval.upper = interval.lower + diff;
+    return true;
+}
+
+//
+HitsWriter::HitsWriter(const std::string& filename)
+{
+    m_pWriter = createWriter(filename, std::ios::out | std::ios::binary);
+    m_pWriter->write((const char*)&HITS_FILE_MAGIC, sizeof(HITS_FILE_MAGIC));
+}
+
+//
+HitsWriter::~HitsWriter()
+{
+    delete m_pWriter;
+}
+
+//
+void HitsWriter::write(size_t readIdx, bool isSubstring, const OverlapBlockList* pList)
+{
+    m_buffer.clear();
+    putUnsigned(m_buffer, readIdx);
+    m_buffer.push_back(isSubstring ? 1 : 0);
+    putUnsigned(m_buffer, pList->size());
+
+    for(OverlapBlockList::const_iterator iter = pList->begin(); iter != pList->end(); ++iter)
+    {
+        putInterval(m_buffer, iter->ranges.interval[0]);
+        putInterval(m_buffer, iter->ranges.interval[1]);
+        putInterval(m_buffer, iter->rawRanges.interval[0]);
+        putInterval(m_buffer, iter->rawRanges.interval[1]);
+        putSigned(m_buffer, iter->overlapLen);
+        putSigned(m_buffer, iter->numDiff);
+
+        uint8_t flags = 0;
+        if(iter->flags.isQueryRev())
+            flags |= HITS_QUERYREV;
+        if(iter->flags.isTargetRev())
+            flags |= HITS_TARGETREV;
+        if(iter->flags.isQueryComp())
+            flags |= HITS_QUERYCOMP;
+        m_buffer.push_back(flags);
+    }
+
+    uint32_t length = m_buffer.size();
+    m_pWriter->write((const char*)&length, sizeof(length));
+    m_pWriter->write(m_buffer.data(), length);
+}
+
+//
+HitsReader::HitsReader(const std::string& filename) : m_filename(filename)
+{
+    m_pReader = createReader(filename, std::ios::in | std::ios::binary);
+
+    uint16_t magic = 0;
+    m_pReader->read((char*)&magic, sizeof(magic));
+    if(magic != HITS_FILE_MAGIC)
+    {
+        std::cerr << "Error: " << filename << " is not a hits file\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+//
+HitsReader::~HitsReader()
+{
+    delete m_pReader;
+}
+
+//
+bool HitsReader::read(size_t& readIdx, bool& isSubstring, OverlapBlockList& blocks)
+{
+    uint32_t length;
+    if(!m_pReader->read((char*)&length, sizeof(length)))
+        return false;
+
+    m_buffer.resize(length);
+    if(length > 0)
+        m_pReader->read(&m_buffer[0], length);
+
+    const char* p = m_buffer.data();
+    const char* pEnd = p + length;
+    uint64_t idx;
+    uint64_t numBlocks;
+    bool valid = (size_t)m_pReader->gcount() == length && getUnsigned(p, pEnd, idx) && p < pEnd;
+    if(valid)
+    {
+        isSubstring = *p++ != 0;
+        valid = getUnsigned(p, pEnd, numBlocks);
+    }
+
+    if(valid)
+    {
+        readIdx = idx;
+
+        // Reuse the nodes of the list
+        blocks.resize(numBlocks);
+        for(OverlapBlockList::iterator iter = blocks.begin(); valid && iter != blocks.end(); ++iter)
+        {
+            int64_t overlapLen;
+            int64_t numDiff;
+            valid = getInterval(p, pEnd, iter->ranges.interval[0]) &&
+                    getInterval(p, pEnd, iter->ranges.interval[1]) &&
+                    getInterval(p, pEnd, iter->rawRanges.interval[0]) &&
+                    getInterval(p, pEnd, iter->rawRanges.interval[1]) &&
+                    getSigned(p, pEnd, overlapLen) &&
+                    getSigned(p, pEnd, numDiff) &&
+                    p < pEnd;
+            if(!valid)
+                break;
+
+            uint8_t flags = *p++;
+            iter->overlapLen = overlapLen;
+            iter->numDiff = numDiff;
+            iter->flags = AlignFlags(flags & HITS_QUERYREV, flags & HITS_TARGETREV, flags & HITS_QUERYCOMP);
+            iter->isEliminated = false;
+        }
+    }
+
+    if(!valid || p != pEnd)
+    {
+        std::cerr << "Error: hits file " << m_filename << " is truncated or corrupt\n";
+        exit(EXIT_FAILURE);
+    }
+    return true;
+}
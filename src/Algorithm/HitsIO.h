@@ -0,0 +1,56 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// HitsIO - Read and write the overlap blocks found
+// for each read in a binary .hits file.
+//
+// The file starts with HITS_FILE_MAGIC and is followed by
+// one record per read. Each record is prefixed by its length
+// in bytes so it can be read with a single call and decoded
+// from memory. The record holds the read index, the substring
+// flag and the number of blocks, followed by the blocks.
+// Integers are stored as variable-length base-128 numbers,
+// signed values are zig-zag encoded first. The upper coordinate
+// of each interval is stored relative to the lower coordinate.
+//
+#ifndef HITSIO_H
+#define HITSIO_H
+
+#include "Util.h"
+#include "OverlapBlock.h"
+
+const uint16_t HITS_FILE_MAGIC = 0xB1B1;
+
+class HitsWriter
+{
+    public:
+        HitsWriter(const std::string& filename);
+        ~HitsWriter();
+
+        // Write the overlap blocks found for the read with index readIdx
+        void write(size_t readIdx, bool isSubstring, const OverlapBlockList* pList);
+
+    private:
+        std::ostream* m_pWriter;
+        std::string m_buffer;
+};
+
+class HitsReader
+{
+    public:
+        HitsReader(const std::string& filename);
+        ~HitsReader();
+
+        // Read the next record into blocks, replacing its contents.
+        // Returns false when the end of the file is reached.
+        bool read(size_t& readIdx, bool& isSubstring, OverlapBlockList& blocks);
+
+    private:
+        std::string m_filename;
+        std::istream* m_pReader;
+        std::string m_buffer;
+};
+
+#endif
@@ -195,6 +195,12 @@ void OverlapAlgorithm::writeResultASQG(std::ostream& writer, const SeqRecord& re
     record.write(writer);
 }
 
+//
+void OverlapAlgorithm::writeResultBSQG(BSQG::Writer& writer, const SeqRecord& read, const OverlapResult& result) const
+{
+    writer.addVertex(read.id, read.seq.toString(), result.isSubstring);
+}
+
 // Write overlap blocks out to a file
 void OverlapAlgorithm::writeOverlapBlocks(std::ostream& writer, size_t readIdx, bool isSubstring, const OverlapBlockList* pList) const
 {
@@ -15,6 +15,7 @@
 #include "SearchSeed.h"
 #include "BWTAlgorithms.h"
 #include "Util.h"
+#include "BSQG.h"
 
 enum OverlapMode
 {
@@ -61,6 +62,9 @@ class OverlapAlgorithm
         // Write the result of an overlap to an ASQG file
         void writeResultASQG(std::ostream& writer, const SeqRecord& read, const OverlapResult& result) const;
 
+        // Write the result of an overlap to a BSQG file
+        void writeResultBSQG(BSQG::Writer& writer, const SeqRecord& read, const OverlapResult& result) const;
+
         // Write all the overlap blocks pList to the filehandle
         void writeOverlapBlocks(std::ostream& writer, size_t readIdx, bool isSubstring, const OverlapBlockList* pList) const;
 
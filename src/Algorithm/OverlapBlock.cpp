@@ -10,6 +10,8 @@
 // 
 #include "OverlapBlock.h"
 #include "BWTAlgorithms.h"
+#include "ReadInfoTable.h"
+#include "SuffixArray.h"
 
 //#define DEBUG_RESOLVE 1
 
@@ -500,6 +502,56 @@ MultiOverlap blockListToMultiOverlap(const SeqRecord& record, OverlapBlockList&
     return out;
 }
 
+// Convert the overlap blocks found for the read with index readIdx into a vector of overlaps
+void convertBlocksToOverlaps(size_t readIdx,
+                             const OverlapBlockList& blocks,
+                             const ReadInfoTable* pQueryRIT, 
+                             const ReadInfoTable* pTargetRIT, 
+                             const SuffixArray* pFwdSAI, 
+                             const SuffixArray* pRevSAI, 
+                             bool bCheckIDs,
+                             size_t& sumBlockSize,
+                             OverlapVector& outVector,
+                             std::vector<size_t>* pOutTargetIdx)
+{
+    sumBlockSize = 0;
+    for(OverlapBlockList::const_iterator iter = blocks.begin(); iter != blocks.end(); ++iter)
+    {
+        const OverlapBlock& record = *iter;
+
+        // Iterate through the range and write the overlaps
+        for(int64_t j = record.ranges.interval[0].lower; j <= record.ranges.interval[0].upper; ++j)
+        {
+            sumBlockSize += 1;
+            const SuffixArray* pCurrSAI = (record.flags.isTargetRev()) ? pRevSAI : pFwdSAI;
+            const ReadInfo& queryInfo = pQueryRIT->getReadInfo(readIdx);
+
+            int64_t saIdx = j;
+
+            // The index of the second read is given as the position in the SuffixArray index
+            size_t targetIdx = pCurrSAI->get(saIdx).getID();
+            const ReadInfo& targetInfo = pTargetRIT->getReadInfo(targetIdx);
+
+            // Skip self alignments and non-canonical (where the query read has a lexo. higher name)
+            if(queryInfo.id != targetInfo.id)
+            {    
+                Overlap o = record.toOverlap(queryInfo.id, targetInfo.id, queryInfo.length, targetInfo.length);
+
+                // The alignment logic above has the potential to produce duplicate alignments
+                // To avoid this, we skip overlaps where the id of the first coord is lexo. lower than 
+                // the second or the match is a containment and the query is reversed (containments can be 
+                // output up to 4 times total).
+                if(bCheckIDs && (o.id[0] < o.id[1] || (o.match.isContainment() && record.flags.isQueryRev())))
+                    continue;
+
+                outVector.push_back(o);
+                if(pOutTargetIdx != NULL)
+                    pOutTargetIdx->push_back(targetIdx);
+            }
+        }
+    }
+}
+
 // make an id string from a read index
 std::string makeIdxString(int64_t idx)
 {
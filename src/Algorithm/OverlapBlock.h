@@ -19,6 +19,9 @@
 #include "GraphCommon.h"
 #include "MultiOverlap.h"
 
+class ReadInfoTable;
+class SuffixArray;
+
 // Flags indicating how a given read was aligned to the FM-index
 // Used for internal bookkeeping
 struct AlignFlags
@@ -213,6 +216,23 @@ void removeContainmentBlocks(int readLen, OverlapBlockList* pList);
 // Convert an overlap block list into a multiple overlap
 MultiOverlap blockListToMultiOverlap(const SeqRecord& record, OverlapBlockList& blockList);
 
+// Convert the overlap blocks found for the read with index readIdx into overlaps,
+// looking up the target reads in the lexicographic index of the (reverse) reads.
+// If bCheckIDs is set, only one of the duplicate overlaps found for a pair of reads is kept.
+// sumBlockSize is set to the total number of entries in the blocks.
+// If pOutTargetIdx is not NULL, the index of the target read of each
+// overlap is appended to it.
+void convertBlocksToOverlaps(size_t readIdx,
+                             const OverlapBlockList& blocks,
+                             const ReadInfoTable* pQueryRIT, 
+                             const ReadInfoTable* pTargetRIT, 
+                             const SuffixArray* pFwdSAI, 
+                             const SuffixArray* pRevSAI,
+                             bool bCheckIDs,
+                             size_t& sumBlockSize,
+                             OverlapVector& outVector,
+                             std::vector<size_t>* pOutTargetIdx = NULL);
+
 // 
 std::string makeIdxString(int64_t idx);
 
@@ -10,6 +10,9 @@
 #include "QCProcess.h"
 #include "BWTAlgorithms.h"
 
+// The maximum number of windows used to check the kmers of a read concurrently
+#define KMER_CHECK_MAX_LANES 8
+
 //
 struct KmerWindow
 {
@@ -31,6 +34,19 @@ struct KmerWindow
     bool isInitialized;
 };
 
+// A range of kmers [next, limit) of a read that is checked
+// with its own window
+struct KmerLane
+{
+    int next;
+    int limit;
+
+    // The next base to add to the window while it is being initialized,
+    // or -1 if the window is not being initialized
+    int initPos;
+    KmerWindow window;
+};
+
 //
 //
 //
@@ -95,6 +111,11 @@ bool QCProcess::performKmerCheck(const SequenceWorkItem& workItem)
     // to be recomputed. If the (k+1)-mer is seen less than m times, we recompute
     // kmer k_(i+1) as a final check. Using this optimistic algorithm (checking
     // longer kmers than is required) is significantly faster.
+    //
+    // Each step of the test depends on the previous step so a single window
+    // spends most of its time waiting on memory. To avoid this, the kmers of the
+    // read are split into lanes that are tested independently and the
+    // fm-index updates for all the lanes are issued as a batch.
     QCResult result;
 
     std::string w = workItem.read.seq.toString();
@@ -106,95 +127,150 @@ bool QCProcess::performKmerCheck(const SequenceWorkItem& workItem)
     int k = m_params.kmerLength;
     int n = w.size();
     int nk = n - k + 1;
-    int threshold = m_params.kmerThreshold;
 
-    // Are all kmers in the read well-represented?
-    bool allSolid = true;
+    // Each kmer is a single lookup in the precomputed table, if there is one.
+    // The table holds the sum of the counts on both strands.
+    if(m_params.pKmerTable != NULL && !m_params.kmerBothStrand)
+    {
+        for(int i = 0; i < nk; ++i)
+        {
+            if((int)m_params.pKmerTable->count(w.c_str() + i) <= m_params.kmerThreshold)
+                return false;
+        }
+        return true;
+    }
 
-    int i = 0;
+    // Each lane must span enough kmers to amortize the cost of initializing its window
+    int numLanes = std::max(1, std::min(KMER_CHECK_MAX_LANES, nk / k));
+    int span = (nk + numLanes - 1) / numLanes;
 
-    KmerWindow window;
-    window.start = 0;
-    window.end = 0;
-    window.isInitialized = false;
-    
-    while(i < nk)
+    KmerLane lanes[KMER_CHECK_MAX_LANES];
+    for(int l = 0; l < numLanes; ++l)
+    {
+        lanes[l].next = l * span;
+        lanes[l].limit = std::min(nk, (l + 1) * span);
+        lanes[l].initPos = -1;
+        lanes[l].window.start = 0;
+        lanes[l].window.end = 0;
+        lanes[l].window.isInitialized = false;
+    }
+
+    int laneIdx[KMER_CHECK_MAX_LANES];
+    BWTIntervalPair fwdPairs[KMER_CHECK_MAX_LANES];
+    BWTIntervalPair rcPairs[KMER_CHECK_MAX_LANES];
+    char fwdSymbols[KMER_CHECK_MAX_LANES];
+    char rcSymbols[KMER_CHECK_MAX_LANES];
+
+    while(true)
     {
-        // Determine whether the kmer at position i
-        // has been seen more than m times.
-        if(window.isInitialized)
+        // Advance each lane to the point where it needs the fm-index
+        int numActive = 0;
+        for(int l = 0; l < numLanes; ++l)
+        {
+            KmerLane& lane = lanes[l];
+            if(!settleKmerLane(lane, w))
+                return false;
+
+            if(lane.next >= lane.limit)
+                continue;
+
+            // Select the base to add to the window
+            char b = lane.window.isInitialized ? w[lane.window.end + k] : w[lane.initPos];
+            laneIdx[numActive] = l;
+            fwdPairs[numActive] = lane.window.fwdIntervals;
+            rcPairs[numActive] = lane.window.rcIntervals;
+            fwdSymbols[numActive] = b;
+            rcSymbols[numActive] = complement(b);
+            numActive += 1;
+        }
+
+        if(numActive == 0)
+            break;
+
+        // Update intervals rightwards
+        BWTAlgorithms::updateBothRBatch(fwdPairs, fwdSymbols, numActive, m_params.pRevBWT);
+        BWTAlgorithms::updateBothRBatch(rcPairs, rcSymbols, numActive, m_params.pBWT);
+
+        for(int a = 0; a < numActive; ++a)
         {
-            // Extend the current window by 1 base
-            // to see if the spanning larger
-            // kmer is seen more than m times.
-            // If so, we don't need to check this kmer
-            // individually
-            int next = window.end + k;
-            assert(next < (int)w.size());
-            char b = w[next];
-            char cb = complement(b);
-
-            if(window.fwdIntervals.interval[0].isValid())
-                BWTAlgorithms::updateBothR(window.fwdIntervals, b, m_params.pRevBWT);
-            if(window.rcIntervals.interval[1].isValid())
-                BWTAlgorithms::updateBothR(window.rcIntervals, cb, m_params.pBWT);
-
-            int64_t count = window.getCount(m_params.kmerBothStrand);
-            if(count <= threshold)
+            KmerLane& lane = lanes[laneIdx[a]];
+            lane.window.fwdIntervals = fwdPairs[a];
+            lane.window.rcIntervals = rcPairs[a];
+
+            if(!lane.window.isInitialized)
+            {
+                lane.initPos += 1;
+            }
+            else if(lane.window.getCount(m_params.kmerBothStrand) <= m_params.kmerThreshold)
             {
                 // The extended kmer didn't meet the threshold
                 // recompute the interval for this kmer
-                window.isInitialized = false;
+                lane.window.isInitialized = false;
             }
             else
             {
-                window.end += 1;
+                // The kmer is contained in a solid window
+                lane.window.end += 1;
+                lane.next += 1;
             }
         }
-        
-        if(!window.isInitialized)
+    }
+
+    return true;
+}
+
+// Perform the steps of the kmer check for a lane that do not need
+// the fm-index to be updated. Returns false if a kmer of the lane
+// is found to be below the threshold.
+bool QCProcess::settleKmerLane(KmerLane& lane, const std::string& w) const
+{
+    int k = m_params.kmerLength;
+    while(lane.next < lane.limit && !lane.window.isInitialized)
+    {
+        if(lane.initPos < 0)
         {
             // initialize the window by computing the
             // BWTIntervals for the kmer starting at
-            // i and its reverse complement
-            char b = w[i];
-            char cb = complement(b);
-            BWTAlgorithms::initIntervalPair(window.fwdIntervals, b, m_params.pBWT, m_params.pRevBWT);
-            BWTAlgorithms::initIntervalPair(window.rcIntervals, cb, m_params.pRevBWT, m_params.pBWT);
-
-            for(int j = i + 1; j < i + k; ++j)
+            // next and its reverse complement
+            int cacheLen = m_params.pCache != NULL ? m_params.pCache->getCachedLength() : 0;
+            std::string prefix = w.substr(lane.next, cacheLen);
+            if(cacheLen > 0 && cacheLen <= k && prefix.find_first_not_of("ACGT") == std::string::npos)
             {
-                // Update intervals rightwards 
-                b = w[j];
-                cb = complement(b);
-
-                if(window.fwdIntervals.interval[0].isValid())
-                    BWTAlgorithms::updateBothR(window.fwdIntervals, b, m_params.pRevBWT);
-                if(window.rcIntervals.interval[1].isValid())
-                    BWTAlgorithms::updateBothR(window.rcIntervals, cb, m_params.pBWT);
+                // Look up the intervals of the first bases of the kmer.
+                // The reverse complement pair is indexed by the reverse bwt
+                // first so the cached intervals are swapped.
+                lane.window.fwdIntervals = m_params.pCache->lookupPair(prefix.c_str());
+                BWTIntervalPair rc = m_params.pCache->lookupPair(reverseComplement(prefix).c_str());
+                lane.window.rcIntervals.interval[0] = rc.interval[1];
+                lane.window.rcIntervals.interval[1] = rc.interval[0];
+                lane.initPos = lane.next + cacheLen;
+            }
+            else
+            {
+                char b = w[lane.next];
+                char cb = complement(b);
+                BWTAlgorithms::initIntervalPair(lane.window.fwdIntervals, b, m_params.pBWT, m_params.pRevBWT);
+                BWTAlgorithms::initIntervalPair(lane.window.rcIntervals, cb, m_params.pRevBWT, m_params.pBWT);
+                lane.initPos = lane.next + 1;
             }
-
-            // record the start/end indices of the kmers spanned by this position
-            window.start = i;
-            window.end = i;
-            window.isInitialized = true;
         }
 
+        // The rest of the kmer is added by the batched updates
+        if(lane.initPos < lane.next + k)
+            return true;
+
+        // record the start/end indices of the kmers spanned by this position
+        lane.window.start = lane.next;
+        lane.window.end = lane.next;
+        lane.window.isInitialized = true;
+        lane.initPos = -1;
+
         // Check the count of this interval
-        int64_t count = window.getCount(m_params.kmerBothStrand);
-            
-        if(count <= threshold)
-        {
-            allSolid = false;
-            break;
-        }
-        else
-        {
-            i += 1;
-        }
+        if(lane.window.getCount(m_params.kmerBothStrand) <= m_params.kmerThreshold)
+            return false;
+        lane.next += 1;
     }
-
-    return allSolid;
+    return true;
 }
 
 // Perform duplicate check
@@ -207,8 +283,18 @@ DuplicateCheckResult QCProcess::performDuplicateCheck(const SequenceWorkItem& wo
     std::string rc_w = reverseComplement(w);
 
     // Look up the interval of the sequence and its reverse complement
-    BWTIntervalPair fwdIntervals = BWTAlgorithms::findIntervalPair(m_params.pBWT, m_params.pRevBWT, w);
-    BWTIntervalPair rcIntervals = BWTAlgorithms::findIntervalPair(m_params.pBWT, m_params.pRevBWT, rc_w);
+    BWTIntervalPair fwdIntervals;
+    BWTIntervalPair rcIntervals;
+    if(m_params.pCache != NULL)
+    {
+        fwdIntervals = BWTAlgorithms::findIntervalPairWithCache(m_params.pBWT, m_params.pRevBWT, m_params.pCache, w);
+        rcIntervals = BWTAlgorithms::findIntervalPairWithCache(m_params.pBWT, m_params.pRevBWT, m_params.pCache, rc_w);
+    }
+    else
+    {
+        fwdIntervals = BWTAlgorithms::findIntervalPair(m_params.pBWT, m_params.pRevBWT, w);
+        rcIntervals = BWTAlgorithms::findIntervalPair(m_params.pBWT, m_params.pRevBWT, rc_w);
+    }
 
     // Check if this read is a substring of any other
     // This is indicated by the presence of a non-$ extension in the left or right direction
@@ -12,10 +12,14 @@
 
 #include "Util.h"
 #include "BWT.h"
+#include "BWTIntervalCache.h"
+#include "KmerCountTable.h"
 #include "SequenceProcessFramework.h"
 #include "SequenceWorkItem.h"
 #include "BitVector.h"
 
+struct KmerLane;
+
 // Parameters
 struct QCParameters
 {
@@ -33,6 +37,8 @@ struct QCParameters
 
         pBWT = NULL;
         pRevBWT = NULL;
+        pCache = NULL;
+        pKmerTable = NULL;
         pSharedBV = NULL;
 
         kmerLength = 27;
@@ -49,8 +55,13 @@ struct QCParameters
 
     const BWT* pBWT;
     const BWT* pRevBWT;
+    const BWTIntervalCache* pCache;
     BitVector* pSharedBV;
 
+    // Precomputed counts of the kmers, or NULL. If set, the
+    // kmer check reads the counts from the table.
+    const KmerCountTable* pKmerTable;
+
     // Control parameters
     bool checkDuplicates;
     bool checkKmer;
@@ -130,6 +141,7 @@ class QCProcess
         
         // Discard reads with low-frequency kmers
         bool performKmerCheck(const SequenceWorkItem& item);
+        bool settleKmerLane(KmerLane& lane, const std::string& w) const;
 
         // Discard reads that are identical to, or a substring of, some other read
         DuplicateCheckResult performDuplicateCheck(const SequenceWorkItem& item);
@@ -10,22 +10,22 @@
 #include <ostream>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
 #include "Bigraph.h"
 #include "Timer.h"
 #include "ASQG.h"
+#include "BSQG.h"
 
 //
 //
 //
-Bigraph::Bigraph() : m_hasContainment(false), m_hasTransitive(false), m_isExactMode(false), m_minOverlap(0), m_errorRate(0.0f)
+Bigraph::Bigraph() : m_numVertices(0), m_isFrozen(false), m_hasContainment(false), m_hasTransitive(false), m_isExactMode(false), m_minOverlap(0), m_errorRate(0.0f)
 {
     // Set up the memory pools for the graph
     m_pEdgeAllocator = new SimpleAllocator<Edge>();
     m_pVertexAllocator = new SimpleAllocator<Vertex>();
 
-    m_vertices.set_deleted_key("");
-    //WARN_ONCE("HARDCODED HASH TABLE MAX SIZE");
-    //m_vertices.resize(600000000);
+    m_nameMap.set_deleted_key(NULL);
 }
 
 //
@@ -33,11 +33,10 @@ Bigraph::Bigraph() : m_hasContainment(false), m_hasTransitive(false), m_isExactM
 //
 Bigraph::~Bigraph()
 {
-    VertexPtrMap::iterator iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
-        delete iter->second;
-        iter->second = NULL;
+        delete m_vertexArray[i];
+        m_vertexArray[i] = NULL;
     }
 
     // Clean up the memory pools
@@ -45,20 +44,52 @@ Bigraph::~Bigraph()
     delete m_pVertexAllocator;
 }
 
+//
+// Allocate a vertex with its name in the string table
+//
+Vertex* Bigraph::createVertex(const VertexID& id, const std::string& seq)
+{
+    return new(m_pVertexAllocator) Vertex(m_names.add(id), seq);
+}
+
 //
 // Add a vertex
 //
 void Bigraph::addVertex(Vertex* pVert)
 {
-    std::pair<VertexPtrMapIter, bool> result = 
-           m_vertices.insert(std::make_pair(pVert->getID(), pVert));
-    if(!result.second)
+    if(m_nameMap.find(pVert->getName()) != m_nameMap.end())
     {
         std::cerr << "Error: Attempted to insert vertex into graph with a duplicate id: " <<
                      pVert->getID() << "\n";
         std::cerr << "All reads must have a unique identifier\n";
         exit(1);
     }
+
+    if(m_vertexArray.size() >= INVALID_VERTEX_INDEX)
+    {
+        std::cerr << "Error: the graph has too many vertices\n";
+        exit(1);
+    }
+
+    thaw();
+    pVert->m_index = m_vertexArray.size();
+    m_vertexArray.push_back(pVert);
+    m_nameMap.insert(std::make_pair(pVert->getName(), pVert->m_index));
+    ++m_numVertices;
+    m_stats.add(pVert);
+}
+
+//
+// Remove a vertex from the collection. The name of the vertex
+// stays in the string table until the graph is renamed or destroyed.
+//
+void Bigraph::eraseVertex(Vertex* pVertex)
+{
+    assert(m_vertexArray[pVertex->getIndex()] == pVertex);
+    thaw();
+    m_nameMap.erase(pVertex->getName());
+    m_vertexArray[pVertex->getIndex()] = NULL;
+    --m_numVertices;
 }
 
 //
@@ -69,9 +100,9 @@ void Bigraph::removeIslandVertex(Vertex* pVertex)
     assert(pVertex->countEdges() == 0);
 
     // Remove the vertex from the collection
-    VertexID id = pVertex->getID();
+    m_stats.remove(pVertex);
+    eraseVertex(pVertex);
     delete pVertex;
-    m_vertices.erase(id);
 }
 
 //
@@ -80,22 +111,58 @@ void Bigraph::removeIslandVertex(Vertex* pVertex)
 void Bigraph::removeConnectedVertex(Vertex* pVertex)
 {
     // Remove the edges pointing to this Vertex
-    pVertex->deleteEdges();
+    deleteEdges(pVertex);
 
     // Remove the vertex from the collection
-    VertexID id = pVertex->getID();
-    delete pVertex;
-    m_vertices.erase(id);
+    removeIslandVertex(pVertex);
+}
+
+
+//
+// Build the compact view of the edges if it is not current
+//
+const CompactAdjacency& Bigraph::freeze() const
+{
+    if(!m_isFrozen)
+    {
+        m_adjacency.build(m_vertexArray);
+        setVertexFrozen(true);
+        m_isFrozen = true;
+    }
+    return m_adjacency;
 }
 
+//
+// Drop the compact view before the edges are changed
+//
+void Bigraph::thaw()
+{
+    if(m_isFrozen)
+    {
+        m_adjacency.clear();
+        setVertexFrozen(false);
+        m_isFrozen = false;
+    }
+}
+
+//
+// Mark the vertices so that changes to their edges are caught
+//
+void Bigraph::setVertexFrozen(bool b) const
+{
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
+    {
+        if(m_vertexArray[i] != NULL)
+            m_vertexArray[i]->m_isFrozen = b;
+    }
+}
 
 //
 // Check for the existance of a vertex
 //
 bool Bigraph::hasVertex(VertexID id)
 {
-    VertexPtrMapIter iter = m_vertices.find(id);
-    return iter != m_vertices.end();
+    return m_nameMap.find(id.c_str()) != m_nameMap.end();
 }
 
 //
@@ -103,10 +170,10 @@ bool Bigraph::hasVertex(VertexID id)
 //
 Vertex* Bigraph::getVertex(VertexID id) const
 {
-    VertexPtrMapConstIter iter = m_vertices.find(id);
-    if(iter == m_vertices.end())
+    VertexNameMap::const_iterator iter = m_nameMap.find(id.c_str());
+    if(iter == m_nameMap.end())
         return NULL;
-    return iter->second;
+    return m_vertexArray[iter->second];
 }
 
 //
@@ -115,7 +182,10 @@ Vertex* Bigraph::getVertex(VertexID id) const
 void Bigraph::addEdge(Vertex* pVertex, Edge* pEdge)
 {
     assert(pEdge->getStart() == pVertex);
+    thaw();
+    m_stats.remove(pVertex);
     pVertex->addEdge(pEdge);
+    m_stats.add(pVertex);
 }
 
 //
@@ -123,7 +193,43 @@ void Bigraph::addEdge(Vertex* pVertex, Edge* pEdge)
 //
 void Bigraph::removeEdge(const EdgeDesc& ed)
 {
+    thaw();
+    m_stats.remove(ed.pVertex);
     ed.pVertex->removeEdge(ed);
+    m_stats.add(ed.pVertex);
+}
+
+//
+// Delete an edge, but not its twin
+//
+void Bigraph::deleteEdge(Vertex* pVertex, Edge* pEdge)
+{
+    thaw();
+    m_stats.remove(pVertex);
+    pVertex->deleteEdge(pEdge);
+    m_stats.add(pVertex);
+}
+
+//
+// Delete the edges of a vertex and their twins
+//
+void Bigraph::deleteEdges(Vertex* pVertex)
+{
+    thaw();
+
+    // The vertex and every vertex it is connected to lose edges
+    VertexPtrVec affected(1, pVertex);
+    EdgePtrVec edges = pVertex->getEdges();
+    for(EdgePtrVecIter iter = edges.begin(); iter != edges.end(); ++iter)
+        affected.push_back((*iter)->getEnd());
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+    for(size_t i = 0; i < affected.size(); ++i)
+        m_stats.remove(affected[i]);
+    pVertex->deleteEdges();
+    for(size_t i = 0; i < affected.size(); ++i)
+        m_stats.add(affected[i]);
 }
 
 //
@@ -160,11 +266,18 @@ void Bigraph::mergeVertices(VertexID id1, VertexID id2)
 //
 void Bigraph::merge(Vertex* pV1, Edge* pEdge)
 {
-    Vertex* pV2 = pEdge->getEnd();
-    //std::cout << "Merging " << pV1->getID() << " with " << pV2->getID() << "\n";
+    thaw();
+    //std::cout << "Merging " << pV1->getID() << " with " << pEdge->getEndID() << "\n";
 
     // Merge the data
     pV1->merge(pEdge);
+    spliceMergedVertex(pV1, pEdge);
+}
+
+//
+void Bigraph::spliceMergedVertex(Vertex* pV1, Edge* pEdge)
+{
+    Vertex* pV2 = pEdge->getEnd();
 
     // Get the twin edge (the edge in v2 that points to v1)
     Edge* pTwin = pEdge->getTwin();
@@ -172,6 +285,11 @@ void Bigraph::merge(Vertex* pV1, Edge* pEdge)
     // Ensure v2 has the twin edge
     assert(pV2->hasEdge(pTwin));
 
+    // The vertices at the other ends of the moved edges keep the
+    // same number of edges so only v1 and v2 change
+    m_stats.remove(pV1);
+    m_stats.remove(pV2);
+
     // Get the edge set opposite of the twin edge (which will be the new edges in this direction for V1)
     EdgePtrVec transEdges = pV2->getEdges(!pTwin->getDir());
 
@@ -205,6 +323,9 @@ void Bigraph::merge(Vertex* pV1, Edge* pEdge)
     delete pTwin;
     pEdge = 0;
 
+    m_stats.add(pV1);
+    m_stats.add(pV2);
+
     // Remove V2
     // It is guarenteed to not be connected
     removeIslandVertex(pV2);
@@ -215,18 +336,18 @@ void Bigraph::merge(Vertex* pV1, Edge* pEdge)
 int Bigraph::sweepVertices(GraphColor c)
 {
     int numRemoved = 0;
-    VertexPtrMapIter iter = m_vertices.begin();
-    while(iter != m_vertices.end())
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
-        VertexPtrMapIter next = iter;
-        ++next;
-        if(iter->second->getColor() == c)
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex != NULL && pVertex->getColor() == c)
         {
-            removeConnectedVertex(iter->second); 
+            removeConnectedVertex(pVertex); 
             ++numRemoved;
         }
-        iter = next;
     }
+
+    if(numRemoved > 0)
+        releaseMemory();
     return numRemoved;
 }
 
@@ -234,18 +355,184 @@ int Bigraph::sweepVertices(GraphColor c)
 //
 int Bigraph::sweepEdges(GraphColor c)
 {
+    thaw();
     int numRemoved = 0;
-    for(VertexPtrMapIter iter = m_vertices.begin(); iter != m_vertices.end(); ++iter)
-        numRemoved += iter->second->sweepEdges(c);
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
+    {
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
+        m_stats.remove(pVertex);
+        numRemoved += pVertex->sweepEdges(c);
+        m_stats.add(pVertex);
+    }
+
+    if(numRemoved > 0)
+        releaseMemory();
     return numRemoved;
 }
 
+//
+void Bigraph::releaseMemory()
+{
+    m_pVertexAllocator->releaseEmptyPools();
+    m_pEdgeAllocator->releaseEmptyPools();
+}
+
 //    Simplify the graph by compacting singular edges
-void Bigraph::simplify()
+void Bigraph::simplify(int numThreads)
 {
     assert(!hasContainment());
+    compactChains(numThreads);
+
+    // Compact anything that is left, such as cycles, one vertex at a time
     simplify(ED_SENSE);
     simplify(ED_ANTISENSE);
+    releaseMemory();
+}
+
+// A chain of vertices joined by edges that are the only edge
+// of both of their endpoints in their direction. The edges lead
+// from the start vertex to the other end of the chain in order.
+struct VertexChain
+{
+    VertexIndex start;
+    size_t startLength;
+    EdgePtrVec edges;
+};
+
+//
+void Bigraph::compactChains(int numThreads)
+{
+    const CompactAdjacency& adjacency = freeze();
+    long numSlots = m_vertexArray.size();
+
+    // The edge that links each vertex to the next vertex of a chain
+    // in each direction, if any. Slot 2 * idx + dir holds the link of 
+    // vertex idx in direction dir.
+    std::vector<const CompactEdge*> links(2 * numSlots, (const CompactEdge*)NULL);
+
+    #pragma omp parallel for schedule(dynamic, 1024) num_threads(numThreads)
+    for(long i = 0; i < numSlots; ++i)
+    {
+        const CompactEdge* single[ED_COUNT] = { NULL, NULL };
+        size_t count[ED_COUNT] = { 0, 0 };
+        for(CompactAdjacency::const_iterator iter = adjacency.begin(i); iter != adjacency.end(i); ++iter)
+        {
+            single[iter->getDir()] = iter;
+            count[iter->getDir()] += 1;
+        }
+
+        // Don't merge singular self edges
+        for(size_t d = 0; d < ED_COUNT; ++d)
+        {
+            const CompactEdge* pLink = single[d];
+            if(count[d] == 1 && pLink->end != (VertexIndex)i && adjacency.countEdges(pLink->end, pLink->getTwinDir()) == 1)
+                links[2 * i + d] = pLink;
+        }
+    }
+
+    // Vertices with a link in only one direction are the ends of the chains.
+    // Each chain is compacted into the end with the lower index.
+    std::vector<uint8_t> isStart(numSlots, 0);
+
+    #pragma omp parallel for schedule(dynamic, 1024) num_threads(numThreads)
+    for(long i = 0; i < numSlots; ++i)
+    {
+        const CompactEdge* pLink = links[2 * i + ED_SENSE];
+        if((pLink == NULL) == (links[2 * i + ED_ANTISENSE] == NULL))
+            continue;
+        if(pLink == NULL)
+            pLink = links[2 * i + ED_ANTISENSE];
+
+        VertexIndex end = i;
+        while(pLink != NULL)
+        {
+            end = pLink->end;
+            pLink = links[2 * end + !pLink->getTwinDir()];
+        }
+        isStart[i] = (VertexIndex)i < end;
+    }
+
+    std::vector<VertexChain> chains;
+    for(long i = 0; i < numSlots; ++i)
+    {
+        if(isStart[i])
+        {
+            chains.push_back(VertexChain());
+            chains.back().start = i;
+        }
+    }
+    std::vector<uint8_t>().swap(isStart);
+
+    // Collect the edges of each chain and set the sequence of the start vertex
+    // to the sequence of the whole chain. The sequence of each vertex is
+    // extended by the label of the edge to it, which is oriented by the
+    // product of the edge orientations from the start.
+    #pragma omp parallel for schedule(dynamic, 64) num_threads(numThreads)
+    for(long k = 0; k < (long)chains.size(); ++k)
+    {
+        VertexChain& chain = chains[k];
+        Vertex* pStart = m_vertexArray[chain.start];
+        chain.startLength = pStart->getSeqLen();
+
+        const CompactEdge* pLink = links[2 * chain.start + ED_SENSE];
+        if(pLink == NULL)
+            pLink = links[2 * chain.start + ED_ANTISENSE];
+        bool prepend = pLink->getDir() == ED_ANTISENSE;
+
+        size_t length = chain.startLength;
+        while(pLink != NULL)
+        {
+            chain.edges.push_back(pLink->pEdge);
+            length += pLink->pEdge->getSeqLen();
+            pLink = links[2 * pLink->end + !pLink->getTwinDir()];
+        }
+
+        std::string sequence(length, 'N');
+        size_t pos = prepend ? length - chain.startLength : 0;
+        sequence.replace(pos, chain.startLength, pStart->getStr());
+        pos = prepend ? pos : pos + chain.startLength;
+
+        EdgeComp comp = EC_SAME;
+        for(size_t j = 0; j < chain.edges.size(); ++j)
+        {
+            Edge* pEdge = chain.edges[j];
+            if(pEdge->getComp() == EC_REVERSE)
+                comp = !comp;
+
+            std::string label = pEdge->getTwin()->getMatchCoord().getComplementString(pEdge->getEnd()->getStr());
+            if(comp == EC_REVERSE)
+                label = reverseComplement(label);
+
+            if(prepend)
+                pos -= label.size();
+            sequence.replace(pos, label.size(), label);
+            if(!prepend)
+                pos += label.size();
+        }
+        assert(pos == (prepend ? 0 : length));
+        pStart->setSeq(sequence);
+    }
+    std::vector<const CompactEdge*>().swap(links);
+
+    // Move the edges of the chains to the start vertices
+    thaw();
+    for(size_t k = 0; k < chains.size(); ++k)
+    {
+        const VertexChain& chain = chains[k];
+        Vertex* pStart = m_vertexArray[chain.start];
+        size_t length = chain.startLength;
+        for(size_t j = 0; j < chain.edges.size(); ++j)
+        {
+            Edge* pEdge = chain.edges[j];
+            length += pEdge->getSeqLen();
+            pStart->mergeDeferred(pEdge, length);
+            spliceMergedVertex(pStart, pEdge);
+        }
+        assert(length == pStart->getSeqLen());
+    }
 }
 
 // Simplify the graph by compacting edges in the given direction
@@ -255,11 +542,14 @@ void Bigraph::simplify(EdgeDir dir)
     while(graph_changed)
     {
         graph_changed = false;
-        VertexPtrMapIter iter = m_vertices.begin(); 
-        while(iter != m_vertices.end())
+        for(size_t i = 0; i < m_vertexArray.size(); ++i)
         {
+            Vertex* pVertex = m_vertexArray[i];
+            if(pVertex == NULL)
+                continue;
+
             // Get the edges for this direction
-            EdgePtrVec edges = iter->second->getEdges(dir);
+            EdgePtrVec edges = pVertex->getEdges(dir);
 
             // If there is a single edge in this direction, merge the vertices
             // Don't merge singular self edges though
@@ -271,12 +561,10 @@ void Bigraph::simplify(EdgeDir dir)
                 Vertex* pV2 = pSingle->getEnd();
                 if(pV2->countEdges(pTwin->getDir()) == 1)
                 {
-                    merge(iter->second, pSingle);
+                    merge(pVertex, pSingle);
                     graph_changed = true;
                 }
             }
-
-            ++iter;
         }
     } 
 }
@@ -292,26 +580,32 @@ void Bigraph::simplify(EdgeDir dir)
 void Bigraph::renameVertices(const std::string& prefix)
 {
     size_t currIdx = 0;
-    size_t numVertices = m_vertices.size();
-    std::vector<Vertex*> vertexPtrVec(numVertices, 0);
+    std::vector<Vertex*> vertexPtrVec(m_numVertices, 0);
 
-    VertexPtrMapIter iter = m_vertices.begin();
-    while(iter != m_vertices.end())
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
-        std::stringstream ss;
-        ss << prefix << currIdx;
-        iter->second->setID(ss.str());
-        vertexPtrVec[currIdx] = iter->second;
-        ++iter;
-        ++currIdx;
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+        vertexPtrVec[currIdx++] = pVertex;
     }
 
-    // Clear the old graph
-    m_vertices.clear();
+    // Clear the old graph. This also drops the old names, including
+    // the names of removed vertices, and the slots of removed vertices.
+    m_nameMap.clear();
+    m_vertexArray.clear();
+    m_names.clear();
+    m_numVertices = 0;
+    m_stats = GraphStats();
     
-    // Re-add the vertices
-    for(size_t i = 0; i < numVertices; ++i)
+    // Re-add the vertices under their new names
+    for(size_t i = 0; i < vertexPtrVec.size(); ++i)
+    {
+        std::stringstream ss;
+        ss << prefix << i;
+        vertexPtrVec[i]->m_pName = m_names.add(ss.str());
         addVertex(vertexPtrVec[i]);
+    }
 }
 
 //
@@ -319,9 +613,13 @@ void Bigraph::renameVertices(const std::string& prefix)
 //
 void Bigraph::sortVertexAdjListsByLen()
 {
-    VertexPtrMapIter iter = m_vertices.begin();
-    for(; iter != m_vertices.end(); ++iter)
-        iter->second->sortAdjListByLen();
+    thaw();
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
+    {
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex != NULL)
+            pVertex->sortAdjListByLen();
+    }
 }
 
 
@@ -330,9 +628,13 @@ void Bigraph::sortVertexAdjListsByLen()
 //
 void Bigraph::sortVertexAdjListsByID()
 {
-    VertexPtrMapIter iter = m_vertices.begin();
-    for(; iter != m_vertices.end(); ++iter)
-        iter->second->sortAdjListByID();
+    thaw();
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
+    {
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex != NULL)
+            pVertex->sortAdjListByID();
+    }
 }
 
 //
@@ -340,13 +642,83 @@ void Bigraph::sortVertexAdjListsByID()
 //
 void Bigraph::validate()
 {
-    VertexPtrMapIter iter = m_vertices.begin();
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
+    {
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
+        pVertex->validate();
+    }
+
+    GraphStats stats = computeStats();
+    if(stats != m_stats)
     {
-        iter->second->validate();
+        std::cerr << "Error, the maintained graph statistics do not match the graph\n";
+        fprintf(stderr, "Maintained: ");
+        m_stats.print(stderr);
+        fprintf(stderr, "Counted: ");
+        stats.print(stderr);
+        assert(false);
     }
 }
 
+//
+GraphStats Bigraph::computeStats() const
+{
+    GraphStats stats;
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
+    {
+        if(m_vertexArray[i] != NULL)
+            stats.add(m_vertexArray[i]);
+    }
+    return stats;
+}
+
+//
+void GraphStats::update(const Vertex* pVertex, bool isAdd)
+{
+    size_t s_count = pVertex->countEdges(ED_SENSE);
+    size_t as_count = pVertex->countEdges(ED_ANTISENSE);
+
+    // The counters are unsigned so removing a vertex relies on
+    // the wrap around of adding (size_t)-1
+    size_t delta = isAdd ? 1 : -1;
+
+    numVertices += delta;
+    numEdges += delta * (s_count + as_count);
+
+    if(s_count == 0 && as_count == 0)
+        numIslands += delta;
+    else if(s_count == 0 || as_count == 0)
+        numTips += delta;
+
+    if(s_count > 1 && as_count > 1)
+        numDibranch += delta;
+    else if(s_count > 1 || as_count > 1)
+        numMonobranch += delta;
+
+    if(s_count == 1 || as_count == 1)
+        numSimple += delta;
+}
+
+//
+bool GraphStats::operator==(const GraphStats& other) const
+{
+    return numVertices == other.numVertices && numEdges == other.numEdges &&
+           numIslands == other.numIslands && numTips == other.numTips &&
+           numMonobranch == other.numMonobranch && numDibranch == other.numDibranch &&
+           numSimple == other.numSimple;
+}
+
+//
+void GraphStats::print(FILE* pFile) const
+{
+    fprintf(pFile, "Vertices: %zu Edges: %zu Islands: %zu Tips: %zu Monobranch: %zu Dibranch: %zu Simple: %zu\n", numVertices, numEdges,
+                                                                                                                  numIslands, numTips,
+                                                                                                                  numMonobranch, numDibranch, numSimple);
+}
+
 //
 // Flip a vertex
 //
@@ -384,14 +756,17 @@ void Bigraph::flip(VertexID /*id*/)
 VertexIDVec Bigraph::getNonBranchingVertices() const
 {
     VertexIDVec out;
-    VertexPtrMapConstIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
-        int senseEdges = iter->second->countEdges(ED_SENSE);
-        int antisenseEdges = iter->second->countEdges(ED_ANTISENSE);
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
+        int senseEdges = pVertex->countEdges(ED_SENSE);
+        int antisenseEdges = pVertex->countEdges(ED_ANTISENSE);
         if(antisenseEdges <= 1 && senseEdges <= 1)
         {
-            out.push_back(iter->second->getID());
+            out.push_back(pVertex->getID());
         }
     }
     return out;
@@ -406,13 +781,16 @@ PathVector Bigraph::getLinearComponents()
 {
     PathVector outPaths;
     setColors(GC_WHITE);
-    VertexPtrMapIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
         // Output the linear path containing this vertex if it hasnt been visited already
-        if(iter->second->getColor() != GC_BLACK)
+        if(pVertex->getColor() != GC_BLACK)
         {
-            outPaths.push_back(constructLinearPath(iter->second->getID()));
+            outPaths.push_back(constructLinearPath(pVertex->getID()));
         }
     }
     assert(checkColors(GC_BLACK));
@@ -473,19 +851,24 @@ Path Bigraph::reversePath(const Path& path)
 //
 Vertex* Bigraph::getFirstVertex() const
 {
-    if(m_vertices.empty())
-        return NULL;
-    else
-        return m_vertices.begin()->second;
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
+    {
+        if(m_vertexArray[i] != NULL)
+            return m_vertexArray[i];
+    }
+    return NULL;
 }
 
 // Returns a vector of pointers to the vertices
 VertexPtrVec Bigraph::getAllVertices() const
 {
     VertexPtrVec out;
-    VertexPtrMapConstIter iter = m_vertices.begin();
-    for(; iter != m_vertices.end(); ++iter)
-        out.push_back(iter->second);
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
+    {
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex != NULL)
+            out.push_back(pVertex);
+    }
     return out;
 }
 
@@ -493,9 +876,12 @@ VertexPtrVec Bigraph::getAllVertices() const
 // Append vertex sequences to the vector
 void Bigraph::getVertexSequences(std::vector<std::string>& outSequences) const
 {
-    VertexPtrMapConstIter iter = m_vertices.begin();
-    for(; iter != m_vertices.end(); ++iter)
-        outSequences.push_back(iter->second->getSeq().toString());
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
+    {
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex != NULL)
+            outSequences.push_back(pVertex->getSeq().toString());
+    }
 }
 
 
@@ -505,11 +891,15 @@ void Bigraph::getVertexSequences(std::vector<std::string>& outSequences) const
 //
 bool Bigraph::visit(VertexVisitFunction f)
 {
+    thaw();
     bool modified = false;
-    VertexPtrMapConstIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
-        modified = f(this, iter->second) || modified;
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
+        modified = f(this, pVertex) || modified;
     }
     return modified;
 }
@@ -519,11 +909,14 @@ bool Bigraph::visit(VertexVisitFunction f)
 //
 void Bigraph::setColors(GraphColor c)
 {
-    VertexPtrMapIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
-        iter->second->setColor(c);
-        iter->second->setEdgeColors(c);
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
+        pVertex->setColor(c);
+        pVertex->setEdgeColors(c);
     }
 }
 
@@ -602,12 +995,15 @@ double Bigraph::getErrorRate() const
 //
 bool Bigraph::checkColors(GraphColor c)
 {
-    VertexPtrMapIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
-        if(iter->second->getColor() != c)
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
+        if(pVertex->getColor() != c)
         {
-            std::cerr << "Warning vertex " << iter->second->getID() << " is color " << iter->second->getColor() << " expected " << c << "\n";
+            std::cerr << "Warning vertex " << pVertex->getID() << " is color " << pVertex->getColor() << " expected " << c << "\n";
             return false;
         }
     }
@@ -622,10 +1018,13 @@ void Bigraph::stats() const
     int numVerts = 0;
     int numEdges = 0;
 
-    VertexPtrMapConstIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
-        numEdges += iter->second->countEdges();
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
+        numEdges += pVertex->countEdges();
         ++numVerts;
     }
 
@@ -637,7 +1036,7 @@ void Bigraph::stats() const
 //
 size_t Bigraph::getNumVertices() const
 {
-    return m_vertices.size();
+    return m_numVertices;
 }
 
 //
@@ -651,13 +1050,16 @@ void Bigraph::printMemSize() const
     size_t numEdges = 0;
     size_t edgeMem = 0;
 
-    VertexPtrMapConstIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
         ++numVerts;
-        vertMem += iter->second->getMemSize();
+        vertMem += pVertex->getMemSize();
 
-        EdgePtrVec edges = iter->second->getEdges();
+        EdgePtrVec edges = pVertex->getEdges();
         for(EdgePtrVecIter edgeIter = edges.begin(); edgeIter != edges.end(); ++edgeIter)
         {
             ++numEdges;
@@ -666,7 +1068,23 @@ void Bigraph::printMemSize() const
     }
     printf("num verts: %zu using %zu bytes (%.2lf per vert)\n", numVerts, vertMem, double(vertMem) / numVerts);
     printf("num edges: %zu using %zu bytes (%.2lf per edge)\n", numEdges, edgeMem, double(edgeMem) / numEdges);
-    printf("total: %zu\n", edgeMem + vertMem);
+
+    // The vertex array and the names, not including the name map
+    size_t indexMem = m_vertexArray.capacity() * sizeof(Vertex*) + m_names.getMemSize();
+    printf("vertex index: %zu bytes\n", indexMem);
+
+    size_t adjacencyMem = m_isFrozen ? m_adjacency.getMemSize() : 0;
+    if(m_isFrozen)
+        printf("compact adjacency: %zu bytes\n", adjacencyMem);
+    printf("total: %zu\n", edgeMem + vertMem + indexMem + adjacencyMem);
+
+    // Garbage in the memory pools is reported separately as it is not part of the live graph
+    printf("vertex pool: %zu bytes reserved, %zu live, %zu free, %zu reclaimed\n",
+           m_pVertexAllocator->getReservedBytes(), m_pVertexAllocator->getLiveBytes(),
+           m_pVertexAllocator->getFreeBytes(), m_pVertexAllocator->getReclaimedBytes());
+    printf("edge pool: %zu bytes reserved, %zu live, %zu free, %zu reclaimed\n",
+           m_pEdgeAllocator->getReservedBytes(), m_pEdgeAllocator->getLiveBytes(),
+           m_pEdgeAllocator->getFreeBytes(), m_pEdgeAllocator->getReclaimedBytes());
 }
 
 //
@@ -679,17 +1097,20 @@ void Bigraph::writeDot(const std::string& filename, int dotFlags) const
     std::string graphType = (dotFlags & DF_UNDIRECTED) ? "graph" : "digraph";
 
     out << graphType << " G\n{\n";
-    VertexPtrMapConstIter iter = m_vertices.begin(); 
-    for(; iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
-        VertexID id = iter->second->getID();
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
+        VertexID id = pVertex->getID();
         std::string label = (dotFlags & DF_NOID) ? "" : id;
         
         out << "\"" << id << "\" [ label=\"" << label << "\" ";
         if(dotFlags & DF_COLORED)
-            out << " style=\"filled\" fillcolor=\"" << getColorString(iter->second->getColor()) << "\" ";
+            out << " style=\"filled\" fillcolor=\"" << getColorString(pVertex->getColor()) << "\" ";
         out << "];\n";
-        iter->second->writeEdges(out, dotFlags);
+        pVertex->writeEdges(out, dotFlags);
     }
     out << "}\n";
     out.close();
@@ -711,20 +1132,26 @@ void Bigraph::writeASQG(const std::string& filename) const
     headerRecord.write(*pWriter);
 
 
-    VertexPtrMapConstIter iter; 
-
     // Vertices
-    for(iter = m_vertices.begin(); iter != m_vertices.end(); ++iter)
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
-        ASQG::VertexRecord vertexRecord(iter->second->getID(), iter->second->getSeq().toString());
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
+        ASQG::VertexRecord vertexRecord(pVertex->getID(), pVertex->getSeq().toString());
         vertexRecord.write(*pWriter);
     }
 
-    // Edges
-    for(iter = m_vertices.begin(); iter != m_vertices.end(); ++iter)
+    // Edges. The adjacency lists are read in place rather than through
+    // the compact view so writing the graph does not build it.
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
     {
-        EdgePtrVec edges = iter->second->getEdges();
-        for(EdgePtrVecIter edgeIter = edges.begin(); edgeIter != edges.end(); ++edgeIter)
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
+        for(EdgePtrVecConstIter edgeIter = pVertex->m_edges.begin(); edgeIter != pVertex->m_edges.end(); ++edgeIter)
         {
             // We write one record for every bidirectional edge so only write edges
             // that are in canonical form (where id1 < id2)
@@ -733,7 +1160,7 @@ void Bigraph::writeASQG(const std::string& filename) const
             {
                 // Containment edges are in both directions so only output one
                 // record if it is a containment
-                if(!ovr.isContainment() || ((*edgeIter)->getDir() == ED_SENSE))
+                if(!ovr.isContainment() || (*edgeIter)->getDir() == ED_SENSE)
                 {
                     ASQG::EdgeRecord edgeRecord(ovr);
                     edgeRecord.write(*pWriter);
@@ -744,6 +1171,49 @@ void Bigraph::writeASQG(const std::string& filename) const
     delete pWriter;
 }
 
+//
+// Write the graph to a binary BSQG file. The records are the
+// same as the records writeASQG would write, in the same order.
+//
+void Bigraph::writeBSQG(const std::string& filename) const
+{
+    BSQG::Writer writer(filename);
+    writer.setMinOverlap(m_minOverlap);
+    writer.setErrorRate(m_errorRate);
+    writer.setContainment(m_hasContainment);
+    writer.setTransitive(m_hasTransitive);
+
+    // Vertices. The slots of removed vertices are skipped
+    // so the index of a vertex in the file can differ from its index here.
+    std::vector<uint32_t> fileIndex(m_vertexArray.size());
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
+    {
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+        fileIndex[i] = writer.addVertex(pVertex->getName(), pVertex->getSeq().toString(), false);
+    }
+
+    // Edges
+    for(size_t i = 0; i < m_vertexArray.size(); ++i)
+    {
+        Vertex* pVertex = m_vertexArray[i];
+        if(pVertex == NULL)
+            continue;
+
+        for(EdgePtrVecConstIter edgeIter = pVertex->m_edges.begin(); edgeIter != pVertex->m_edges.end(); ++edgeIter)
+        {
+            // Only write the canonical edge of each pair, as in writeASQG
+            const Edge* pEdge = *edgeIter;
+            const Vertex* pEnd = pEdge->getEnd();
+            int cmp = strcmp(pVertex->getName(), pEnd->getName());
+            if(cmp <= 0 && (!pEdge->getMatch().isContainment() || pEdge->getDir() == ED_SENSE))
+                writer.addEdge(fileIndex[i], fileIndex[pEnd->getIndex()], pEdge->getMatch());
+        }
+    }
+    writer.close();
+}
+
 //
 std::string Bigraph::getColorString(GraphColor c)
 {
@@ -11,23 +11,52 @@
 
 #include <string>
 #include <stdio.h>
+#include <string.h>
 #include <vector>
 #include <map>
 #include "GraphCommon.h"
 #include "Vertex.h"
 #include "Edge.h"
 #include "HashMap.h"
+#include "StringTable.h"
+#include "CompactAdjacency.h"
+#include "config.h"
+
+#if HAVE_OPENMP
+#include <omp.h>
+#endif
+
+// Hash and compare the vertex names held in the string table.
+// The NULL pointer is used as the deleted key of the map.
+struct VertexNameHasher
+{
+    size_t operator()(const char* pName) const
+    {
+        // FNV-1a
+        size_t h = 14695981039346656037ULL;
+        for(; pName != NULL && *pName != '\0'; ++pName)
+            h = (h ^ (unsigned char)*pName) * 1099511628211ULL;
+        return h;
+    }
+};
+
+struct VertexNameEqual
+{
+    bool operator()(const char* pA, const char* pB) const
+    {
+        if(pA == NULL || pB == NULL)
+            return pA == pB;
+        return strcmp(pA, pB) == 0;
+    }
+};
 
 //
 // Typedefs
 //
-//typedef std::map<VertexID, Vertex*> VertexPtrMap;
-//typedef __gnu_cxx::hash_map<VertexID, Vertex*> VertexPtrMap;
-//typedef std::tr1::unordered_map<VertexID, Vertex*> VertexPtrMap;
-typedef SparseHashMap<VertexID, Vertex*, StringHasher> VertexPtrMap;
 
-typedef VertexPtrMap::iterator VertexPtrMapIter;
-typedef VertexPtrMap::const_iterator VertexPtrMapConstIter;
+// Map from a vertex name to its index in the vertex array. The keys point
+// into the string table of the graph so the name is stored once per vertex.
+typedef SparseHashMap<const char*, VertexIndex, VertexNameHasher, VertexNameEqual> VertexNameMap;
 
 class Bigraph;
 typedef bool(*VertexVisitFunction)(Bigraph*, Vertex*);
@@ -37,6 +66,37 @@ typedef std::vector<Path> PathVector;
 typedef std::vector<VertexID> VertexIDVec;
 typedef std::vector<Vertex*> VertexPtrVec;
 
+// Summary statistics of the graph. A vertex is a tip if it has
+// edges in only one direction, a monobranch if it has more than one
+// edge in one direction and a dibranch if it has more than one edge in
+// both directions. The counts are kept up to date by the graph as
+// vertices and edges are added and removed.
+struct GraphStats
+{
+    GraphStats() : numVertices(0), numEdges(0), numIslands(0), numTips(0),
+                   numMonobranch(0), numDibranch(0), numSimple(0) {}
+
+    // Add or remove the contribution of a vertex with its current edges
+    void add(const Vertex* pVertex) { update(pVertex, true); }
+    void remove(const Vertex* pVertex) { update(pVertex, false); }
+
+    bool operator==(const GraphStats& other) const;
+    bool operator!=(const GraphStats& other) const { return !(*this == other); }
+
+    void print(FILE* pFile = stdout) const;
+
+    size_t numVertices;
+    size_t numEdges;
+    size_t numIslands;
+    size_t numTips;
+    size_t numMonobranch;
+    size_t numDibranch;
+    size_t numSimple;
+
+    private:
+        void update(const Vertex* pVertex, bool isAdd);
+};
+
 class Bigraph
 {
 
@@ -60,12 +120,37 @@ class Bigraph
         // Get a vertex
         Vertex* getVertex(VertexID id) const;
 
+        // Get a vertex by its index in the vertex array. Returns
+        // NULL if the vertex has been removed.
+        Vertex* getVertexByIndex(VertexIndex idx) const { return idx < m_vertexArray.size() ? m_vertexArray[idx] : NULL; }
+
+        // One more than the largest index of a vertex in the graph
+        size_t getVertexIndexLimit() const { return m_vertexArray.size(); }
+
+        // Build a compact, read-only view of the edges for phases that only
+        // traverse the graph. The view is cached until the graph is modified
+        // through one of its member functions, which calls thaw(). Edges
+        // should only be changed through the graph, code that edits the edges
+        // of a Vertex directly must call thaw() itself and leaves the
+        // statistics of the graph out of date. The vertices are marked while
+        // the graph is frozen and their edge mutators assert on the mark.
+        const CompactAdjacency& freeze() const;
+        void thaw();
+        bool isFrozen() const { return m_isFrozen; }
+
         // Add an edge
         void addEdge(Vertex* pVertex, Edge* pEdge);
 
         // Remove an edge
         void removeEdge(const EdgeDesc& ed);
 
+        // Remove an edge from its start vertex pVertex and free it. This does not remove the twin.
+        // The start vertex is passed in as the twin of pEdge may already have been freed.
+        void deleteEdge(Vertex* pVertex, Edge* pEdge);
+
+        // Delete all the edges of a vertex, and their twins
+        void deleteEdges(Vertex* pVertex);
+
         // Remove all edges marked by color c
         int sweepVertices(GraphColor c);
         int sweepEdges(GraphColor c);
@@ -79,12 +164,18 @@ class Bigraph
         // Rename all the vertices in the graph
         void renameVertices(const std::string& prefix = "");
 
-        // Simplify the graph by removing transitive edges
-        void simplify();
+        // Simplify the graph by compacting unbranched chains of vertices
+        void simplify(int numThreads = 1);
 
         // Validate that the graph is sane
         void validate();
 
+        // Statistics of the graph. getStats() is maintained as the graph changes,
+        // computeStats() counts them by scanning every vertex.
+        const GraphStats& getStats() const { return m_stats; }
+        GraphStats computeStats() const;
+        void printStats() const { m_stats.print(); }
+
         // Flip a given vertex
         void flip(VertexID id);
 
@@ -125,19 +216,65 @@ class Bigraph
         void getVertexSequences(std::vector<std::string>& outSequences) const;
 
         // Visit each vertex in the graph and call the visit functor object
+        // Visitors may edit the graph so the compact view is dropped first.
         template<typename VF>
         bool visit(VF& vf)
         {
+            thaw();
             bool modified = false;
             vf.previsit(this);
-            VertexPtrMapConstIter iter = m_vertices.begin(); 
-            for(; iter != m_vertices.end(); ++iter)
+            for(size_t i = 0; i < m_vertexArray.size(); ++i)
             {
-                modified = vf.visit(this, iter->second) || modified;
+                Vertex* pVertex = m_vertexArray[i];
+                if(pVertex != NULL)
+                    modified = vf.visit(this, pVertex) || modified;
             }
             vf.postvisit(this);
             return modified;
         }
+
+        // Visit the vertices using numThreads threads. Visitors opt in by
+        // providing the following, in addition to previsit/visit/postvisit:
+        //   bool isParallelSafe(const Bigraph* pGraph) const
+        //       true if visit() only reads the graph and keeps its changes
+        //       in its own members (for example in a MutationLog) for the
+        //       current graph. Otherwise the serial visit is used.
+        //   void merge(VF& other)
+        //       fold the counts and changes of a thread's copy of the
+        //       visitor into this one.
+        // Each thread visits blocks of vertices with its own copy of the
+        // visitor, made after previsit. Once all vertices have been visited
+        // the copies are merged in thread order and postvisit is called.
+        template<typename VF>
+        bool visitParallel(VF& vf, int numThreads)
+        {
+#if HAVE_OPENMP
+            if(numThreads <= 1 || !vf.isParallelSafe(this))
+                return visit(vf);
+
+            thaw();
+            vf.previsit(this);
+            std::vector<VF> threadVisitors(numThreads, vf);
+
+            int modified = 0;
+            long numSlots = m_vertexArray.size();
+            #pragma omp parallel for schedule(dynamic, 1024) num_threads(numThreads) reduction(||:modified)
+            for(long i = 0; i < numSlots; ++i)
+            {
+                Vertex* pVertex = m_vertexArray[i];
+                if(pVertex != NULL)
+                    modified = threadVisitors[omp_get_thread_num()].visit(this, pVertex) || modified;
+            }
+
+            for(size_t i = 0; i < threadVisitors.size(); ++i)
+                vf.merge(threadVisitors[i]);
+            vf.postvisit(this);
+            return modified;
+#else
+            (void)numThreads;
+            return visit(vf);
+#endif
+        }
         
         // Set the colors for the entire graph
         void setColors(GraphColor c);
@@ -167,6 +304,7 @@ class Bigraph
         // Write the graph to a file
         void writeDot(const std::string& filename, int dotFlags = 0) const;
         void writeASQG(const std::string& filename) const;
+        void writeBSQG(const std::string& filename) const;
 
         // Returns an allocator for the edges of the graph
         SimpleAllocator<Edge>* getEdgeAllocator() { return m_pEdgeAllocator; }
@@ -174,20 +312,57 @@ class Bigraph
         // Returns an allocator for the vertices of the graph
         SimpleAllocator<Vertex>* getVertexAllocator() { return m_pVertexAllocator; }
 
+        // Allocate a vertex from the pool of the graph, with its name copied
+        // into the string table of the graph. The vertex must be added to
+        // this graph with addVertex.
+        Vertex* createVertex(const VertexID& id, const std::string& seq);
+
+        // Return the memory pools that no longer hold any vertices or edges
+        // to the system. This is done automatically after the graph is swept.
+        void releaseMemory();
+
         // Return a string for a color code
         static std::string getColorString(GraphColor c);
 
     private:
         
+        // Set or clear the frozen mark of every vertex
+        void setVertexFrozen(bool b) const;
+
         // Simplify the graph by compacting edges in the given direction
         void simplify(EdgeDir dir);
 
+        // Compact all the maximal unbranched chains of vertices that have two ends.
+        // The chains are found and their sequences are built on numThreads threads,
+        // then the edges are moved to the first vertex of each chain.
+        void compactChains(int numThreads);
+
+        // Move the edges of the vertex at the end of pEdge, which has 
+        // been merged into pV1, to pV1 and remove the vertex
+        void spliceMergedVertex(Vertex* pV1, Edge* pEdge);
+
         void followLinear(VertexID id, EdgeDir dir, Path& outPath);
 
+        // Remove a vertex from the vertex array and the name map
+        void eraseVertex(Vertex* pVertex);
+
         //
         // data
         //
-        VertexPtrMap m_vertices;
+
+        // The vertices, indexed by VertexIndex. The slot of a removed vertex is NULL.
+        std::vector<Vertex*> m_vertexArray;
+        size_t m_numVertices;
+
+        // The vertex names and the map from a name to the vertex index.
+        // The names of removed vertices are not reclaimed until the
+        // vertices are renamed or the graph is destroyed.
+        StringTable m_names;
+        VertexNameMap m_nameMap;
+
+        // The compact view of the edges, valid while m_isFrozen is set
+        mutable CompactAdjacency m_adjacency;
+        mutable bool m_isFrozen;
 
         // Graph parameters
         bool m_hasContainment;
@@ -197,6 +372,8 @@ class Bigraph
         int m_minOverlap;
         double m_errorRate;
 
+        GraphStats m_stats;
+
         // Memory management
         SimpleAllocator<Vertex>* m_pVertexAllocator;
         SimpleAllocator<Edge>* m_pEdgeAllocator;
@@ -0,0 +1,76 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// CompactAdjacency - A read-only snapshot of the
+// edges of a graph in compressed sparse row form.
+//
+#include "CompactAdjacency.h"
+#include "Vertex.h"
+#include "Edge.h"
+
+//
+void CompactAdjacency::build(const std::vector<Vertex*>& vertices)
+{
+    clear();
+
+    // Size both arrays up front so the edges are allocated once
+    size_t numEdges = 0;
+    for(size_t i = 0; i < vertices.size(); ++i)
+    {
+        if(vertices[i] != NULL)
+            numEdges += vertices[i]->m_edges.size();
+    }
+
+    m_offsets.reserve(vertices.size() + 1);
+    m_edges.reserve(numEdges);
+
+    m_offsets.push_back(0);
+    for(size_t i = 0; i < vertices.size(); ++i)
+    {
+        const Vertex* pVertex = vertices[i];
+        if(pVertex != NULL)
+        {
+            const EdgePtrVec& edges = pVertex->m_edges;
+            for(size_t j = 0; j < edges.size(); ++j)
+            {
+                Edge* pEdge = edges[j];
+                CompactEdge ce;
+                ce.pEdge = pEdge;
+                ce.end = pEdge->getEnd()->getIndex();
+                ce.labelLength = pEdge->getSeqLen();
+                ce.dir = pEdge->getDir();
+                ce.comp = pEdge->getComp();
+                m_edges.push_back(ce);
+            }
+        }
+        m_offsets.push_back(m_edges.size());
+    }
+}
+
+//
+void CompactAdjacency::clear()
+{
+    // Release the memory as well as the contents
+    std::vector<size_t>().swap(m_offsets);
+    std::vector<CompactEdge>().swap(m_edges);
+}
+
+//
+size_t CompactAdjacency::countEdges(VertexIndex v, EdgeDir dir) const
+{
+    size_t count = 0;
+    for(const_iterator iter = begin(v); iter != end(v); ++iter)
+    {
+        if(iter->getDir() == dir)
+            ++count;
+    }
+    return count;
+}
+
+//
+size_t CompactAdjacency::getMemSize() const
+{
+    return m_offsets.capacity() * sizeof(size_t) + m_edges.capacity() * sizeof(CompactEdge);
+}
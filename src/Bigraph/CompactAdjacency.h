@@ -0,0 +1,71 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// CompactAdjacency - A read-only snapshot of the
+// edges of a graph in compressed sparse row form.
+//
+// The edges of vertex v are stored contiguously in
+// [begin(v), end(v)) in the same order as the adjacency
+// list of the vertex. Each entry caches the fields that
+// traversals need most often so the Edge objects only
+// have to be touched to read the overlap coordinates or
+// to set the edge colour.
+//
+// The snapshot is built by Bigraph::freeze() and is only
+// valid until the graph is modified.
+//
+#ifndef COMPACTADJACENCY_H
+#define COMPACTADJACENCY_H
+
+#include <vector>
+#include "GraphCommon.h"
+
+class Edge;
+class Vertex;
+
+struct CompactEdge
+{
+    Edge* pEdge;
+    VertexIndex end;
+    uint32_t labelLength;
+    uint8_t dir;
+    uint8_t comp;
+
+    EdgeDir getDir() const { return (EdgeDir)dir; }
+    EdgeComp getComp() const { return (EdgeComp)comp; }
+    EdgeDir getTwinDir() const { return (getComp() == EC_SAME) ? !getDir() : getDir(); }
+};
+
+class CompactAdjacency
+{
+    public:
+
+        typedef const CompactEdge* const_iterator;
+
+        CompactAdjacency() {}
+
+        // Build the snapshot from the vertex array of a graph.
+        // Removed vertices (NULL entries) have no edges.
+        void build(const std::vector<Vertex*>& vertices);
+        void clear();
+
+        // The edges of the vertex with index v
+        const_iterator begin(VertexIndex v) const { return m_edges.empty() ? NULL : &m_edges[0] + m_offsets[v]; }
+        const_iterator end(VertexIndex v) const { return m_edges.empty() ? NULL : &m_edges[0] + m_offsets[v + 1]; }
+
+        size_t countEdges(VertexIndex v) const { return m_offsets[v + 1] - m_offsets[v]; }
+        size_t countEdges(VertexIndex v, EdgeDir dir) const;
+
+        size_t getNumVertexSlots() const { return m_offsets.empty() ? 0 : m_offsets.size() - 1; }
+        size_t getNumEdges() const { return m_edges.size(); }
+        size_t getMemSize() const;
+
+    private:
+
+        std::vector<size_t> m_offsets;
+        std::vector<CompactEdge> m_edges;
+};
+
+#endif
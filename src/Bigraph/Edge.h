@@ -141,11 +141,10 @@ class Edge
             return pAllocator->alloc();
         }
 
-        void operator delete(void* /*target*/, size_t /*size*/)
+        void operator delete(void* target, size_t /*size*/)
         {
-            // Deletions are handled at the graph/pool level. The lifetime of an edge
-            // is as long as the graph it belongs to, even if it is deleted before
-            // the graph.
+            // Return the slot to the memory pool of the graph so it can be reused
+            SimpleAllocator<Edge>::dealloc(target);
         }
 
         // Validate that the edge is sane
@@ -7,15 +7,17 @@
 // EdgeDesc - A unique description of an edge 
 //
 #include "EdgeDesc.h"
+#include <string.h>
 #include "Vertex.h"
 
 // Operators
 bool EdgeDesc::operator<(const EdgeDesc& obj) const
 {
     assert(pVertex != NULL && obj.pVertex != NULL);
-    if(pVertex->getID() < obj.pVertex->getID())
+    int cmp = strcmp(pVertex->getName(), obj.pVertex->getName());
+    if(cmp < 0)
         return true;
-    else if(pVertex->getID() > obj.pVertex->getID())
+    else if(cmp > 0)
         return false;
     else if(dir < obj.dir)
         return true;
@@ -31,7 +33,7 @@ bool EdgeDesc::operator<(const EdgeDesc& obj) const
 bool EdgeDesc::operator==(const EdgeDesc& obj) const
 {
     assert(pVertex != NULL && obj.pVertex != NULL);
-    return pVertex->getID() == obj.pVertex->getID() && dir == obj.dir && comp == obj.comp;
+    return strcmp(pVertex->getName(), obj.pVertex->getName()) == 0 && dir == obj.dir && comp == obj.comp;
 }
 
 std::ostream& operator<<(std::ostream& out, const EdgeDesc& ed)
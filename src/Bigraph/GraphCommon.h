@@ -56,6 +56,10 @@ const GraphColor GC_RED = 4;
 typedef std::string VertexID;
 typedef std::vector<VertexID> VertexIDVec;
 
+// The position of a vertex in the vertex array of its graph
+typedef uint32_t VertexIndex;
+const VertexIndex INVALID_VERTEX_INDEX = (VertexIndex)-1;
+
 //
 // Edge Operations
 //
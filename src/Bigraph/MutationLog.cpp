@@ -0,0 +1,45 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// MutationLog - Changes to a graph that are recorded
+// by a visitor and applied later.
+//
+#include "MutationLog.h"
+#include "Vertex.h"
+#include "Edge.h"
+
+//
+void MutationLog::setVertexColor(Vertex* pVertex, GraphColor c)
+{
+    m_vertexColors.push_back(VertexColor(pVertex, c));
+}
+
+//
+void MutationLog::setEdgeColor(Edge* pEdge, GraphColor c)
+{
+    m_edgeColors.push_back(EdgeColor(pEdge, c));
+}
+
+//
+void MutationLog::apply()
+{
+    for(size_t i = 0; i < m_vertexColors.size(); ++i)
+        m_vertexColors[i].first->setColor(m_vertexColors[i].second);
+
+    for(size_t i = 0; i < m_edgeColors.size(); ++i)
+    {
+        Edge* pEdge = m_edgeColors[i].first;
+        pEdge->setColor(m_edgeColors[i].second);
+        pEdge->getTwin()->setColor(m_edgeColors[i].second);
+    }
+    clear();
+}
+
+//
+void MutationLog::clear()
+{
+    m_vertexColors.clear();
+    m_edgeColors.clear();
+}
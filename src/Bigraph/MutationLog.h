@@ -0,0 +1,51 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// MutationLog - Changes to a graph that are recorded
+// by a visitor and applied later.
+//
+// Visitors that run on several threads at once cannot
+// change vertices or edges that other threads may be
+// reading. Instead they record the changes in a log and
+// the logs are applied by a single thread once all the
+// vertices have been visited.
+//
+#ifndef MUTATIONLOG_H
+#define MUTATIONLOG_H
+
+#include <vector>
+#include "GraphCommon.h"
+
+class Vertex;
+class Edge;
+
+class MutationLog
+{
+    public:
+
+        MutationLog() {}
+
+        void setVertexColor(Vertex* pVertex, GraphColor c);
+
+        // Set the color of an edge and its twin
+        void setEdgeColor(Edge* pEdge, GraphColor c);
+
+        // Apply the changes in the order they were recorded
+        // and clear the log
+        void apply();
+        void clear();
+
+        bool empty() const { return m_vertexColors.empty() && m_edgeColors.empty(); }
+
+    private:
+
+        typedef std::pair<Vertex*, GraphColor> VertexColor;
+        typedef std::pair<Edge*, GraphColor> EdgeColor;
+
+        std::vector<VertexColor> m_vertexColors;
+        std::vector<EdgeColor> m_edgeColors;
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include "Vertex.h"
 #include "Edge.h"
 #include <algorithm>
+#include <string.h>
 
 Vertex::~Vertex()
 {
@@ -27,14 +28,10 @@ Vertex::~Vertex()
 // must be updated to contain the extension of the vertex
 void Vertex::merge(Edge* pEdge)
 {
-    Edge* pTwin = pEdge->getTwin();
     //std::cout << "Adding label to " << getID() << " str: " << pSE->getLabel() << "\n";
 
     // Merge the sequence
     DNAEncodedString label = pEdge->getLabel();
-    size_t label_len = label.length();
-    pEdge->updateSeqLen(m_seq.length() + label_len);
-    bool prepend = false;
 
     if(pEdge->getDir() == ED_SENSE)
     {
@@ -44,9 +41,26 @@ void Vertex::merge(Edge* pEdge)
     {
         label.append(m_seq);
         std::swap(m_seq, label);
-        prepend = true;
     }
 
+    mergeDeferred(pEdge, m_seq.length());
+
+#ifdef VALIDATE
+    VALIDATION_WARNING("Vertex::merge")
+    validate();
+#endif
+
+}
+
+//
+void Vertex::mergeDeferred(Edge* pEdge, size_t newLen)
+{
+    assert(!m_isFrozen);
+    Edge* pTwin = pEdge->getTwin();
+    size_t label_len = pEdge->getSeqLen();
+    bool prepend = pEdge->getDir() != ED_SENSE;
+    pEdge->updateSeqLen(newLen);
+
     // Update the coverage value of the vertex
     m_coverage += pEdge->getEnd()->getCoverage();
 
@@ -56,7 +70,6 @@ void Vertex::merge(Edge* pEdge)
     // All the SeqCoords for the edges must have their seqlen field updated
     // Also, if we prepended sequence to this edge, all the matches in the 
     // SENSE direction must have their coordinates offset
-    size_t newLen = m_seq.length();
     for(EdgePtrVecIter iter = m_edges.begin(); iter != m_edges.end(); ++iter)
     {
         Edge* pUpdateEdge = *iter;
@@ -64,12 +77,6 @@ void Vertex::merge(Edge* pEdge)
         if(prepend && pUpdateEdge->getDir() == ED_SENSE && pEdge != pUpdateEdge)
             pUpdateEdge->offsetMatch(label_len);
     }
-
-#ifdef VALIDATE
-    VALIDATION_WARNING("Vertex::merge")
-    validate();
-#endif
-
 }
 
 void Vertex::validate() const
@@ -99,12 +106,14 @@ void Vertex::validate() const
 //
 void Vertex::sortAdjListByID()
 {
+    assert(!m_isFrozen);
     EdgeIDComp comp;
     std::sort(m_edges.begin(), m_edges.end(), comp);
 }
 
 void Vertex::sortAdjListByLen()
 {
+    assert(!m_isFrozen);
     EdgeLenComp comp;
     std::sort(m_edges.begin(), m_edges.end(), comp);
 }
@@ -113,45 +122,35 @@ void Vertex::sortAdjListByLen()
 // Returns true if a duplicate has been marked
 bool Vertex::markDuplicateEdges(GraphColor dupColor)
 {
-    // Sort the edge lists by length
-    sortAdjListByLen();
-    bool hasDup = false;
-    hasDup = markDuplicateEdges(ED_SENSE, dupColor) || hasDup;
-    hasDup = markDuplicateEdges(ED_ANTISENSE, dupColor) || hasDup;
-    return hasDup;
+    EdgePtrVec duplicates;
+    findDuplicateEdges(duplicates);
+    for(size_t i = 0; i < duplicates.size(); ++i)
+    {
+        duplicates[i]->setColor(dupColor);
+        duplicates[i]->getTwin()->setColor(dupColor);
+    }
+    return true;
 }
 
-// Mark duplicate edges in the specified direction
-bool Vertex::markDuplicateEdges(EdgeDir dir, GraphColor dupColor)
+//
+void Vertex::findDuplicateEdges(EdgePtrVec& outEdges)
 {
-    for(EdgePtrVecIter iter = m_edges.begin(); iter != m_edges.end(); ++iter)
-    {
-        Edge* pEdge = *iter;
-        if(pEdge->getDir() == dir)
-        {
-            Vertex* pY = pEdge->getEnd();
-            if(pY->getColor() == GC_BLACK)
-            {
-                //std::cerr << getID() << " has a duplicate edge to " << pEdge->getEndID() << " in direction " << dir << "\n";
+    // Sort the edge lists by length
+    sortAdjListByLen();
 
-                // This vertex is the endpoint of some other (potentially longer) edge
-                // Delete the edge
-                Edge* pTwin = pEdge->getTwin();
-                pTwin->setColor(dupColor);
-                pEdge->setColor(dupColor);
-            }
-            else
-            {
-                assert(pY->getColor() == GC_WHITE);
-                pY->setColor(GC_BLACK);
-            }
-        }
-    }
+    // Group the edges by direction and endpoint. Within a group the
+    // edges stay in length order so the first edge is the one kept.
+    typedef std::pair<std::pair<int, VertexIndex>, size_t> EdgeKey;
+    std::vector<EdgeKey> keys(m_edges.size());
+    for(size_t i = 0; i < m_edges.size(); ++i)
+        keys[i] = EdgeKey(std::make_pair((int)m_edges[i]->getDir(), m_edges[i]->getEnd()->getIndex()), i);
+    std::sort(keys.begin(), keys.end());
 
-    // Reset vertex colors
-    for(EdgePtrVecIter iter = m_edges.begin(); iter != m_edges.end(); ++iter)
-        (*iter)->getEnd()->setColor(GC_WHITE);
-    return true;
+    for(size_t i = 1; i < keys.size(); ++i)
+    {
+        if(keys[i].first == keys[i - 1].first)
+            outEdges.push_back(m_edges[keys[i].second]);
+    }
 }
 
 // Get a multioverlap object representing the overlaps for this vertex
@@ -169,6 +168,7 @@ MultiOverlap Vertex::getMultiOverlap() const
 // Add an edge
 void Vertex::addEdge(Edge* ep)
 {
+    assert(!m_isFrozen);
     assert(ep->getStart() == this);
 
 #ifdef VALIDATE
@@ -198,6 +198,7 @@ void Vertex::deleteEdge(Edge* pEdge)
 // Remove an edge but do not destroy it
 void Vertex::removeEdge(Edge* pEdge)
 {
+    assert(!m_isFrozen);
     EdgePtrVecIter iter = m_edges.begin();
     while(iter != m_edges.end())
     {
@@ -212,6 +213,7 @@ void Vertex::removeEdge(Edge* pEdge)
 //
 void Vertex::removeEdge(const EdgeDesc& ed)
 {
+    assert(!m_isFrozen);
     EdgePtrVecIter iter = findEdge(ed);
     if(iter == m_edges.end())
     {
@@ -224,6 +226,7 @@ void Vertex::removeEdge(const EdgeDesc& ed)
 // Delete all the edges, and their twins, from this vertex
 void Vertex::deleteEdges()
 {
+    assert(!m_isFrozen);
     EdgePtrVecIter iter = m_edges.begin();
     for(; iter != m_edges.end(); ++iter)
     {
@@ -244,6 +247,7 @@ void Vertex::deleteEdges()
 // This only deletes the edge and not its twin
 int Vertex::sweepEdges(GraphColor c)
 {
+    assert(!m_isFrozen);
     int numRemoved = 0;
     EdgePtrVecIter iter = m_edges.begin();
     while(iter != m_edges.end())
@@ -322,7 +326,7 @@ EdgePtrVec Vertex::findEdgesTo(VertexID id)
     EdgePtrVec outEdges;
     for(; iter != m_edges.end(); ++iter)
     {
-        if((*iter)->getEndID() == id)
+        if(id == (*iter)->getEnd()->getName())
             outEdges.push_back(*iter);
     }
     return outEdges;
@@ -390,10 +394,15 @@ size_t Vertex::countEdges() const
 }
 
 //
-size_t Vertex::countEdges(EdgeDir dir)
+size_t Vertex::countEdges(EdgeDir dir) const
 {
-    EdgePtrVec ev = getEdges(dir);
-    return ev.size();
+    size_t n = 0;
+    for(EdgePtrVecConstIter iter = m_edges.begin(); iter != m_edges.end(); ++iter)
+    {
+        if((*iter)->getDir() == dir)
+            ++n;
+    }
+    return n;
 }
 
 // Calculate the difference in overlap lengths between
@@ -458,7 +467,7 @@ void Vertex::writeEdges(std::ostream& out, int dotFlags) const
 
 bool EdgeIDComp::operator()(const Edge* pA, const Edge* pB) 
 {
-       return pA->getEndID() < pB->getEndID();
+       return strcmp(pA->getEnd()->getName(), pB->getEnd()->getName()) < 0;
 }
 
 // Compare string edge points by length
@@ -57,12 +57,6 @@ class Vertex
 {
     public:
     
-        Vertex(VertexID id, const std::string& s) : m_id(id), 
-                                                    m_seq(s), 
-                                                    m_color(GC_WHITE),
-                                                    m_coverage(1),
-                                                    m_isContained(false),
-                                                    m_isSuperRepeat(false) {}
         ~Vertex();
 
         // High-level modification functions
@@ -70,6 +64,11 @@ class Vertex
         // Merge another vertex into this vertex, as specified by pEdge
         void merge(Edge* pEdge);
 
+        // Merge another vertex into this vertex without changing the sequence.
+        // newLen is the length of the sequence after the merge. The caller must
+        // set the merged sequence once all the merges have been done.
+        void mergeDeferred(Edge* pEdge, size_t newLen);
+
         // sort the edges by the ID of the vertex they point to
         void sortAdjListByID();
 
@@ -79,6 +78,11 @@ class Vertex
         // Ensure that all the edges are unique
         bool markDuplicateEdges(GraphColor dupColor); 
 
+        // Sort the edges by length and find the edges that have the same
+        // direction and endpoint as a longer edge. Only this vertex is
+        // modified so different vertices can be processed concurrently.
+        void findDuplicateEdges(EdgePtrVec& outEdges);
+
         // Get a multioverlap object representing the overlaps for this vertex
         MultiOverlap getMultiOverlap() const;
 
@@ -103,7 +107,7 @@ class Vertex
         Edge* getLongestOverlapEdge(EdgeDir dir) const;
 
         size_t countEdges() const;
-        size_t countEdges(EdgeDir dir);
+        size_t countEdges(EdgeDir dir) const;
 
         // Calculate the difference in overlap lengths between
         // the longest and second longest edge
@@ -113,7 +117,6 @@ class Vertex
         void validate() const;
         
         // setters
-        void setID(VertexID id) { m_id = id; }
         void setEdgeColors(GraphColor c);
         void setSeq(const std::string& s) { m_seq = s; }
         void setColor(GraphColor c) { m_color = c; }
@@ -121,7 +124,9 @@ class Vertex
         void setSuperRepeat(bool b) { m_isSuperRepeat = b; }
 
         // getters
-        VertexID getID() const { return m_id; }
+        VertexID getID() const { return VertexID(m_pName); }
+        const char* getName() const { return m_pName; }
+        VertexIndex getIndex() const { return m_index; }
         GraphColor getColor() const { return m_color; }
         const DNAEncodedString& getSeq() const { return m_seq; }
         std::string getStr() const { return m_seq.toString(); }
@@ -129,6 +134,7 @@ class Vertex
         size_t getMemSize() const;
         bool isContained() const { return m_isContained; }
         bool isSuperRepeat() const { return m_isSuperRepeat; }
+        bool isFrozen() const { return m_isFrozen; }
         uint16_t getCoverage() const { return m_coverage; }
 
         // Memory management
@@ -137,28 +143,47 @@ class Vertex
             return pAllocator->alloc();
         }
 
-        void operator delete(void* /*target*/, size_t /*size*/)
+        void operator delete(void* target, size_t /*size*/)
         {
-            // delete does nothing since all allocations go through the memory pool
-            // belonging to the graph. The memory allocated for the vertex will be
-            // cleaned up when the graph is destroyed.
+            // Return the slot to the memory pool of the graph so it can be reused
+            SimpleAllocator<Vertex>::dealloc(target);
         }
 
         // Output edges in graphviz format
         void writeEdges(std::ostream& out, int dotFlags) const;
 
+        // The graph creates the vertex with its name in the string table
+        // of the graph and assigns the index
+        friend class Bigraph;
+
+        // The adjacency snapshot reads the edge list without copying it
+        friend class CompactAdjacency;
+
     private:
 
+        // Vertices are created by Bigraph::createVertex. The name points into
+        // the string table of the graph and is not owned by the vertex.
+        Vertex(const char* pName, const std::string& s) : m_pName(pName),
+                                                          m_index(INVALID_VERTEX_INDEX),
+                                                          m_seq(s), 
+                                                          m_color(GC_WHITE),
+                                                          m_coverage(1),
+                                                          m_isContained(false),
+                                                          m_isSuperRepeat(false),
+                                                          m_isFrozen(false) {}
+
         // Global new is disallowed, all allocations must go through the pool
         void* operator new(size_t size)
         {
             return malloc(size);
         }
 
-        // Ensure all the edges in DIR are unique
-        bool markDuplicateEdges(EdgeDir dir, GraphColor dupColor);
+        // Not copyable
+        Vertex(const Vertex&);
+        Vertex& operator=(const Vertex&);
 
-        VertexID m_id;
+        const char* m_pName;
+        VertexIndex m_index;
         EdgePtrVec m_edges;
         DNAEncodedString m_seq;
         GraphColor m_color;
@@ -168,6 +193,9 @@ class Vertex
 
         bool m_isContained;
         bool m_isSuperRepeat;
+
+        // Set while the graph holds a compact view of the edges
+        bool m_isFrozen;
 };
 
 #endif
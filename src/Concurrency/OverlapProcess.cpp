@@ -7,29 +7,31 @@
 // OverlapProcess - Wrapper for the overlap computation
 //
 #include "OverlapProcess.h"
+#include "ASQG.h"
 
 //
 //
 //
 OverlapProcess::OverlapProcess(const std::string& outFile, 
                                const OverlapAlgorithm* pOverlapper, 
-                               int minOverlap) : m_pOverlapper(pOverlapper), 
+                               int minOverlap) : m_writer(outFile),
+                                                 m_pOverlapper(pOverlapper), 
                                                  m_minOverlap(minOverlap)
 {
-    m_pWriter = createWriter(outFile);
+
 }
 
 //
 OverlapProcess::~OverlapProcess()
 {
-    delete m_pWriter;
+
 }
 
 //
 OverlapResult OverlapProcess::process(const SequenceWorkItem& workItem)
 {
     OverlapResult result = m_pOverlapper->overlapRead(workItem.read, m_minOverlap, &m_blockList);
-    m_pOverlapper->writeOverlapBlocks(*m_pWriter, workItem.idx, result.isSubstring, &m_blockList);
+    m_writer.write(workItem.idx, result.isSubstring, &m_blockList);
     m_blockList.clear();
     return result;
 }
@@ -49,3 +51,97 @@ void OverlapPostProcess::process(const SequenceWorkItem& item, const OverlapResu
 {
     m_pOverlapper->writeResultASQG(*m_pASQGWriter, item.read, result);
 }
+
+//
+//
+//
+OverlapEdgeProcess::OverlapEdgeProcess(const OverlapAlgorithm* pOverlapper, 
+                                       int minOverlap,
+                                       const ReadInfoTable* pQueryRIT,
+                                       const ReadInfoTable* pTargetRIT,
+                                       const SuffixArray* pFwdSAI,
+                                       const SuffixArray* pRevSAI,
+                                       bool bBinaryEdges) : m_pOverlapper(pOverlapper), 
+                                                            m_minOverlap(minOverlap),
+                                                            m_pQueryRIT(pQueryRIT),
+                                                            m_pTargetRIT(pTargetRIT),
+                                                            m_pFwdSAI(pFwdSAI),
+                                                            m_pRevSAI(pRevSAI),
+                                                            m_bBinaryEdges(bBinaryEdges)
+{
+
+}
+
+//
+OverlapEdgeResult OverlapEdgeProcess::process(const SequenceWorkItem& workItem)
+{
+    OverlapEdgeResult out;
+    out.result = m_pOverlapper->overlapRead(workItem.read, m_minOverlap, &m_blockList);
+
+    // Only one of the duplicate overlaps is kept when the reads are compared to themselves
+    size_t sumBlockSize;
+    bool bCheckIDs = m_pQueryRIT == m_pTargetRIT;
+    if(m_bBinaryEdges)
+    {
+        convertBlocksToOverlaps(workItem.idx, m_blockList, m_pQueryRIT, m_pTargetRIT, 
+                                m_pFwdSAI, m_pRevSAI, bCheckIDs, sumBlockSize, out.overlaps, &out.targetIdx);
+    }
+    else
+    {
+        convertBlocksToOverlaps(workItem.idx, m_blockList, m_pQueryRIT, m_pTargetRIT, 
+                                m_pFwdSAI, m_pRevSAI, bCheckIDs, sumBlockSize, m_overlaps);
+    }
+
+    if(!m_overlaps.empty())
+    {
+        std::ostringstream writer;
+        for(OverlapVector::iterator iter = m_overlaps.begin(); iter != m_overlaps.end(); ++iter)
+        {
+            ASQG::EdgeRecord edgeRecord(*iter);
+            edgeRecord.write(writer);
+        }
+        out.edges = writer.str();
+    }
+
+    m_blockList.clear();
+    m_overlaps.clear();
+    return out;
+}
+
+//
+//
+//
+OverlapEdgePostProcess::OverlapEdgePostProcess(std::ostream* pASQGWriter, 
+                                               std::ostream* pEdgeWriter,
+                                               const OverlapAlgorithm* pOverlapper) : m_pASQGWriter(pASQGWriter),
+                                                                                      m_pEdgeWriter(pEdgeWriter),
+                                                                                      m_pBSQGWriter(NULL),
+                                                                                      m_pOverlapper(pOverlapper)
+{
+
+}
+
+//
+OverlapEdgePostProcess::OverlapEdgePostProcess(BSQG::Writer* pBSQGWriter,
+                                               const OverlapAlgorithm* pOverlapper) : m_pASQGWriter(NULL),
+                                                                                      m_pEdgeWriter(NULL),
+                                                                                      m_pBSQGWriter(pBSQGWriter),
+                                                                                      m_pOverlapper(pOverlapper)
+{
+
+}
+
+//
+void OverlapEdgePostProcess::process(const SequenceWorkItem& item, const OverlapEdgeResult& result)
+{
+    if(m_pBSQGWriter != NULL)
+    {
+        m_pOverlapper->writeResultBSQG(*m_pBSQGWriter, item.read, result.result);
+        for(size_t i = 0; i < result.overlaps.size(); ++i)
+            m_pBSQGWriter->addEdge(item.idx, result.targetIdx[i], result.overlaps[i].match);
+        return;
+    }
+
+    m_pOverlapper->writeResultASQG(*m_pASQGWriter, item.read, result.result);
+    m_pEdgeWriter->write(result.edges.data(), result.edges.size());
+}
@@ -11,6 +11,9 @@
 
 #include "Util.h"
 #include "OverlapAlgorithm.h"
+#include "HitsIO.h"
+#include "ReadInfoTable.h"
+#include "SuffixArray.h"
 #include "SequenceProcessFramework.h"
 
 // Compute the overlap blocks for reads
@@ -26,7 +29,7 @@ class OverlapProcess
         OverlapResult process(const SequenceWorkItem& item);
     
     private:
-        std::ostream* m_pWriter;
+        HitsWriter m_writer;
         OverlapBlockList m_blockList;
         const OverlapAlgorithm* m_pOverlapper;
         const int m_minOverlap;
@@ -44,4 +47,65 @@ class OverlapPostProcess
         const OverlapAlgorithm* m_pOverlapper;
 };
 
+// The result of the overlap step for a read with
+// the overlaps already written as ASQG edge records.
+// When a BSQG file is written, the overlaps and the indices
+// of the target reads are kept instead.
+struct OverlapEdgeResult
+{
+    OverlapResult result;
+    std::string edges;
+    OverlapVector overlaps;
+    std::vector<size_t> targetIdx;
+};
+
+// Compute the overlap blocks for reads and convert them into
+// edges straight away, rather than writing them to a hits file
+// that is parsed once the search is finished
+class OverlapEdgeProcess
+{
+    public:
+        OverlapEdgeProcess(const OverlapAlgorithm* pOverlapper, 
+                           int minOverlap,
+                           const ReadInfoTable* pQueryRIT,
+                           const ReadInfoTable* pTargetRIT,
+                           const SuffixArray* pFwdSAI,
+                           const SuffixArray* pRevSAI,
+                           bool bBinaryEdges = false);
+
+        OverlapEdgeResult process(const SequenceWorkItem& item);
+    
+    private:
+        OverlapBlockList m_blockList;
+        OverlapVector m_overlaps;
+        const OverlapAlgorithm* m_pOverlapper;
+        const int m_minOverlap;
+        const ReadInfoTable* m_pQueryRIT;
+        const ReadInfoTable* m_pTargetRIT;
+        const SuffixArray* m_pFwdSAI;
+        const SuffixArray* m_pRevSAI;
+        const bool m_bBinaryEdges;
+};
+
+// Write the vertex records to the ASQG file and the edge records
+// to a separate file, in the order of the input reads. The edges are
+// added to the ASQG file after all the vertices have been written.
+class OverlapEdgePostProcess
+{
+    public:
+        OverlapEdgePostProcess(std::ostream* pASQGWriter, std::ostream* pEdgeWriter, const OverlapAlgorithm* pOverlapper);
+
+        // Write the vertices and edges to a BSQG file. The reads must be
+        // compared to themselves so the index of a read is its vertex index.
+        OverlapEdgePostProcess(BSQG::Writer* pBSQGWriter, const OverlapAlgorithm* pOverlapper);
+
+        void process(const SequenceWorkItem& item, const OverlapEdgeResult& result);
+
+    private:
+        std::ostream* m_pASQGWriter;
+        std::ostream* m_pEdgeWriter;
+        BSQG::Writer* m_pBSQGWriter;
+        const OverlapAlgorithm* m_pOverlapper;
+};
+
 #endif
@@ -9,6 +9,7 @@
 // serially or in parallel. 
 //
 #include "ThreadWorker.h"
+#include "WorkStealingPool.h"
 #include "Timer.h"
 #include "SequenceWorkItem.h"
 #include "config.h"
@@ -25,6 +26,22 @@ namespace SequenceProcessFramework
 
 const size_t BUFFER_SIZE = 1000;
 
+// Bounds on the number of work items in a chunk for processWorkParallelStealing.
+// The chunks start small so all threads get work quickly and grow to
+// the maximum size to amortize the cost of scheduling.
+const size_t MIN_CHUNK_SIZE = 16;
+const size_t MAX_CHUNK_SIZE = 256;
+
+// The number of chunks per thread that can be in flight. The results
+// of a chunk are held until all the chunks before it are finished so this
+// bounds the memory used when a chunk is slow.
+const size_t REORDER_CHUNKS_PER_THREAD = 8;
+
+// The number of threads that decompress and parse the input of
+// processSequencesParallel. This is independent of the number of
+// processors so the pool does not double the thread count.
+const int NUM_PARSE_THREADS = 2;
+
 // Generic function to process n work items from a file. 
 // With the default value of -1, n becomes the largest value representable for
 // a size_t and all values will be read
@@ -241,6 +258,116 @@ size_t processWorkParallelPthread(Generator& generator,
     return generator.getNumConsumed();
 }
 
+// Design:
+// This function is a generic function to read some INPUT from a 
+// generic generator object, then perform work on them.
+// The actual processing is done by the Processor class 
+// that is passed in. The number of threads
+// created is determined by the size of the vector of processors - 
+// one thread per processor. 
+//
+// The input is split into chunks which are processed by a WorkStealingPool.
+// Unlike processWorkParallelPthread, the threads do not work in lockstep
+// so a slow item only delays the thread that is processing it. The results
+// are passed to the post processor in input order. Only a bounded number
+// of chunks can be in flight so if the oldest chunk is slow, reading stops
+// until it is finished. If the n parameter is used, at most n sequences
+// will be read from the file.
+template<class Input, class Output, class Generator, class Processor, class PostProcessor>
+size_t processWorkParallelStealing(Generator& generator, 
+                                   std::vector<Processor*> processPtrVector, 
+                                   PostProcessor* pPostProcessor, 
+                                   size_t n = -1)
+{
+    Timer timer("SequenceProcess", true);
+
+    typedef WorkStealingPool<Input, Output, Processor> Pool;
+    typedef typename Pool::Chunk Chunk;
+    typedef std::deque<Chunk*> ChunkQueue;
+
+    size_t numThreads = processPtrVector.size();
+    Pool pool(processPtrVector);
+    pool.start();
+
+    // The chunks that have been submitted, in input order
+    ChunkQueue reorderQueue;
+    size_t maxChunks = REORDER_CHUNKS_PER_THREAD * numThreads;
+    size_t chunkSize = MIN_CHUNK_SIZE;
+
+    size_t numWorkItemsRead = 0;
+    size_t numWorkItemsWrote = 0;
+    size_t reportInterval = 10 * BUFFER_SIZE * numThreads;
+    size_t nextReport = reportInterval;
+    bool done = false;
+
+    while(true)
+    {
+        // Fill the reorder window with new chunks
+        while(!done && reorderQueue.size() < maxChunks)
+        {
+            Chunk* pChunk = new Chunk;
+            pChunk->input.reserve(chunkSize);
+            while(pChunk->input.size() < chunkSize)
+            {
+                Input workItem;
+                bool valid = generator.generate(workItem);
+                if(valid)
+                {
+                    pChunk->input.push_back(workItem);
+                    numWorkItemsRead += 1;
+                }
+
+                done = !valid || generator.getNumConsumed() == n;
+                if(done)
+                    break;
+            }
+
+            if(pChunk->input.empty())
+            {
+                delete pChunk;
+                break;
+            }
+
+            pool.submit(pChunk);
+            reorderQueue.push_back(pChunk);
+            chunkSize = std::min(2 * chunkSize, MAX_CHUNK_SIZE);
+        }
+
+        if(reorderQueue.empty())
+            break;
+
+        // Process the results of the oldest chunk with a single thread
+        Chunk* pChunk = reorderQueue.front();
+        reorderQueue.pop_front();
+        pool.wait(pChunk);
+
+        assert(pChunk->input.size() == pChunk->output.size());
+        for(size_t i = 0; i < pChunk->input.size(); ++i)
+        {
+            pPostProcessor->process(pChunk->input[i], pChunk->output[i]);
+            numWorkItemsWrote += 1;
+        }
+        delete pChunk;
+
+        if(numWorkItemsWrote >= nextReport)
+        {
+            double proc_time_secs = timer.getElapsedWallTime();
+            printf("[sga] Processed %zu sequences in %lfs (%lf sequences/s)\n", numWorkItemsWrote, proc_time_secs, (double)numWorkItemsWrote / proc_time_secs);
+            nextReport += reportInterval;
+        }
+    }
+
+    pool.stop(); // Blocks until the threads join
+
+    assert(n == (size_t)-1 || generator.getNumConsumed() == n);
+    assert(numWorkItemsRead == numWorkItemsWrote);
+
+    double proc_time_secs = timer.getElapsedWallTime();
+    printf("[sga::process] processed %zu sequences in %lfs (%lf sequences/s)\n", 
+            generator.getNumConsumed(), proc_time_secs, (double)generator.getNumConsumed() / proc_time_secs);
+    return generator.getNumConsumed();
+}
+
 // Design:
 // This function is a generic function to read some INPUT from a 
 // generic generator object, then perform work on them.
@@ -347,11 +474,11 @@ size_t processSequencesParallel(SeqReader& reader,
 {
     typedef WorkItemGenerator<Input> InputGenerator;
     InputGenerator generator(&reader);
-    return processWorkParallelPthread<Input, 
-                                      Output, 
-                                      InputGenerator, 
-                                      Processor, 
-                                      PostProcessor>(generator, processPtrVector, pPostProcessor, n);
+    return processWorkParallelStealing<Input, 
+                                       Output, 
+                                       InputGenerator, 
+                                       Processor, 
+                                       PostProcessor>(generator, processPtrVector, pPostProcessor, n);
 }
 
 // Wrapper function for operating over n elements of from a SeqReader
@@ -371,10 +498,11 @@ size_t processSequencesParallelOpenMP(SeqReader& reader,
 }
 
 // Wrapper function for operating over a file of sequences
+// The file is decompressed and parsed by a pool of NUM_PARSE_THREADS threads
 template<class Input, class Output, class Processor, class PostProcessor>
 size_t processSequencesParallel(const std::string& readsFile, std::vector<Processor*> processPtrVector, PostProcessor* pPostProcessor)
 {
-    SeqReader reader(readsFile);
+    SeqReader reader(readsFile, 0, NUM_PARSE_THREADS);
     return processSequencesParallel<Input, Output, Processor, PostProcessor>(reader, processPtrVector, pPostProcessor);
 }
 
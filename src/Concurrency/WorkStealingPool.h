@@ -0,0 +1,292 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// WorkStealingPool - Pool of threads that process
+// chunks of work items. Each thread has its own deque
+// of chunks. A thread takes chunks from the front of
+// its own deque and when it runs out, it steals chunks
+// from the back of the other threads' deques. This keeps
+// every thread busy when the cost of the work items
+// varies widely.
+//
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <pthread.h>
+#include <deque>
+#include "Util.h"
+
+// A chunk of consecutive work items and their results
+template<class Input, class Output>
+struct WorkChunk
+{
+    WorkChunk() : done(false) {}
+
+    std::vector<Input> input;
+    std::vector<Output> output;
+
+    // Set by the pool once output has been filled in
+    bool done;
+};
+
+template<class Input, class Output, class Processor>
+class WorkStealingPool
+{
+    public:
+        typedef WorkChunk<Input, Output> Chunk;
+
+        // One thread is created for each processor
+        WorkStealingPool(const std::vector<Processor*>& processPtrVector);
+        ~WorkStealingPool();
+
+        // External control functions
+        void start();
+        void stop();
+
+        // Queue a chunk to be processed. The chunk is
+        // owned by the caller and must remain valid until
+        // wait() returns for it.
+        void submit(Chunk* pChunk);
+
+        // Block until the chunk has been processed
+        void wait(Chunk* pChunk);
+
+    private:
+
+        struct ChunkDeque
+        {
+            pthread_mutex_t mutex;
+            std::deque<Chunk*> chunks;
+        };
+
+        struct WorkerData
+        {
+            WorkStealingPool* pPool;
+            size_t idx;
+            pthread_t thread;
+        };
+
+        // Main work loop for thread idx
+        void run(size_t idx);
+
+        // Take the next chunk for thread idx from its own deque
+        // or from another thread. Returns NULL if no chunk was found.
+        Chunk* take(size_t idx);
+
+        // Thread entry point
+        static void* startThread(void* obj);
+
+        std::vector<Processor*> m_processPtrVector;
+        std::vector<ChunkDeque*> m_deques;
+        std::vector<WorkerData> m_workers;
+
+        // The number of chunks submitted but not yet taken by a thread,
+        // protected by m_queueMutex. Idle threads sleep on m_queueCond.
+        pthread_mutex_t m_queueMutex;
+        pthread_cond_t m_queueCond;
+        size_t m_numQueued;
+        size_t m_nextDeque;
+        bool m_stopRequested;
+
+        // Signalled when a chunk is finished
+        pthread_mutex_t m_doneMutex;
+        pthread_cond_t m_doneCond;
+};
+
+// Implementation
+template<class Input, class Output, class Processor>
+WorkStealingPool<Input, Output, Processor>::WorkStealingPool(const std::vector<Processor*>& processPtrVector) :
+                                                                m_processPtrVector(processPtrVector),
+                                                                m_numQueued(0),
+                                                                m_nextDeque(0),
+                                                                m_stopRequested(false)
+{
+    size_t numThreads = m_processPtrVector.size();
+    assert(numThreads > 0);
+    m_deques.resize(numThreads);
+    m_workers.resize(numThreads);
+
+    int ret = 0;
+    for(size_t i = 0; i < numThreads; ++i)
+    {
+        m_deques[i] = new ChunkDeque;
+        ret |= pthread_mutex_init(&m_deques[i]->mutex, NULL);
+    }
+
+    ret |= pthread_mutex_init(&m_queueMutex, NULL);
+    ret |= pthread_cond_init(&m_queueCond, NULL);
+    ret |= pthread_mutex_init(&m_doneMutex, NULL);
+    ret |= pthread_cond_init(&m_doneCond, NULL);
+    if(ret != 0)
+    {
+        std::cerr << "Mutex initialization failed with error " << ret << ", aborting" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+//
+template<class Input, class Output, class Processor>
+WorkStealingPool<Input, Output, Processor>::~WorkStealingPool()
+{
+    for(size_t i = 0; i < m_deques.size(); ++i)
+    {
+        assert(m_deques[i]->chunks.empty());
+        pthread_mutex_destroy(&m_deques[i]->mutex);
+        delete m_deques[i];
+    }
+
+    pthread_mutex_destroy(&m_queueMutex);
+    pthread_cond_destroy(&m_queueCond);
+    pthread_mutex_destroy(&m_doneMutex);
+    pthread_cond_destroy(&m_doneCond);
+}
+
+// Externally-called function to start the threads
+template<class Input, class Output, class Processor>
+void WorkStealingPool<Input, Output, Processor>::start()
+{
+    for(size_t i = 0; i < m_workers.size(); ++i)
+    {
+        m_workers[i].pPool = this;
+        m_workers[i].idx = i;
+        int ret = pthread_create(&m_workers[i].thread, 0, &WorkStealingPool<Input, Output, Processor>::startThread, &m_workers[i]);
+        if(ret != 0)
+        {
+            std::cerr << "Thread creation failed with error " << ret << ", aborting" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// Externally-called function to stop the threads. The threads
+// finish all the chunks that have been submitted before exiting.
+template<class Input, class Output, class Processor>
+void WorkStealingPool<Input, Output, Processor>::stop()
+{
+    pthread_mutex_lock(&m_queueMutex);
+    m_stopRequested = true;
+    pthread_cond_broadcast(&m_queueCond);
+    pthread_mutex_unlock(&m_queueMutex);
+
+    for(size_t i = 0; i < m_workers.size(); ++i)
+    {
+        int ret = pthread_join(m_workers[i].thread, NULL);
+        if(ret != 0)
+        {
+            std::cerr << "Thread join failed with error " << ret << ", aborting" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// Chunks are dealt to the threads in turn. Consecutive chunks
+// go to different threads so the chunks at the front of the reorder
+// window are started first.
+template<class Input, class Output, class Processor>
+void WorkStealingPool<Input, Output, Processor>::submit(Chunk* pChunk)
+{
+    pChunk->done = false;
+    pChunk->output.resize(pChunk->input.size());
+
+    ChunkDeque* pDeque = m_deques[m_nextDeque];
+    m_nextDeque = (m_nextDeque + 1) % m_deques.size();
+
+    pthread_mutex_lock(&pDeque->mutex);
+    pDeque->chunks.push_back(pChunk);
+    pthread_mutex_unlock(&pDeque->mutex);
+
+    pthread_mutex_lock(&m_queueMutex);
+    m_numQueued += 1;
+    pthread_cond_signal(&m_queueCond);
+    pthread_mutex_unlock(&m_queueMutex);
+}
+
+//
+template<class Input, class Output, class Processor>
+void WorkStealingPool<Input, Output, Processor>::wait(Chunk* pChunk)
+{
+    pthread_mutex_lock(&m_doneMutex);
+    while(!pChunk->done)
+        pthread_cond_wait(&m_doneCond, &m_doneMutex);
+    pthread_mutex_unlock(&m_doneMutex);
+}
+
+//
+template<class Input, class Output, class Processor>
+typename WorkStealingPool<Input, Output, Processor>::Chunk* WorkStealingPool<Input, Output, Processor>::take(size_t idx)
+{
+    // Work on the oldest chunk in our own deque first
+    ChunkDeque* pOwn = m_deques[idx];
+    Chunk* pChunk = NULL;
+    pthread_mutex_lock(&pOwn->mutex);
+    if(!pOwn->chunks.empty())
+    {
+        pChunk = pOwn->chunks.front();
+        pOwn->chunks.pop_front();
+    }
+    pthread_mutex_unlock(&pOwn->mutex);
+
+    // Steal the newest chunk of the next thread that has work
+    for(size_t i = 1; pChunk == NULL && i < m_deques.size(); ++i)
+    {
+        ChunkDeque* pVictim = m_deques[(idx + i) % m_deques.size()];
+        pthread_mutex_lock(&pVictim->mutex);
+        if(!pVictim->chunks.empty())
+        {
+            pChunk = pVictim->chunks.back();
+            pVictim->chunks.pop_back();
+        }
+        pthread_mutex_unlock(&pVictim->mutex);
+    }
+    return pChunk;
+}
+
+// Main worker loop
+template<class Input, class Output, class Processor>
+void WorkStealingPool<Input, Output, Processor>::run(size_t idx)
+{
+    Processor* pProcessor = m_processPtrVector[idx];
+    while(1)
+    {
+        // Sleep until a chunk is available
+        pthread_mutex_lock(&m_queueMutex);
+        while(m_numQueued == 0 && !m_stopRequested)
+            pthread_cond_wait(&m_queueCond, &m_queueMutex);
+
+        if(m_numQueued == 0)
+        {
+            // Stop was requested and all work has been taken
+            pthread_mutex_unlock(&m_queueMutex);
+            break;
+        }
+        m_numQueued -= 1;
+        pthread_mutex_unlock(&m_queueMutex);
+
+        // A chunk is reserved for this thread so one of
+        // the deques is guaranteed to have a chunk in it
+        Chunk* pChunk = NULL;
+        while(pChunk == NULL)
+            pChunk = take(idx);
+
+        for(size_t i = 0; i < pChunk->input.size(); ++i)
+            pChunk->output[i] = pProcessor->process(pChunk->input[i]);
+
+        pthread_mutex_lock(&m_doneMutex);
+        pChunk->done = true;
+        pthread_cond_broadcast(&m_doneCond);
+        pthread_mutex_unlock(&m_doneMutex);
+    }
+}
+
+// Thread entry point
+template<class Input, class Output, class Processor>
+void* WorkStealingPool<Input, Output, Processor>::startThread(void* obj)
+{
+    WorkerData* pData = reinterpret_cast<WorkerData*>(obj);
+    pData->pPool->run(pData->idx);
+    return NULL;
+}
+
+#endif
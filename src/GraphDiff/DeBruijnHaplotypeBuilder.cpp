@@ -60,7 +60,7 @@ HaplotypeBuilderReturnCode DeBruijnHaplotypeBuilder::run(StringVector& out_haplo
     StringGraph* pGraph = new StringGraph;
     BuilderExtensionQueue queue;
 
-    Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(m_startingKmer, m_startingKmer);
+    Vertex* pVertex = pGraph->createVertex(m_startingKmer, m_startingKmer);
     pVertex->setColor(GC_BLACK);
     pGraph->addVertex(pVertex);
 
@@ -114,7 +114,7 @@ HaplotypeBuilderReturnCode DeBruijnHaplotypeBuilder::run(StringVector& out_haplo
                 continue;
             
             // Allocate the new vertex and add it to the graph
-            Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(newStr, newStr);
+            Vertex* pVertex = pGraph->createVertex(newStr, newStr);
             pVertex->setColor(GC_BLACK);
             pGraph->addVertex(pVertex);
 
@@ -255,7 +255,7 @@ Vertex* DeBruijnHaplotypeBuilder::extendUnambiguously(Vertex* pStart, StringGrap
 
         // Create the new vertex and edge in the graph
         // Allocate the new vertex and add it to the graph
-        Vertex* pNew = new(pGraph->getVertexAllocator()) Vertex(newStr, newStr);
+        Vertex* pNew = pGraph->createVertex(newStr, newStr);
         pNew->setColor(GC_BLACK);
         pGraph->addVertex(pNew);
 
@@ -45,6 +45,8 @@ OverlapHaplotypeBuilder::OverlapHaplotypeBuilder(const GraphCompareParameters& p
     // k-mer based corrector params
     correction_params.numKmerRounds = 10;
     correction_params.kmerLength = 31;
+    correction_params.pKmerCache = NULL;
+    correction_params.pKmerTable = NULL;
     CorrectionThresholds::Instance().setBaseMinSupport(3);
 
     m_graph = new StringGraph;
@@ -228,7 +230,7 @@ void OverlapHaplotypeBuilder::insertVertexIntoGraph(const std::string& prefix, c
     // Create the vertex
     std::stringstream id_ss;
     id_ss << prefix << m_numReads++;
-    Vertex* pVertex = new(m_graph->getVertexAllocator()) Vertex(id_ss.str(), sequence);
+    Vertex* pVertex = m_graph->createVertex(id_ss.str(), sequence);
     m_graph->addVertex(pVertex);
 
 #ifdef OVERLAP_HAP_DEBUG
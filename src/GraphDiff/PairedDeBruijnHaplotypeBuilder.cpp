@@ -76,7 +76,7 @@ HaplotypeBuilderReturnCode PairedDeBruijnHaplotypeBuilder::run(StringVector& out
     StringGraph* pGraph = new StringGraph;
     BuilderExtensionQueue queue;
 
-    Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(m_startingKmer, m_startingKmer);
+    Vertex* pVertex = pGraph->createVertex(m_startingKmer, m_startingKmer);
     pVertex->setColor(GC_BLACK);
     pGraph->addVertex(pVertex);
 
@@ -140,7 +140,7 @@ HaplotypeBuilderReturnCode PairedDeBruijnHaplotypeBuilder::run(StringVector& out
                 continue;
             
             // Allocate the new vertex and add it to the graph
-            Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(newStr, newStr);
+            Vertex* pVertex = pGraph->createVertex(newStr, newStr);
             pVertex->setColor(GC_BLACK);
             pGraph->addVertex(pVertex);
 
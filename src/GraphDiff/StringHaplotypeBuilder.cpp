@@ -47,6 +47,8 @@ StringHaplotypeBuilder::StringHaplotypeBuilder(const GraphCompareParameters& par
     // k-mer based corrector params
     correction_params.numKmerRounds = 10;
     correction_params.kmerLength = 31;
+    correction_params.pKmerCache = NULL;
+    correction_params.pKmerTable = NULL;
     CorrectionThresholds::Instance().setBaseMinSupport(3);
 
     m_graph = new StringGraph;
@@ -105,7 +107,7 @@ HaplotypeBuilderReturnCode StringHaplotypeBuilder::run(StringVector& out_haploty
         return HBRC_OK;
 
     std::string seed = reads[seed_idx];
-    Vertex* seed_vertex = new(m_graph->getVertexAllocator()) Vertex(seed, seed);
+    Vertex* seed_vertex = m_graph->createVertex(seed, seed);
     m_graph->addVertex(seed_vertex);
 
     Vertex* right_endpoint = NULL;
@@ -177,7 +179,7 @@ Vertex* StringHaplotypeBuilder::extendSeed(Vertex* seed_vertex, EdgeDir directio
             if(incoming_vertex == NULL)
             {
                 // we need to add a new vertex in the graph for this sequence
-                incoming_vertex = new(m_graph->getVertexAllocator()) Vertex(incoming_sequence, incoming_sequence);
+                incoming_vertex = m_graph->createVertex(incoming_sequence, incoming_sequence);
                 m_graph->addVertex(incoming_vertex);
                 BuilderExtensionNode incoming_node(incoming_vertex, current_node.direction, current_node.distance + 1);
                 queue.push(incoming_node);
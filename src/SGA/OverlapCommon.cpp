@@ -24,48 +24,20 @@ void OverlapCommon::parseHitsString(const std::string& hitString,
                                     OverlapVector& outVector, 
                                     bool& isSubstring)
 {
-    OverlapVector outvec;
     std::istringstream convertor(hitString);
 
-    sumBlockSize = 0;
     // Read the overlap blocks for a read
     size_t numBlocks;
     convertor >> readIdx >> isSubstring >> numBlocks;
 
-    //std::cout << "<Read> idx: " << readIdx << " count: " << numBlocks << "\n";
+    OverlapBlockList blocks;
     for(size_t i = 0; i < numBlocks; ++i)
     {
         // Read the block
         OverlapBlock record;
         convertor >> record;
-        //std::cout << "\t" << record << "\n";
-
-        // Iterate through the range and write the overlaps
-        for(int64_t j = record.ranges.interval[0].lower; j <= record.ranges.interval[0].upper; ++j)
-        {
-            sumBlockSize += 1;
-            const SuffixArray* pCurrSAI = (record.flags.isTargetRev()) ? pRevSAI : pFwdSAI;
-            const ReadInfo& queryInfo = pQueryRIT->getReadInfo(readIdx);
-
-            int64_t saIdx = j;
-
-            // The index of the second read is given as the position in the SuffixArray index
-            const ReadInfo& targetInfo = pTargetRIT->getReadInfo(pCurrSAI->get(saIdx).getID());
-
-            // Skip self alignments and non-canonical (where the query read has a lexo. higher name)
-            if(queryInfo.id != targetInfo.id)
-            {    
-                Overlap o = record.toOverlap(queryInfo.id, targetInfo.id, queryInfo.length, targetInfo.length);
-
-                // The alignment logic above has the potential to produce duplicate alignments
-                // To avoid this, we skip overlaps where the id of the first coord is lexo. lower than 
-                // the second or the match is a containment and the query is reversed (containments can be 
-                // output up to 4 times total).
-                if(bCheckIDs && (o.id[0] < o.id[1] || (o.match.isContainment() && record.flags.isQueryRev())))
-                    continue;
-
-                outVector.push_back(o);
-            }
-        }
+        blocks.push_back(record);
     }
+
+    convertBlocksToOverlaps(readIdx, blocks, pQueryRIT, pTargetRIT, pFwdSAI, pRevSAI, bCheckIDs, sumBlockSize, outVector);
 }
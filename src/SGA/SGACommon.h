@@ -14,10 +14,12 @@
 // File extensions
 #define OVR_EXT ".ovr"
 #define HITS_EXT ".hits"
+#define EDGES_EXT ".edges"
 #define RMDUPHITS_EXT ".rmhits"
 #define GMAPHITS_EXT ".gmhits"
 #define CTN_EXT ".ctn"
 #define ASQG_EXT ".asqg"
+#define BSQG_EXT ".bsqg"
 #define SA_EXT ".sa"
 #define RSA_EXT ".rsa"
 #define BWT_EXT ".bwt"
@@ -26,6 +28,9 @@
 #define RSAI_EXT ".rsai"
 #define SSA_EXT ".ssa"
 #define POPIDX_EXT ".popidx"
+#define IC_EXT ".bwt.ic"
+#define BSBWT_EXT ".bs.bwt"
+#define BSSAI_EXT ".bs.sai"
 
 // Default values
 #define DEFAULT_MIN_OVERLAP 45
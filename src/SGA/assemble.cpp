@@ -8,6 +8,7 @@
 //
 #include <iostream>
 #include <fstream>
+#include <sys/resource.h>
 #include "Util.h"
 #include "assemble.h"
 #include "SGUtil.h"
@@ -15,6 +16,8 @@
 #include "SGVisitors.h"
 #include "Timer.h"
 #include "EncodedString.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/filestream.h"
 
 //
 // Getopt
@@ -33,11 +36,14 @@ static const char *ASSEMBLE_USAGE_MESSAGE =
 "  -v, --verbose                        display verbose output\n"
 "      --help                           display this help and exit\n"
 "      -o, --out-prefix=NAME            use NAME as the prefix of the output files (output files will be NAME-contigs.fa, etc)\n"
+"      -t, --threads=NUM                use NUM threads to parse the ASQGFILE and to clean the graph (default: 1)\n"
 "      -m, --min-overlap=LEN            only use overlaps of at least LEN. This can be used to filter\n"
 "                                       the overlap set so that the overlap step only needs to be run once.\n"
 "          --transitive-reduction       remove transitive edges from the graph. Off by default.\n"
 "          --max-edges=N                limit each vertex to a maximum of N edges. For highly repetitive regions\n"
 "                                       this helps save memory by culling excessive edges around unresolvable repeats (default: 128)\n"
+"          --binary                     write the final graph as a binary BSQG file (NAME-graph.bsqg)\n"
+"          --report=FILE                write the time, memory use and graph statistics of each phase as JSON to FILE\n"
 "\nBubble/Variation removal parameters:\n"
 "      -b, --bubble=N                   perform N bubble removal steps (default: 3)\n"
 "      -d, --max-divergence=F           only remove variation if the divergence between sequences is less than F (default: 0.05)\n"
@@ -61,6 +67,8 @@ namespace opt
     static std::string outContigsFile;
     static std::string outVariantsFile;
     static std::string outGraphFile;
+    static std::string reportFile;
+    static int numThreads = 1;
 
     static unsigned int minOverlap;
     static bool bEdgeStats = false;
@@ -82,15 +90,17 @@ namespace opt
     static bool bValidate;
     static bool bExact = true;
     static bool bPerformTR = false;
+    static bool bBinaryGraph = false;
 }
 
-static const char* shortopts = "p:o:m:d:g:b:a:r:x:l:sv";
+static const char* shortopts = "p:o:m:d:g:b:a:r:x:l:t:sv";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_VALIDATE, OPT_EDGESTATS, OPT_EXACT, OPT_MAXINDEL, OPT_TR, OPT_MAXEDGES };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_VALIDATE, OPT_EDGESTATS, OPT_EXACT, OPT_MAXINDEL, OPT_TR, OPT_MAXEDGES, OPT_BINARY, OPT_REPORT };
 
 static const struct option longopts[] = {
     { "verbose",               no_argument,       NULL, 'v' },
     { "out-prefix",            required_argument, NULL, 'o' },
+    { "threads",               required_argument, NULL, 't' },
     { "min-overlap",           required_argument, NULL, 'm' },
     { "bubble",                required_argument, NULL, 'b' },
     { "cut-terminal",          required_argument, NULL, 'x' },
@@ -103,6 +113,8 @@ static const struct option longopts[] = {
     { "smooth",                no_argument,       NULL, 's' },
     { "transitive-reduction",  no_argument,       NULL, OPT_TR },
     { "edge-stats",            no_argument,       NULL, OPT_EDGESTATS },
+    { "binary",                no_argument,       NULL, OPT_BINARY },
+    { "report",                required_argument, NULL, OPT_REPORT },
     { "exact",                 no_argument,       NULL, OPT_EXACT },
     { "help",                  no_argument,       NULL, OPT_HELP },
     { "version",               no_argument,       NULL, OPT_VERSION },
@@ -110,6 +122,110 @@ static const struct option longopts[] = {
     { NULL, 0, NULL, 0 }
 };
 
+// Record of the time taken, memory used and graph
+// statistics at the end of each phase of the assembly
+class PhaseReport
+{
+    public:
+
+        PhaseReport() : m_timer("phase", true) {}
+
+        // Record the end of a phase. The time is measured from
+        // the end of the previous phase.
+        void add(const std::string& name, StringGraph* pGraph)
+        {
+            Phase phase;
+            phase.name = name;
+            phase.wallTime = m_timer.getElapsedWallTime();
+            phase.cpuTime = m_timer.getElapsedCPUTime();
+            phase.stats = pGraph->getStats();
+            phase.vertexBytes = pGraph->getVertexAllocator()->getLiveBytes();
+            phase.edgeBytes = pGraph->getEdgeAllocator()->getLiveBytes();
+            phase.poolBytes = pGraph->getVertexAllocator()->getReservedBytes() + 
+                              pGraph->getEdgeAllocator()->getReservedBytes();
+
+            // ru_maxrss is in kilobytes
+            struct rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+            phase.maxRSSBytes = (size_t)usage.ru_maxrss * 1024;
+
+            m_phases.push_back(phase);
+            m_timer.reset();
+        }
+
+        // Write the phases to filename as JSON
+        void write(const std::string& filename) const
+        {
+            FILE* pFile = fopen(filename.c_str(), "w");
+            if(pFile == NULL)
+            {
+                std::cerr << "Error: could not open " << filename << " for write\n";
+                exit(EXIT_FAILURE);
+            }
+
+            rapidjson::FileStream f(pFile);
+            rapidjson::PrettyWriter<rapidjson::FileStream> writer(f);
+            writer.StartObject();
+            writer.String("phases");
+            writer.StartArray();
+            for(size_t i = 0; i < m_phases.size(); ++i)
+            {
+                const Phase& phase = m_phases[i];
+                writer.StartObject();
+                writer.String("name");
+                writer.String(phase.name.c_str());
+                writer.String("wall_time");
+                writer.Double(phase.wallTime);
+                writer.String("cpu_time");
+                writer.Double(phase.cpuTime);
+                writer.String("vertices");
+                writer.Uint64(phase.stats.numVertices);
+                writer.String("edges");
+                writer.Uint64(phase.stats.numEdges);
+                writer.String("islands");
+                writer.Uint64(phase.stats.numIslands);
+                writer.String("tips");
+                writer.Uint64(phase.stats.numTips);
+                writer.String("monobranch");
+                writer.Uint64(phase.stats.numMonobranch);
+                writer.String("dibranch");
+                writer.Uint64(phase.stats.numDibranch);
+                writer.String("simple");
+                writer.Uint64(phase.stats.numSimple);
+                writer.String("vertex_bytes");
+                writer.Uint64(phase.vertexBytes);
+                writer.String("edge_bytes");
+                writer.Uint64(phase.edgeBytes);
+                writer.String("pool_bytes");
+                writer.Uint64(phase.poolBytes);
+                writer.String("max_rss_bytes");
+                writer.Uint64(phase.maxRSSBytes);
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+            fprintf(pFile, "\n");
+            fclose(pFile);
+        }
+
+    private:
+
+        struct Phase
+        {
+            std::string name;
+            double wallTime;
+            double cpuTime;
+            GraphStats stats;
+            size_t vertexBytes;
+            size_t edgeBytes;
+            size_t poolBytes;
+            size_t maxRSSBytes;
+        };
+
+        Timer m_timer;
+        std::vector<Phase> m_phases;
+};
+
 //
 // Main
 //
@@ -126,45 +242,51 @@ int assembleMain(int argc, char** argv)
 void assemble()
 {
     Timer t("sga assemble");
-    StringGraph* pGraph = SGUtil::loadASQG(opt::asqgFile, opt::minOverlap, true, opt::maxEdges);
+    PhaseReport report;
+    StringGraph* pGraph = SGUtil::loadASQG(opt::asqgFile, opt::minOverlap, true, opt::maxEdges, opt::numThreads);
     if(opt::bExact)
         pGraph->setExactMode(true);
     pGraph->printMemSize();
+    report.add("load", pGraph);
 
     // Visitor functors
     SGTransitiveReductionVisitor trVisit;
-    SGGraphStatsVisitor statsVisit;
     SGTrimVisitor trimVisit(opt::trimLengthThreshold);
     SGContainRemoveVisitor containVisit;
     SGValidateStructureVisitor validationVisit;
 
     // Pre-assembly graph stats
     std::cout << "[Stats] Input graph:\n";
-    pGraph->visit(statsVisit);    
+    pGraph->printStats();
 
     // Remove containments from the graph
     std::cout << "Removing contained vertices from graph\n";
     while(pGraph->hasContainment())
-        pGraph->visit(containVisit);
+        pGraph->visitParallel(containVisit, opt::numThreads);
 
     // Pre-assembly graph stats
     std::cout << "[Stats] After removing contained vertices:\n";
-    pGraph->visit(statsVisit);    
+    pGraph->printStats();
+    report.add("remove-contained", pGraph);
 
     // Remove any extraneous transitive edges that may remain in the graph
     if(opt::bPerformTR)
     {
         std::cout << "Removing transitive edges\n";
-        pGraph->visit(trVisit);
+        Timer trTimer("transitive reduction");
+        pGraph->visitParallel(trVisit, opt::numThreads);
+        report.add("transitive-reduction", pGraph);
     }
 
     // Compact together unbranched chains of vertices
-    pGraph->simplify();
+    pGraph->simplify(opt::numThreads);
+    report.add("simplify", pGraph);
     
     if(opt::bValidate)
     {
         std::cout << "Validating graph structure\n";
         pGraph->visit(validationVisit);
+        pGraph->validate();
     }
 
     // Remove dead-end branches from the graph
@@ -173,9 +295,10 @@ void assemble()
         std::cout << "Trimming bad vertices\n"; 
         int numTrims = opt::numTrimRounds;
         while(numTrims-- > 0)
-           pGraph->visit(trimVisit);
+           pGraph->visitParallel(trimVisit, opt::numThreads);
         std::cout << "\n[Stats] Graph after trimming:\n";
-        pGraph->visit(statsVisit);
+        pGraph->printStats();
+        report.add("trim", pGraph);
     }
 
     // Resolve small repeats
@@ -189,11 +312,13 @@ void assemble()
             std::cout << "Finished small repeat resolve round " << totalSmallRepeatRounds++ << "\n";
         
         std::cout << "\n[Stats] After small repeat resolution:\n";
-        pGraph->visit(statsVisit);
+        pGraph->printStats();
+        report.add("resolve-small-repeats", pGraph);
     }
 
     // Peform another round of simplification
-    pGraph->simplify();
+    pGraph->simplify(opt::numThreads);
+    report.add("simplify", pGraph);
     
     if(opt::numBubbleRounds > 0)
     {
@@ -202,13 +327,15 @@ void assemble()
         int numSmooth = opt::numBubbleRounds;
         while(numSmooth-- > 0)
             pGraph->visit(smoothingVisit);
-        pGraph->simplify();
+        pGraph->simplify(opt::numThreads);
+        report.add("smooth-variation", pGraph);
     }
     
     pGraph->renameVertices("contig-");
 
     std::cout << "\n[Stats] Final graph:\n";
-    pGraph->visit(statsVisit);
+    pGraph->printStats();
+    pGraph->printMemSize();
 
     // Rename the vertices to have contig IDs instead of read IDs
     //pGraph->renameVertices("contig-");
@@ -217,7 +344,14 @@ void assemble()
     SGFastaVisitor av(opt::outContigsFile);
     pGraph->visit(av);
 
-    pGraph->writeASQG(opt::outGraphFile);
+    if(opt::bBinaryGraph)
+        pGraph->writeBSQG(opt::outGraphFile);
+    else
+        pGraph->writeASQG(opt::outGraphFile);
+    report.add("write", pGraph);
+
+    if(!opt::reportFile.empty())
+        report.write(opt::reportFile);
 
     delete pGraph;
 }
@@ -238,6 +372,7 @@ void parseAssembleOptions(int argc, char** argv)
         {
             case 'o': arg >> prefix; break;
             case 'm': arg >> opt::minOverlap; break;
+            case 't': arg >> opt::numThreads; break;
             case '?': die = true; break;
             case 'v': opt::verbose++; break;
             case 'l': arg >> opt::trimLengthThreshold; break;
@@ -249,6 +384,8 @@ void parseAssembleOptions(int argc, char** argv)
             case 'r': arg >> opt::resolveSmallRepeatLen; break;
             case OPT_MAXEDGES: arg >> opt::maxEdges; break;
             case OPT_TR: opt::bPerformTR = true; break;
+            case OPT_BINARY: opt::bBinaryGraph = true; break;
+            case OPT_REPORT: arg >> opt::reportFile; break;
             case OPT_MAXINDEL: arg >> opt::maxIndelLength; break;
             case OPT_EXACT: opt::bExact = true; break;
             case OPT_EDGESTATS: opt::bEdgeStats = true; break;
@@ -266,7 +403,10 @@ void parseAssembleOptions(int argc, char** argv)
     // Build the output names
     opt::outContigsFile = prefix + "-contigs.fa";
     opt::outVariantsFile = prefix + "-variants.fa";
-    opt::outGraphFile = prefix + "-graph.asqg.gz";
+    if(opt::bBinaryGraph)
+        opt::outGraphFile = prefix + "-graph.bsqg";
+    else
+        opt::outGraphFile = prefix + "-graph.asqg.gz";
 
     if (argc - optind < 1) 
     {
@@ -279,6 +419,12 @@ void parseAssembleOptions(int argc, char** argv)
         die = true;
     }
 
+    if(opt::numThreads <= 0)
+    {
+        std::cerr << SUBPROGRAM ": invalid number of threads: " << opt::numThreads << "\n";
+        die = true;
+    }
+
     if (die) 
     {
         std::cout << "\n" << ASSEMBLE_USAGE_MESSAGE;
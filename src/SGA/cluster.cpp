@@ -36,9 +36,9 @@ void readLimitKmers(std::set<std::string>* limit_kmers);
                                                                          ClusterReader, ClusterProcess, \
                                                                          ClusterPostProcess>
 
-#define PROCESS_EXTEND_PARALLEL SequenceProcessFramework::processWorkParallelPthread<ClusterVector, ClusterResult, \
-                                                                                     ClusterReader, ClusterProcess, \
-                                                                                     ClusterPostProcess>
+#define PROCESS_EXTEND_PARALLEL SequenceProcessFramework::processWorkParallelStealing<ClusterVector, ClusterResult, \
+                                                                                      ClusterReader, ClusterProcess, \
+                                                                                      ClusterPostProcess>
 //
 // Getopt
 //
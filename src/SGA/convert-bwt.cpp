@@ -0,0 +1,169 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// convert-bwt - Rewrite a BWT file into an alternative
+// on-disk layout
+//
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include "SGACommon.h"
+#include "Util.h"
+#include "convert-bwt.h"
+#include "BWT.h"
+#include "BWTWriterBinary.h"
+#include "Timer.h"
+
+//
+// Getopt
+//
+#define SUBPROGRAM "convert-bwt"
+
+static const char *CONVERTBWT_VERSION_MESSAGE =
+SUBPROGRAM " Version " PACKAGE_VERSION "\n"
+"\n"
+"Copyright 2013 Wellcome Trust Sanger Institute\n";
+
+static const char *CONVERTBWT_USAGE_MESSAGE =
+"Usage: " PACKAGE_NAME " " SUBPROGRAM " [OPTION] ... BWTFILE\n"
+"Rewrite BWTFILE with its FM-index embedded so that it can be memory-mapped when loaded.\n"
+"Mapped indices are shared between all processes on a machine that use the same file\n"
+"and do not need to be rebuilt at startup.\n"
+"\n"
+"  -v, --verbose                        display verbose output\n"
+"      --help                           display this help and exit\n"
+"  -o, --outfile=FILE                   write the converted BWT to FILE (default: overwrite BWTFILE)\n"
+"  -f, --format=STR                     the layout of the converted file. STR can be:\n"
+"                                       mmap - the run-length encoded BWT followed by its FM-index markers. This file\n"
+"                                              can still be read by all sga programs (default)\n"
+"                                       block - the cache-line blocked FM-index. This file can only be read when sga\n"
+"                                               is configured with --enable-block-bwt\n"
+"  -d, --sample-rate=N                  sample the symbol counts every N symbols in the FM-index. Programs\n"
+"                                       loading the BWT with a different sample rate rebuild the markers\n"
+"                                       in memory. This option only applies to -f mmap (default: 128)\n"
+"\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
+
+namespace opt
+{
+    static unsigned int verbose;
+    static std::string bwtFile;
+    static std::string outFile;
+    static std::string format = "mmap";
+    static int sampleRate = RLBWT::DEFAULT_SAMPLE_RATE_SMALL;
+}
+
+static const char* shortopts = "o:f:d:v";
+
+enum { OPT_HELP = 1, OPT_VERSION };
+
+static const struct option longopts[] = {
+    { "verbose",     no_argument,       NULL, 'v' },
+    { "outfile",     required_argument, NULL, 'o' },
+    { "format",      required_argument, NULL, 'f' },
+    { "sample-rate", required_argument, NULL, 'd' },
+    { "help",        no_argument,       NULL, OPT_HELP },
+    { "version",     no_argument,       NULL, OPT_VERSION },
+    { NULL, 0, NULL, 0 }
+};
+
+int convertBWTMain(int argc, char** argv)
+{
+    Timer t("sga convert-bwt");
+    parseConvertBWTOptions(argc, argv);
+
+    // Write to a temporary file as the input may be mapped
+    std::string tmpFile = opt::outFile + ".tmp";
+    BWTWriterBinary* pWriter = new BWTWriterBinary(tmpFile);
+    if(opt::format == "block")
+    {
+        BlockBWT* pBWT = new BlockBWT(opt::bwtFile);
+        if(opt::verbose > 0)
+            pBWT->printInfo();
+        pWriter->write(pBWT);
+        delete pBWT;
+    }
+    else
+    {
+        RLBWT* pBWT = new RLBWT(opt::bwtFile, opt::sampleRate);
+        if(opt::verbose > 0)
+            pBWT->printInfo();
+        pWriter->write(pBWT);
+        delete pBWT;
+    }
+    delete pWriter;
+
+    if(rename(tmpFile.c_str(), opt::outFile.c_str()) != 0)
+    {
+        std::cerr << "Error: could not rename " << tmpFile << " to " << opt::outFile << "\n";
+        exit(EXIT_FAILURE);
+    }
+    return 0;
+}
+
+// 
+// Handle command line arguments
+//
+void parseConvertBWTOptions(int argc, char** argv)
+{
+    bool die = false;
+    for (char c; (c = getopt_long(argc, argv, shortopts, longopts, NULL)) != -1;) 
+    {
+        std::istringstream arg(optarg != NULL ? optarg : "");
+        switch (c) 
+        {
+            case 'o': arg >> opt::outFile; break;
+            case 'f': arg >> opt::format; break;
+            case 'd': arg >> opt::sampleRate; break;
+            case '?': die = true; break;
+            case 'v': opt::verbose++; break;
+            case OPT_HELP:
+                std::cout << CONVERTBWT_USAGE_MESSAGE;
+                exit(EXIT_SUCCESS);
+            case OPT_VERSION:
+                std::cout << CONVERTBWT_VERSION_MESSAGE;
+                exit(EXIT_SUCCESS);
+        }
+    }
+
+    if (argc - optind < 1) 
+    {
+        std::cerr << SUBPROGRAM ": missing arguments\n";
+        die = true;
+    } 
+    else if (argc - optind > 1) 
+    {
+        std::cerr << SUBPROGRAM ": too many arguments\n";
+        die = true;
+    }
+
+    if(opt::format != "mmap" && opt::format != "block")
+    {
+        std::cerr << SUBPROGRAM ": unrecognized format " << opt::format << ". --format must be mmap or block\n";
+        die = true;
+    }
+
+    if(opt::sampleRate <= 0 || (opt::sampleRate & (opt::sampleRate - 1)) != 0)
+    {
+        std::cerr << SUBPROGRAM ": the sample rate must be a power of 2\n";
+        die = true;
+    }
+
+    if (die) 
+    {
+        std::cout << "\n" << CONVERTBWT_USAGE_MESSAGE;
+        exit(EXIT_FAILURE);
+    }
+
+    // Parse the input filenames
+    opt::bwtFile = argv[optind++];
+    if(opt::outFile.empty())
+        opt::outFile = opt::bwtFile;
+
+    if(isGzip(opt::outFile))
+    {
+        std::cerr << SUBPROGRAM ": compressed BWT files cannot be memory-mapped, please specify an uncompressed output file\n";
+        exit(EXIT_FAILURE);
+    }
+}
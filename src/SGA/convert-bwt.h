@@ -0,0 +1,17 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// convert-bwt - Rewrite a BWT file into an alternative
+// on-disk layout
+//
+#ifndef CONVERTBWT_H
+#define CONVERTBWT_H
+#include <getopt.h>
+#include "config.h"
+
+int convertBWTMain(int argc, char** argv);
+void parseConvertBWTOptions(int argc, char** argv);
+
+#endif
@@ -25,6 +25,7 @@
 #include "CorrectionThresholds.h"
 #include "KmerDistribution.h"
 #include "BWTIntervalCache.h"
+#include "KmerCountTable.h"
 #include "LRAlignment.h"
 
 // Functions
@@ -62,6 +63,14 @@ static const char *CORRECT_USAGE_MESSAGE =
 "      -i, --kmer-rounds=N              Perform N rounds of k-mer correction, correcting up to N bases (default: 10)\n"
 "      -O, --count-offset=N             When correcting a kmer, require the count of the new kmer is at least +N higher than the count of the old kmer. (default: 1)\n"
 "          --learn                      Attempt to learn the k-mer correction threshold (experimental). Overrides -x parameter.\n"
+"          --kmer-cache=SIZE            share the counts of kmers between reads and threads in a cache of at most SIZE MB.\n"
+"                                       The hit rate of the cache is reported at the end of the run (default: 0, no cache)\n"
+"          --kmer-table=FILE            read the kmer counts from FILE, built by sga kmer-count --table, instead of searching\n"
+"                                       the FM-index. The table must have been built with the same kmer size. Counts above 255\n"
+"                                       are read as 255 and the kmers left out by kmer-count --min-count are read as 0.\n"
+"                                       The kmer threshold plus the count offset (-O) must be at most 255\n"
+"          --use-reverse                also load the reverse index (PREFIX.rbwt) and use it to count all the kmers of a read\n"
+"                                       in one pass. This is faster but the reverse index takes as much memory as the forward index\n"
 "\nOverlap correction parameters:\n"
 "      -e, --error-rate                 the maximum error rate allowed between two sequences to consider them overlapped (default: 0.04)\n"
 "      -m, --min-overlap=LEN            minimum overlap required between two reads (default: 45)\n"
@@ -111,6 +120,9 @@ namespace opt
     static int kmerThreshold = 3;
     static int numKmerRounds = 10;
     static bool bLearnKmerParams = false;
+    static bool bUseReverseIndex = false;
+    static size_t kmerCacheSize = 0;
+    static std::string kmerTableFile;
     static int intervalCacheLength = 10;
 
     static ErrorCorrectAlgorithm algorithm = ECA_KMER;
@@ -118,7 +130,7 @@ namespace opt
 
 static const char* shortopts = "p:m:M:O:d:e:t:l:s:o:r:b:a:c:k:x:X:i:v";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_METRICS, OPT_DISCARD, OPT_LEARN };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_METRICS, OPT_DISCARD, OPT_LEARN, OPT_USE_REVERSE, OPT_KMER_CACHE, OPT_KMER_TABLE };
 
 static const struct option longopts[] = {
     { "verbose",       no_argument,       NULL, 'v' },
@@ -141,6 +153,9 @@ static const struct option longopts[] = {
     { "base-threshold",required_argument, NULL, 'X' },
     { "kmer-rounds",   required_argument, NULL, 'i' },
     { "learn",         no_argument,       NULL, OPT_LEARN },
+    { "use-reverse",   no_argument,       NULL, OPT_USE_REVERSE },
+    { "kmer-cache",    required_argument, NULL, OPT_KMER_CACHE },
+    { "kmer-table",    required_argument, NULL, OPT_KMER_TABLE },
     { "discard",       no_argument,       NULL, OPT_DISCARD },
     { "help",          no_argument,       NULL, OPT_HELP },
     { "version",       no_argument,       NULL, OPT_VERSION },
@@ -165,7 +180,25 @@ int correctMain(int argc, char** argv)
     if(opt::algorithm == ECA_OVERLAP || opt::algorithm == ECA_HYBRID)
         pSSA = new SampledSuffixArray(opt::prefix + SAI_EXT, SSA_FT_SAI);
 
-    BWTIntervalCache* pIntervalCache = new BWTIntervalCache(opt::intervalCacheLength, pBWT);
+    // The kmer corrector reads the counts from the kmer table, if given
+    KmerCountTable* pKmerTable = NULL;
+    if(!opt::kmerTableFile.empty() && opt::algorithm != ECA_OVERLAP)
+    {
+        pKmerTable = new KmerCountTable(opt::kmerTableFile, pBWT);
+        if((int)pKmerTable->getKmerLength() != opt::kmerLength)
+        {
+            std::cerr << SUBPROGRAM ": the kmer table " << opt::kmerTableFile << " was built for k = " << pKmerTable->getKmerLength() 
+                      << ", not the kmer size " << opt::kmerLength << "\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Otherwise it can use the reverse index to count
+    // overlapping kmers together
+    if((opt::algorithm == ECA_KMER || opt::algorithm == ECA_HYBRID) && opt::bUseReverseIndex && pKmerTable == NULL)
+        pRBWT = new BWT(opt::prefix + RBWT_EXT, opt::sampleRate);
+
+    BWTIntervalCache* pIntervalCache = BWTIntervalCache::load(opt::prefix + IC_EXT, opt::intervalCacheLength, pBWT, NULL, opt::numThreads);
 
     BWTIndexSet indexSet;
     indexSet.pBWT = pBWT;
@@ -181,6 +214,30 @@ int correctMain(int argc, char** argv)
             CorrectionThresholds::Instance().setBaseMinSupport(threshold);
     }
 
+    // A kmer is trusted if it is seen at least as often as the required support,
+    // which may have been learned above. The kmers that were not added to the
+    // table read as zero so they must be untrusted at every support level, and
+    // the count a correction must reach, at most the support plus the count
+    // offset, must not be above the count at which the table saturates.
+    if(pKmerTable != NULL)
+    {
+        int minSupport = CorrectionThresholds::Instance().getMinSupportHighQuality();
+        int maxSupport = CorrectionThresholds::Instance().getMinSupportLowQuality();
+        if((int)pKmerTable->getMinCount() > minSupport)
+        {
+            std::cerr << SUBPROGRAM ": the kmer table " << opt::kmerTableFile << " only holds kmers seen at least " 
+                      << pKmerTable->getMinCount() << " times, which is too few for a kmer threshold of " << minSupport << "\n";
+            exit(EXIT_FAILURE);
+        }
+
+        if(maxSupport + (int)opt::countOffset > (int)KmerCountTable::MAX_COUNT)
+        {
+            std::cerr << SUBPROGRAM ": the kmer threshold (" << maxSupport << ") plus the count offset (" << opt::countOffset 
+                      << ") must be at most " << KmerCountTable::MAX_COUNT << " to use a kmer table\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+
     // Open outfiles and start a timer
     std::ostream* pWriter = createWriter(opt::outFile);
     std::ostream* pDiscardWriter = (!opt::discardFile.empty() ? createWriter(opt::discardFile) : NULL);
@@ -203,6 +260,10 @@ int correctMain(int argc, char** argv)
 
     ecParams.numKmerRounds = opt::numKmerRounds;
     ecParams.kmerLength = opt::kmerLength;
+    ecParams.pKmerTable = pKmerTable;
+    ecParams.pKmerCache = NULL;
+    if(opt::kmerCacheSize > 0 && opt::algorithm != ECA_OVERLAP && pKmerTable == NULL)
+        ecParams.pKmerCache = new KmerCountCache(opt::kmerLength, opt::kmerCacheSize * 1024 * 1024);
     ecParams.printOverlaps = opt::verbose > 0;
 
 	 printf("ecParams.min_count_max_base = %d\n",ecParams.min_count_max_base);
@@ -250,6 +311,13 @@ int correctMain(int argc, char** argv)
         delete pMetricsWriter;
     }
 
+    if(ecParams.pKmerCache != NULL)
+    {
+        ecParams.pKmerCache->printStats();
+        delete ecParams.pKmerCache;
+    }
+
+    delete pKmerTable;
     delete pBWT;
     delete pIntervalCache;
     if(pRBWT != NULL)
@@ -353,6 +421,9 @@ void parseCorrectOptions(int argc, char** argv)
             case 'b': arg >> opt::branchCutoff; break;
             case 'i': arg >> opt::numKmerRounds; break;
             case OPT_LEARN: opt::bLearnKmerParams = true; break;
+            case OPT_USE_REVERSE: opt::bUseReverseIndex = true; break;
+            case OPT_KMER_CACHE: arg >> opt::kmerCacheSize; break;
+            case OPT_KMER_TABLE: arg >> opt::kmerTableFile; break;
             case OPT_DISCARD: bDiscardReads = true; break;
             case OPT_METRICS: arg >> opt::metricsFile; break;
             case OPT_HELP:
@@ -399,12 +470,25 @@ void parseCorrectOptions(int argc, char** argv)
         die = true;
     }
 
+    if(opt::kmerCacheSize > 0 && opt::kmerLength > KmerCountCache::MAX_KMER_LENGTH)
+    {
+        std::cerr << SUBPROGRAM ": the kmer cache requires a kmer length of at most " << KmerCountCache::MAX_KMER_LENGTH << "\n";
+        die = true;
+    }
+
     if(opt::kmerThreshold <= 0)
     {
         std::cerr << SUBPROGRAM ": invalid kmer threshold: " << opt::kmerThreshold << ", must be greater than zero\n";
         die = true;
     }
 
+    if(!opt::kmerTableFile.empty() && opt::kmerThreshold + (int)opt::countOffset > (int)KmerCountTable::MAX_COUNT)
+    {
+        std::cerr << SUBPROGRAM ": the kmer threshold (" << opt::kmerThreshold << ") plus the count offset (" << opt::countOffset 
+                  << ") must be at most " << KmerCountTable::MAX_COUNT << " to use a kmer table\n";
+        die = true;
+    }
+
     if(opt::base_threshold <= 0)
     {
         std::cerr << SUBPROGRAM ": invalid base threshold: " << opt::base_threshold << ", must be greater than zero\n";
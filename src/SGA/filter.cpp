@@ -24,6 +24,7 @@
 #include "QCProcess.h"
 #include "BWTDiskConstruction.h"
 #include "BitVector.h"
+#include "KmerCountTable.h"
 
 // Defines
 #define PROCESS_FILTER_SERIAL SequenceProcessFramework::processSequencesSerial<SequenceWorkItem, QCResult, \
@@ -67,6 +68,9 @@ static const char *FILTER_USAGE_MESSAGE =
 "\nK-mer filter options:\n"
 "      -k, --kmer-size=N                The length of the kmer to use. (default: 27)\n"
 "      -x, --kmer-threshold=N           Require at least N kmer coverage for each kmer in a read. (default: 3)\n"
+"          --kmer-table=FILE            read the kmer counts from FILE, built by sga kmer-count --table, instead of searching\n"
+"                                       the FM-index. The table must have been built with the same kmer size and a --min-count\n"
+"                                       of at most N+1. It is not used with --kmer-both-strand\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 static const char* PROGRAM_IDENT =
@@ -91,11 +95,12 @@ namespace opt
 
     static int kmerLength = 27;
     static int kmerThreshold = 3;
+    static std::string kmerTableFile;
 }
 
 static const char* shortopts = "p:d:t:o:k:x:v";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_SUBSTRING_ONLY, OPT_NO_RMDUP, OPT_NO_KMER, OPT_KMER_BOTH_STRAND, OPT_CHECK_HPRUNS, OPT_CHECK_COMPLEXITY };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_SUBSTRING_ONLY, OPT_NO_RMDUP, OPT_NO_KMER, OPT_KMER_BOTH_STRAND, OPT_CHECK_HPRUNS, OPT_CHECK_COMPLEXITY, OPT_KMER_TABLE };
 
 static const struct option longopts[] = {
     { "verbose",               no_argument,       NULL, 'v' },
@@ -105,6 +110,7 @@ static const struct option longopts[] = {
     { "sample-rate",           required_argument, NULL, 'd' },
     { "kmer-size",             required_argument, NULL, 'k' },
     { "kmer-threshold",        required_argument, NULL, 'x' },
+    { "kmer-table",            required_argument, NULL, OPT_KMER_TABLE },
     { "help",                  no_argument,       NULL, OPT_HELP },
     { "version",               no_argument,       NULL, OPT_VERSION },
     { "no-duplicate-check",    no_argument,       NULL, OPT_NO_RMDUP },
@@ -128,6 +134,36 @@ int filterMain(int argc, char** argv)
     BWT* pBWT = new BWT(opt::prefix + BWT_EXT, opt::sampleRate);
     BWT* pRBWT = new BWT(opt::prefix + RBWT_EXT, opt::sampleRate);
     pBWT->printInfo();
+
+    // Use the interval cache written by sga index, if there is one
+    BWTIntervalCache* pCache = BWTIntervalCache::load(opt::prefix + IC_EXT, 0, pBWT, pRBWT);
+    if(pCache != NULL && !pCache->hasReverse())
+    {
+        delete pCache;
+        pCache = NULL;
+    }
+    
+    // The table holds the sum of the counts on both strands so it cannot be
+    // used to check the strands separately
+    KmerCountTable* pKmerTable = NULL;
+    if(!opt::kmerTableFile.empty() && opt::kmerCheck && !opt::kmerBothStrand)
+    {
+        pKmerTable = new KmerCountTable(opt::kmerTableFile, pBWT);
+        if((int)pKmerTable->getKmerLength() != opt::kmerLength)
+        {
+            std::cerr << SUBPROGRAM ": the kmer table " << opt::kmerTableFile << " was built for k = " << pKmerTable->getKmerLength() 
+                      << ", not the kmer size " << opt::kmerLength << "\n";
+            exit(EXIT_FAILURE);
+        }
+
+        // The kmers that were not added to the table must fail the check
+        if((int)pKmerTable->getMinCount() > opt::kmerThreshold + 1)
+        {
+            std::cerr << SUBPROGRAM ": the kmer table " << opt::kmerTableFile << " only holds kmers seen at least " 
+                      << pKmerTable->getMinCount() << " times, which is too few for a kmer threshold of " << opt::kmerThreshold << "\n";
+            exit(EXIT_FAILURE);
+        }
+    }
     
     std::ostream* pWriter = createWriter(opt::outFile);
     std::ostream* pDiscardWriter = createWriter(opt::discardFile);
@@ -143,6 +179,8 @@ int filterMain(int argc, char** argv)
     QCParameters params;
     params.pBWT = pBWT;
     params.pRevBWT = pRBWT;
+    params.pCache = pCache;
+    params.pKmerTable = pKmerTable;
     params.pSharedBV = pSharedBV;
 
     params.checkDuplicates = opt::dupCheck;
@@ -190,6 +228,8 @@ int filterMain(int argc, char** argv)
 
     delete pBWT;
     delete pRBWT;
+    delete pCache;
+    delete pKmerTable;
 
     if(pSharedBV != NULL)
         delete pSharedBV;
@@ -231,6 +271,7 @@ void parseFilterOptions(int argc, char** argv)
             case OPT_CHECK_HPRUNS: opt::hpCheck = true; break;
             case OPT_CHECK_COMPLEXITY: opt::lowComplexityCheck = true; break;
             case OPT_SUBSTRING_ONLY: opt::substringOnly = true; break;
+            case OPT_KMER_TABLE: arg >> opt::kmerTableFile; break;
             case '?': die = true; break;
             case 'v': opt::verbose++; break;
             case OPT_HELP:
@@ -271,6 +312,12 @@ void parseFilterOptions(int argc, char** argv)
         die = true;
     }
 
+    if(!opt::kmerTableFile.empty() && opt::kmerThreshold >= (int)KmerCountTable::MAX_COUNT)
+    {
+        std::cerr << SUBPROGRAM ": the kmer threshold must be less than " << KmerCountTable::MAX_COUNT << " to use a kmer table\n";
+        die = true;
+    }
+
     if (die) 
     {
         std::cout << "\n" << FILTER_USAGE_MESSAGE;
@@ -52,6 +52,9 @@ static const char *GAPFILL_USAGE_MESSAGE =
 "      -t, --threads=NUM                use NUM computation threads\n"
 "      -d, --sample-rate=N              use occurrence array sample rate of N in the FM-index. Higher values use significantly\n"
 "                                       less memory at the cost of higher runtime. This value must be a power of 2 (default: 128)\n"
+"      --both-strands                   load the index of both strands of the reads (PREFIX.bs.bwt, built by\n"
+"                                       sga index --both-strands). Each de Bruijn extension is found with one search\n"
+"                                       instead of one search for the k-mer and one for its reverse complement\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 //static const char* PROGRAM_IDENT = PACKAGE_NAME "::" SUBPROGRAM;
@@ -66,6 +69,7 @@ namespace opt
     static int kmerThreshold = 3;
     static int sampleRate = 128;
     static int cacheLength = 10;
+    static bool bBothStrands = false;
 
     static std::string scaffoldFile;
     static std::string prefix;
@@ -74,7 +78,7 @@ namespace opt
 
 static const char* shortopts = "o:s:e:t:x:p:s:d:v";
 
-enum { OPT_HELP = 1, OPT_VERSION };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_BOTH_STRANDS };
 
 static const struct option longopts[] = {
     { "verbose",       no_argument,       NULL, 'v' },
@@ -85,6 +89,7 @@ static const struct option longopts[] = {
     { "end-kmer",      required_argument, NULL, 'e' },
     { "kmer-threshold",required_argument, NULL, 'x' },
     { "sample-rate",   required_argument, NULL, 'd' },
+    { "both-strands",  no_argument,       NULL, OPT_BOTH_STRANDS },
     { "help",          no_argument,       NULL, OPT_HELP },
     { "version",       no_argument,       NULL, OPT_VERSION },
     { NULL, 0, NULL, 0 }
@@ -99,16 +104,17 @@ int gapfillMain(int argc, char** argv)
 
     // In the BWTs and create interval caches
     assert(!opt::prefix.empty());
-    BWT* pBWT = new BWT(opt::prefix + BWT_EXT, opt::sampleRate);
+    BWT* pBWT = new BWT(opt::prefix + (opt::bBothStrands ? BSBWT_EXT : BWT_EXT), opt::sampleRate);
     pBWT->printInfo();
 
-    BWTIntervalCache* pBWTCache = new BWTIntervalCache(opt::cacheLength, pBWT);
+    BWTIntervalCache* pBWTCache = new BWTIntervalCache(opt::cacheLength, pBWT, opt::numThreads);
 
     GapFillParameters parameters;
     parameters.pBWT = pBWT;
     parameters.pRevBWT = NULL;
     parameters.pBWTCache = pBWTCache;
     parameters.pRevBWTCache = NULL;
+    parameters.bothStrands = opt::bBothStrands;
     parameters.startKmer = opt::startKmer;
     parameters.endKmer = opt::endKmer;
     parameters.stride = opt::stride;
@@ -158,6 +164,7 @@ void parseGapFillOptions(int argc, char** argv)
             case 'd': arg >> opt::sampleRate; break;
             case '?': die = true; break;
             case 'v': opt::verbose++; break;
+            case OPT_BOTH_STRANDS: opt::bBothStrands = true; break;
             case OPT_HELP:
                 std::cout << GAPFILL_USAGE_MESSAGE;
                 exit(EXIT_SUCCESS);
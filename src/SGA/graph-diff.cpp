@@ -38,8 +38,8 @@ void preloadBloomFilter(const ReadTable* pReadTable, size_t k, BloomFilter* pBlo
 #define PROCESS_GDIFF_SERIAL SequenceProcessFramework::processSequencesSerial<SequenceWorkItem, GraphCompareResult, \
                                                                               GraphCompare, GraphCompareAggregateResults>
 
-#define PROCESS_GDIFF_PARALLEL SequenceProcessFramework::processSequencesParallelOpenMP<SequenceWorkItem, GraphCompareResult, \
-                                                                                        GraphCompare, GraphCompareAggregateResults>
+#define PROCESS_GDIFF_PARALLEL SequenceProcessFramework::processSequencesParallel<SequenceWorkItem, GraphCompareResult, \
+                                                                                  GraphCompare, GraphCompareAggregateResults>
 
    
 //
@@ -189,7 +189,7 @@ int graphDiffMain(int argc, char** argv)
     BWTIndexSet variantIndex;
     variantIndex.pBWT = new BWT(variantPrefix + BWT_EXT, opt::sampleRate);
     variantIndex.pSSA = new SampledSuffixArray(variantPrefix + SAI_EXT, SSA_FT_SAI);
-    variantIndex.pCache = new BWTIntervalCache(opt::cacheLength, variantIndex.pBWT);
+    variantIndex.pCache = BWTIntervalCache::load(variantPrefix + IC_EXT, opt::cacheLength, variantIndex.pBWT, NULL, opt::numThreads);
     if(opt::lowCoverage)
         variantIndex.pPopIdx = new PopulationIndex(variantPrefix + POPIDX_EXT);
 
@@ -223,7 +223,7 @@ int graphDiffMain(int argc, char** argv)
         std::string basePrefix = stripGzippedExtension(opt::baseFile);
         baseIndex.pBWT = new BWT(basePrefix + BWT_EXT, opt::sampleRate);
         baseIndex.pSSA = new SampledSuffixArray(basePrefix + SAI_EXT, SSA_FT_SAI);
-        baseIndex.pCache = new BWTIntervalCache(opt::cacheLength, baseIndex.pBWT);
+        baseIndex.pCache = BWTIntervalCache::load(basePrefix + IC_EXT, opt::cacheLength, baseIndex.pBWT, NULL, opt::numThreads);
         baseIndex.pQualityTable = new QualityTable();
 
         QualityTable* baseQuals = new QualityTable;
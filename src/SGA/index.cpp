@@ -21,6 +21,7 @@
 #include "BWTCABauerCoxRosone.h"
 #include "BWTCARopebwt.h"
 #include "SampledSuffixArray.h"
+#include "BWTIntervalCache.h"
 
 //
 // Getopt
@@ -57,6 +58,13 @@ static const char *INDEX_USAGE_MESSAGE =
 "                                       When this value is set to 32, the memory requirement is essentially deterministic and requires ~5N bytes where\n"
 "                                       N is the size of the FM-index of READS2.\n"
 "                                       The default value is 8.\n"
+"      --interval-cache=K               write the intervals of every k-mer of length K (at most 14) to PREFIX.bwt.ic.\n"
+"                                       sga correct, filter, kmer-count, graph-diff and preqc map this file instead of\n"
+"                                       computing the intervals themselves. The file takes 16*4^K bytes per index.\n"
+"      --both-strands                   build a single index of the reads and their reverse complements, written to\n"
+"                                       PREFIX.bs.bwt and PREFIX.bs.sai, instead of the forward and reverse indices. This index\n"
+"                                       supports bidirectional search on its own and is used by sga gapfill --both-strands.\n"
+"                                       Only -a sais is supported\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 namespace opt
@@ -73,11 +81,13 @@ namespace opt
     static bool bBuildSAI = true;
     static bool validate;
     static int gapArrayStorage = 4;
+    static int intervalCacheLength = 0;
+    static bool bBothStrands = false;
 }
 
 static const char* shortopts = "p:a:m:t:d:g:cv";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_NO_REVERSE, OPT_NO_FWD, OPT_NO_SAI };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_NO_REVERSE, OPT_NO_FWD, OPT_NO_SAI, OPT_INTERVAL_CACHE, OPT_BOTH_STRANDS };
 
 static const struct option longopts[] = {
     { "verbose",     no_argument,       NULL, 'v' },
@@ -90,6 +100,8 @@ static const struct option longopts[] = {
     { "no-reverse",  no_argument,       NULL, OPT_NO_REVERSE },
     { "no-forward",  no_argument,       NULL, OPT_NO_FWD },
     { "no-sai",      no_argument,       NULL, OPT_NO_SAI },
+    { "interval-cache", required_argument, NULL, OPT_INTERVAL_CACHE },
+    { "both-strands", no_argument,     NULL, OPT_BOTH_STRANDS },
     { "help",        no_argument,       NULL, OPT_HELP },
     { "version",     no_argument,       NULL, OPT_VERSION },
     { NULL, 0, NULL, 0 }
@@ -99,7 +111,11 @@ int indexMain(int argc, char** argv)
 {
     Timer t("sga index");
     parseIndexOptions(argc, argv);
-    if(!opt::bDiskAlgo)
+    if(opt::bBothStrands)
+    {
+        indexBothStrandsSAIS();
+    }
+    else if(!opt::bDiskAlgo)
     {
         if(opt::algorithm == "sais")
             indexInMemorySAIS();
@@ -112,9 +128,35 @@ int indexMain(int argc, char** argv)
     {
         indexOnDisk();
     }
+
+    if(opt::intervalCacheLength > 0)
+        writeIntervalCache();
     return 0;
 }
 
+// Write the k-mer interval cache for the index. If the reverse
+// index was built the cache also holds its intervals so that
+// interval pairs can be looked up.
+void writeIntervalCache()
+{
+    std::cout << "Building interval cache for k = " << opt::intervalCacheLength << "\n";
+    BWT* pBWT = new BWT(opt::prefix + BWT_EXT);
+    BWT* pRBWT = NULL;
+    if(opt::bBuildReverse)
+        pRBWT = new BWT(opt::prefix + RBWT_EXT);
+
+    BWTIntervalCache* pCache = NULL;
+    if(pRBWT != NULL)
+        pCache = new BWTIntervalCache(opt::intervalCacheLength, pBWT, pRBWT, opt::numThreads);
+    else
+        pCache = new BWTIntervalCache(opt::intervalCacheLength, pBWT, opt::numThreads);
+    pCache->write(opt::prefix + IC_EXT);
+
+    delete pCache;
+    delete pRBWT;
+    delete pBWT;
+}
+
 //
 void indexInMemoryBCR()
 {
@@ -216,6 +258,34 @@ void indexInMemorySAIS()
 	}
 }
 
+// Build a single index containing both strands of every read
+void indexBothStrandsSAIS()
+{
+    std::cout << "Building index of both strands of " << opt::readsFile << " in memory using SAIS\n";
+
+    ReadTable* pRT = new ReadTable(opt::readsFile);
+    pRT->addReverseComplements();
+
+    SuffixArray* pSA = new SuffixArray(pRT, opt::numThreads);
+    if(opt::validate)
+    {
+        std::cout << "Validating suffix array\n";
+        pSA->validate(pRT);
+    }
+
+    std::string bwt_filename = opt::prefix + BSBWT_EXT;
+    pSA->writeBWT(bwt_filename, pRT);
+
+    if(opt::bBuildSAI)
+    {
+        std::string sufidx_filename = opt::prefix + BSSAI_EXT;
+        pSA->writeIndex(sufidx_filename);
+    }
+
+    delete pSA;
+    delete pRT;
+}
+
 //
 void indexOnDisk()
 {
@@ -289,6 +359,8 @@ void parseIndexOptions(int argc, char** argv)
             case OPT_NO_REVERSE: opt::bBuildReverse = false; break;
             case OPT_NO_FWD: opt::bBuildForward = false; break;
             case OPT_NO_SAI: opt::bBuildSAI = false; break;
+            case OPT_INTERVAL_CACHE: arg >> opt::intervalCacheLength; break;
+            case OPT_BOTH_STRANDS: opt::bBothStrands = true; break;
             case OPT_HELP:
                 std::cout << INDEX_USAGE_MESSAGE;
                 exit(EXIT_SUCCESS);
@@ -331,6 +403,30 @@ void parseIndexOptions(int argc, char** argv)
         die = true;
     }
 
+    if(opt::intervalCacheLength < 0 || opt::intervalCacheLength > MAX_INTERVAL_CACHE_LENGTH)
+    {
+        std::cerr << SUBPROGRAM ": invalid argument, --interval-cache must be between 1 and " << MAX_INTERVAL_CACHE_LENGTH << "\n";
+        die = true;
+    }
+
+    if(opt::intervalCacheLength > 0 && !opt::bBuildForward)
+    {
+        std::cerr << SUBPROGRAM ": the interval cache requires the forward index, --interval-cache and --no-forward are not compatible\n";
+        die = true;
+    }
+
+    if(opt::bBothStrands && (opt::algorithm != "sais" || opt::bDiskAlgo))
+    {
+        std::cerr << SUBPROGRAM ": --both-strands is only supported by the in-memory sais algorithm\n";
+        die = true;
+    }
+
+    if(opt::bBothStrands && opt::intervalCacheLength > 0)
+    {
+        std::cerr << SUBPROGRAM ": the options --both-strands and --interval-cache are not compatible\n";
+        die = true;
+    }
+
     if(opt::algorithm == "ropebwt" && opt::bDiskAlgo)
     {
         std::cerr << SUBPROGRAM ": the options -a ropebwt and -d are not compatible, please only use one.\n";
@@ -17,6 +17,8 @@ void indexInMemorySAIS();
 void indexInMemoryBCR();
 void indexInMemoryRopebwt();
 void indexOnDisk();
+void indexBothStrandsSAIS();
+void writeIntervalCache();
 void buildIndexForTable(std::string outfile, const ReadTable* pRT, bool isReverse);
 void parseIndexOptions(int argc, char** argv);
 
@@ -12,9 +12,18 @@
 #include <stack>
 #include <memory>
 #include <getopt.h>
+#include <fstream>
+#include <limits>
+#include <sys/stat.h>
 #include <BWT.h>
 #include <BWTInterval.h>
 #include <BWTAlgorithms.h>
+#include <SGACommon.h>
+#include <KmerCountTable.h>
+
+#if HAVE_OPENMP
+#include <omp.h>
+#endif
 
 //
 // Getopt
@@ -27,13 +36,26 @@ static const char *KMERCOUNT_USAGE_MESSAGE =
 "Generate a table of the k-mers in src.{bwt,fa,fq}, and optionally count the number of time they appears in testX.bwt.\n"
 "Output on stdout the canonical kmers and their counts on forward and reverse strand if input is .bwt\n"
 "If src is a sequence file output forward and reverse counts for each kmer in the file\n"
+"With -t > 1 or --binary the reverse index (.rbwt) of every bwt file is loaded, the kmers of src.bwt are output\n"
+"in sorted order and the search is split between threads. Without them, or if a reverse index is missing,\n"
+"only the bwt files are loaded and a single thread is used.\n"
 "\n"
 "      --help                           display this help and exit\n"
 "      --version                        display program version\n"
+"      -t, --threads=NUM                use NUM threads to search for the kmers of src.bwt (default: 1)\n"
 "      -k, --kmer-size=N                The length of the kmer to use. (default: 27)\n"
 "      -d, --sample-rate=N              use occurrence array sample rate of N in the FM-index. Higher values use significantly\n"
 "                                       less memory at the cost of higher runtime. This value must be a power of 2 (default: 128)\n"
-"      -c, --cache-length=N             Cache Length for bwt lookups (default: 10)\n"
+"      -c, --cache-length=N             Cache Length for bwt lookups (default: 10). Without this option the interval cache\n"
+"                                       built by sga index --interval-cache is used if present, whatever its length.\n"
+"                                       With it, that cache is only used if it was built for length N\n"
+"      --table=FILE                     instead of printing the kmers of src.bwt, write them and their counts to a binary\n"
+"                                       table in FILE. The table can be used by sga correct and sga filter\n"
+"                                       to look up kmer counts without searching the FM-index\n"
+"      -m, --min-count=N                only add kmers seen at least N times to the table (default: 1)\n"
+"      --binary=FILE                    instead of printing the kmers of src.bwt and their counts, write them to FILE\n"
+"                                       as sorted binary records (see KmerCountFileHeader in kmer-count.h). The kmer\n"
+"                                       length must be at most 31 and every bwt file needs its reverse index\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 
@@ -44,14 +66,23 @@ namespace opt {
     static int sampleRate = BWT::DEFAULT_SAMPLE_RATE_SMALL;
     static unsigned int kmerLength = 27;
     static int intervalCacheLength = 10;
+    static bool bExactCacheLength = false;
+    static std::string tableFile;
+    static unsigned int minCount = 1;
+    static std::string binaryFile;
+    static int numThreads = 1;
 }
 
-static const char* shortopts = "d:k:c:x:";
-enum { OPT_HELP = 1, OPT_VERSION };
+static const char* shortopts = "d:k:c:x:t:m:";
+enum { OPT_HELP = 1, OPT_VERSION, OPT_TABLE, OPT_BINARY };
 static const struct option longopts[] = {
     { "sample-rate",           required_argument, NULL, 'd' },
     { "kmer-size",             required_argument, NULL, 'k' },
     { "cache-length",          required_argument, NULL, 'c' },
+    { "threads",               required_argument, NULL, 't' },
+    { "table",                 required_argument, NULL, OPT_TABLE },
+    { "min-count",             required_argument, NULL, 'm' },
+    { "binary",                required_argument, NULL, OPT_BINARY },
     { "help",                  no_argument,       NULL, OPT_HELP },
     { "version",               no_argument,       NULL, OPT_VERSION },
     { NULL, 0, NULL, 0 }
@@ -67,7 +98,11 @@ void parseKmerCountOptions(int argc, char** argv) {
         {
             case 'd': arg >> opt::sampleRate; break;
             case 'k': arg >> opt::kmerLength; break;
-            case 'c': arg >> opt::intervalCacheLength; break;
+            case 'c': arg >> opt::intervalCacheLength; opt::bExactCacheLength = true; break;
+            case 't': arg >> opt::numThreads; break;
+            case OPT_TABLE: arg >> opt::tableFile; break;
+            case 'm': arg >> opt::minCount; break;
+            case OPT_BINARY: arg >> opt::binaryFile; break;
             case OPT_HELP:
                 std::cout << KMERCOUNT_USAGE_MESSAGE;
                 exit(EXIT_SUCCESS);
@@ -84,6 +119,20 @@ void parseKmerCountOptions(int argc, char** argv) {
         exit(EXIT_FAILURE);
     }
 
+    if(opt::numThreads <= 0)
+    {
+        std::cerr << SUBPROGRAM ": invalid number of threads: " << opt::numThreads << "\n";
+        std::cout << "\n" << KMERCOUNT_USAGE_MESSAGE;
+        exit(EXIT_FAILURE);
+    }
+
+    if(opt::intervalCacheLength <= 0 || opt::intervalCacheLength > MAX_INTERVAL_CACHE_LENGTH)
+    {
+        std::cerr << SUBPROGRAM ": invalid cache length: " << opt::intervalCacheLength << ", must be between 1 and " << MAX_INTERVAL_CACHE_LENGTH << "\n";
+        std::cout << "\n" << KMERCOUNT_USAGE_MESSAGE;
+        exit(EXIT_FAILURE);
+    }
+
     if(optind >= argc)
     {
       std::cerr << SUBPROGRAM ": missing input bwt/sequence file" << std::endl;
@@ -110,6 +159,38 @@ void parseKmerCountOptions(int argc, char** argv) {
         std::cout << "\n" << KMERCOUNT_USAGE_MESSAGE;
         exit(EXIT_FAILURE);
     }
+
+    if(!opt::tableFile.empty())
+    {
+        if(!opt::inputSequenceFile.empty() || opt::bwtFiles.size() != 1)
+        {
+            std::cerr << SUBPROGRAM ": --table requires a single bwt file\n";
+            std::cout << "\n" << KMERCOUNT_USAGE_MESSAGE;
+            exit(EXIT_FAILURE);
+        }
+
+        if(opt::kmerLength > (unsigned int)KmerCountTable::MAX_KMER_LENGTH)
+        {
+            std::cerr << SUBPROGRAM ": the kmer length for --table must be at most " << KmerCountTable::MAX_KMER_LENGTH << "\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(!opt::binaryFile.empty())
+    {
+        if(!opt::inputSequenceFile.empty() || !opt::tableFile.empty())
+        {
+            std::cerr << SUBPROGRAM ": --binary cannot be used with a sequence file or --table\n";
+            std::cout << "\n" << KMERCOUNT_USAGE_MESSAGE;
+            exit(EXIT_FAILURE);
+        }
+
+        if(opt::kmerLength > (unsigned int)KmerCountTable::MAX_KMER_LENGTH)
+        {
+            std::cerr << SUBPROGRAM ": the kmer length for --binary must be at most " << KmerCountTable::MAX_KMER_LENGTH << "\n";
+            exit(EXIT_FAILURE);
+        }
+    }
 }
 
 
@@ -130,8 +211,33 @@ struct stack_elt_t
 
 
 
+// Output a canonical kmer, its count and the count of its reverse complement.
+// If a table is being built the kmer is added to it, otherwise the kmer is
+// printed along with its counts in the test indices.
+static void output_kmer(const std::string& seq, const std::string& seq_rc,
+                        int64_t seq_count, int64_t seq_rc_count,
+                        const std::vector<BWTIndexSet> &indicies,
+                        KmerCountTable* pTable)
+{
+    if(pTable != NULL)
+    {
+        pTable->add(seq, seq_count + seq_rc_count);
+        return;
+    }
+
+    std::cout << seq << '\t' << seq_count << '\t' << seq_rc_count;
+    std::vector<BWTIndexSet>::const_iterator idx_it;
+    for(idx_it = indicies.begin() + 1;
+        idx_it != indicies.end(); ++idx_it)
+    {
+        std::cout << "\t" << BWTAlgorithms::countSequenceOccurrencesSingleStrand(seq, *idx_it);
+        std::cout << "\t" << BWTAlgorithms::countSequenceOccurrencesSingleStrand(seq_rc, *idx_it);
+    }
+    std::cout << std::endl;
+}
+
 // extract all canonical kmers of a bwt by performing a backward depth-first-search
-void traverse_kmer(const std::vector<BWTIndexSet> &indicies)
+void traverse_kmer(const std::vector<BWTIndexSet> &indicies, KmerCountTable* pTable)
 {
     std::stack< stack_elt_t > stack;
     std::string str; // string storing the current path
@@ -144,8 +250,6 @@ void traverse_kmer(const std::vector<BWTIndexSet> &indicies)
         if (e.range.isValid()) stack.push(e);
     }
 
-    std::vector<BWTIndexSet>::const_iterator idx_it;
-
     // Perform the kmer search
     while(!stack.empty())
     {
@@ -164,29 +268,13 @@ void traverse_kmer(const std::vector<BWTIndexSet> &indicies)
             BWTInterval range_rc = BWTAlgorithms::findInterval(indicies[0].pBWT,seq_rc);
             int64_t seq_rc_count = range_rc.isValid()?range_rc.size():0;
 
-            // print the current kmer if canonical
+            // output the current kmer if canonical
             if (seq<seq_rc) {
-              std::cout << seq << '\t' << seq_count << '\t' << seq_rc_count;
-              
-              for(idx_it = indicies.begin() + 1;
-                  idx_it != indicies.end(); ++idx_it)
-              {
-                std::cout << "\t" << BWTAlgorithms::countSequenceOccurrencesSingleStrand(seq, *idx_it);
-                std::cout << "\t" << BWTAlgorithms::countSequenceOccurrencesSingleStrand(seq_rc, *idx_it);
-              }
-              std::cout << std::endl;
-
+                output_kmer(seq, seq_rc, seq_count, seq_rc_count, indicies, pTable);
             } else if (seq_rc_count<=0) {
                 // the current kmer is not canonical, but the reverse complement doesn't exists
-                // so print it now as it will never be traversed by the searching algorithm
-                std::cout << seq_rc << '\t' << seq_rc_count << '\t' << seq_count;
-                for(idx_it = indicies.begin() + 1;
-                    idx_it != indicies.end(); ++idx_it)
-                {
-                  std::cout << "\t" << BWTAlgorithms::countSequenceOccurrencesSingleStrand(seq_rc, *idx_it);
-                  std::cout << "\t" << BWTAlgorithms::countSequenceOccurrencesSingleStrand(seq, *idx_it);
-                }
-                std::cout << std::endl;
+                // so output it now as it will never be traversed by the searching algorithm
+                output_kmer(seq_rc, seq, seq_rc_count, seq_count, indicies, pTable);
             }
         } else
         {
@@ -202,7 +290,239 @@ void traverse_kmer(const std::vector<BWTIndexSet> &indicies)
 }
 
 
+//
+// Partitioned traversal
+//
+// When every index has a reverse index the kmers are built from left to right, by
+// a backwards search for the reversed string in the reverse index. The interval of
+// the reverse complement is carried along by a backwards search in the forward index,
+// as are the intervals of the string and its reverse complement in the test indices,
+// so the counts of a kmer are known as soon as it is reached. The kmers are visited
+// in lexicographic order, which lets the search be split into partitions by the first
+// bases of the kmers. The partitions are searched in parallel and written in order.
+//
+
+// The number of leading bases that define a partition
+static const size_t PARTITION_DEPTH = 6;
+
+enum KmerOutputMode
+{
+    KOM_TEXT,
+    KOM_BINARY,
+    KOM_TABLE
+};
+
+// The state of the search of one partition. Each index j has
+// two intervals: interval 2j is for the reverse of the current
+// string in the reverse index and interval 2j+1 is for the reverse
+// complement of the current string in the forward index.
+struct partition_search_t
+{
+    partition_search_t(const std::vector<BWTIndexSet>& indices, KmerOutputMode mode) : indices(indices),
+                                                                                       mode(mode),
+                                                                                       num_intervals(2 * indices.size()),
+                                                                                       str(opt::kmerLength, 'A'),
+                                                                                       str_rc(opt::kmerLength, 'A'),
+                                                                                       root(num_intervals),
+                                                                                       children(opt::kmerLength * DNA_ALPHABET_SIZE * num_intervals),
+                                                                                       num_kmers(0) {}
+
+    const std::vector<BWTIndexSet>& indices;
+    KmerOutputMode mode;
+    size_t num_intervals;
+    std::string str; // the current path
+    std::string str_rc;
+    std::vector<BWTInterval> root; // the intervals of the first bases of the partition
+    std::vector<BWTInterval> children; // the intervals of the extensions of each depth
+    std::string out; // the kmers found in the partition, formatted for output
+    size_t num_kmers;
+};
+
+// Append a count to a line of text output
+static void append_count(std::string& out, int64_t count)
+{
+    char buffer[24];
+    char* p = buffer + sizeof(buffer);
+    uint64_t v = count;
+    do
+    {
+        *--p = '0' + v % 10;
+        v /= 10;
+    } while(v > 0);
+    out.append(p, buffer + sizeof(buffer) - p);
+}
+
+// Append a value to a binary record
+template<typename T>
+static void append_value(std::string& out, T value)
+{
+    out.append((const char*)&value, sizeof(T));
+}
+
+// Format the kmer at the end of the current path, if it is canonical
+static void output_partition_kmer(partition_search_t& state, const BWTInterval* intervals)
+{
+    size_t k = opt::kmerLength;
+    for(size_t i = 0; i < k; ++i)
+        state.str_rc[i] = complement(state.str[k - i - 1]);
+
+    // The kmer length is odd so a kmer cannot be its own reverse complement
+    if(state.str_rc < state.str)
+        return;
+
+    state.num_kmers += 1;
+    if(state.mode == KOM_TEXT)
+    {
+        state.out.append(state.str);
+        for(size_t i = 0; i < state.num_intervals; ++i)
+        {
+            state.out.push_back('\t');
+            append_count(state.out, intervals[i].isValid() ? intervals[i].size() : 0);
+        }
+        state.out.push_back('\n');
+        return;
+    }
+
+    uint64_t key;
+    packCanonicalKmer(state.str.c_str(), k, key);
+    append_value(state.out, key);
+
+    if(state.mode == KOM_TABLE)
+    {
+        uint64_t count = 0;
+        for(size_t i = 0; i < 2; ++i)
+            count += intervals[i].isValid() ? intervals[i].size() : 0;
+        append_value(state.out, count);
+        return;
+    }
+
+    for(size_t i = 0; i < state.num_intervals; ++i)
+    {
+        uint64_t count = intervals[i].isValid() ? intervals[i].size() : 0;
+        append_value(state.out, (uint32_t)std::min(count, (uint64_t)std::numeric_limits<uint32_t>::max()));
+    }
+}
+
+// Search the extensions of the current path, which has length depth
+static void search_partition_kmers(partition_search_t& state, size_t depth, const BWTInterval* intervals)
+{
+    if(depth == opt::kmerLength)
+    {
+        output_partition_kmer(state, intervals);
+        return;
+    }
+
+    // Calculate the intervals of all four extensions at once. The occurrence
+    // counts of every symbol are read for the ends of each interval.
+    size_t n = state.num_intervals;
+    BWTInterval* next = &state.children[depth * DNA_ALPHABET_SIZE * n];
+    for(size_t i = 0; i < n; ++i)
+    {
+        const BWT* pBWT = i % 2 == 0 ? state.indices[i / 2].pRBWT : state.indices[i / 2].pBWT;
+        if(intervals[i].isValid())
+            BWTAlgorithms::prefetchIntervalMarkers(intervals[i], pBWT);
+    }
 
+    for(size_t i = 0; i < n; ++i)
+    {
+        const BWT* pBWT = i % 2 == 0 ? state.indices[i / 2].pRBWT : state.indices[i / 2].pBWT;
+        if(!intervals[i].isValid())
+        {
+            for(size_t j = 0; j < DNA_ALPHABET_SIZE; ++j)
+                next[j * n + i] = intervals[i];
+            continue;
+        }
+
+        AlphaCount64 l = pBWT->getFullOcc(intervals[i].lower - 1);
+        AlphaCount64 u = pBWT->getFullOcc(intervals[i].upper);
+        for(size_t j = 0; j < DNA_ALPHABET_SIZE; ++j)
+        {
+            // The reverse complement is extended by the complement of the base
+            char b = i % 2 == 0 ? ALPHABET[j] : complement(ALPHABET[j]);
+            size_t pb = pBWT->getPC(b);
+            next[j * n + i].lower = pb + l.get(b);
+            next[j * n + i].upper = (int64_t)(pb + u.get(b)) - 1;
+        }
+    }
+
+    for(size_t j = 0; j < DNA_ALPHABET_SIZE; ++j)
+    {
+        // Stop when neither the string nor its reverse complement is in the source index
+        const BWTInterval* child = next + j * n;
+        if(child[0].isValid() || child[1].isValid())
+        {
+            state.str[depth] = ALPHABET[j];
+            search_partition_kmers(state, depth + 1, child);
+        }
+    }
+}
+
+// Search the kmers whose first bases are given by partition
+static void search_partition(partition_search_t& state, size_t partition, size_t depth)
+{
+    for(size_t i = 0; i < depth; ++i)
+        state.str[i] = ALPHABET[(partition >> 2 * (depth - i - 1)) & 3];
+
+    for(size_t i = 0; i < state.num_intervals; ++i)
+    {
+        const BWT* pBWT = i % 2 == 0 ? state.indices[i / 2].pRBWT : state.indices[i / 2].pBWT;
+        BWTInterval& interval = state.root[i];
+        for(size_t j = 0; j < depth && (j == 0 || interval.isValid()); ++j)
+        {
+            char b = i % 2 == 0 ? state.str[j] : complement(state.str[j]);
+            if(j == 0)
+                BWTAlgorithms::initInterval(interval, b, pBWT);
+            else
+                BWTAlgorithms::updateInterval(interval, b, pBWT);
+        }
+    }
+
+    if(state.root[0].isValid() || state.root[1].isValid())
+        search_partition_kmers(state, depth, &state.root[0]);
+}
+
+// Extract all canonical kmers of the first index in sorted order, using multiple threads.
+// The kmers are printed, written to pBinaryOut or added to pTable, depending on mode.
+// Returns the number of kmers found.
+size_t traverse_kmer_partitioned(const std::vector<BWTIndexSet>& indices, KmerOutputMode mode,
+                                 KmerCountTable* pTable, std::ostream* pBinaryOut)
+{
+    size_t depth = std::min(PARTITION_DEPTH, (size_t)opt::kmerLength);
+    long num_partitions = 1l << (2 * depth);
+    size_t num_kmers = 0;
+
+#if HAVE_OPENMP
+    #pragma omp parallel for ordered schedule(dynamic, 1) num_threads(opt::numThreads)
+#endif
+    for(long p = 0; p < num_partitions; ++p)
+    {
+        partition_search_t state(indices, mode);
+        search_partition(state, p, depth);
+
+        // Write the partitions in order so the output is sorted
+#if HAVE_OPENMP
+        #pragma omp ordered
+#endif
+        {
+            num_kmers += state.num_kmers;
+            if(mode == KOM_TEXT)
+            {
+                std::cout.write(state.out.data(), state.out.size());
+            }
+            else if(mode == KOM_BINARY)
+            {
+                pBinaryOut->write(state.out.data(), state.out.size());
+            }
+            else
+            {
+                const char* pRecord = state.out.data();
+                for(size_t i = 0; i < state.num_kmers; ++i, pRecord += 2 * sizeof(uint64_t))
+                    pTable->add(*(const uint64_t*)pRecord, *(const uint64_t*)(pRecord + sizeof(uint64_t)));
+            }
+        }
+    }
+    return num_kmers;
+}
 
 void kmers_from_file(const std::string &inputFile,
                      const std::vector<BWTIndexSet> bwtIndicies)
@@ -255,21 +575,85 @@ int kmerCountMain(int argc, char** argv)
     std::vector<BWTIndexSet> bwtIndicies;
     BWTIndexSet tmpIdx;
 
+    // Only the partitioned search, used for --binary and to split the
+    // search between threads, needs the reverse index of every bwt
+    bool useReverseIndex = opt::inputSequenceFile.empty() && (opt::numThreads > 1 || !opt::binaryFile.empty());
+    for(std::vector<std::string>::iterator it = opt::bwtFiles.begin();
+        it != opt::bwtFiles.end() && useReverseIndex; ++it)
+    {
+      struct stat file_s;
+      if(stat((stripExtension(*it) + RBWT_EXT).c_str(), &file_s) != 0)
+        useReverseIndex = false;
+    }
+
+    if(!opt::binaryFile.empty() && !useReverseIndex)
+    {
+      std::cerr << SUBPROGRAM ": --binary requires the reverse index (.rbwt) of every bwt file\n";
+      exit(EXIT_FAILURE);
+    }
+
     for(std::vector<std::string>::iterator it = opt::bwtFiles.begin();
         it != opt::bwtFiles.end(); ++it)
     {
       std::cerr << "Loading " << *it << std::endl;
 
       tmpIdx.pBWT = new BWT(*it, opt::sampleRate);
-      tmpIdx.pCache = new BWTIntervalCache(opt::intervalCacheLength, tmpIdx.pBWT);
+      std::string ic_filename = stripExtension(*it) + IC_EXT;
+      if(opt::bExactCacheLength)
+        tmpIdx.pCache = BWTIntervalCache::loadExact(ic_filename, opt::intervalCacheLength, tmpIdx.pBWT, opt::numThreads);
+      else
+        tmpIdx.pCache = BWTIntervalCache::load(ic_filename, opt::intervalCacheLength, tmpIdx.pBWT, NULL, opt::numThreads);
+
+      tmpIdx.pRBWT = NULL;
+      if(useReverseIndex)
+      {
+          std::string rbwt_filename = stripExtension(*it) + RBWT_EXT;
+          std::cerr << "Loading " << rbwt_filename << std::endl;
+          tmpIdx.pRBWT = new BWT(rbwt_filename, opt::sampleRate);
+      }
       
       bwtIndicies.push_back(tmpIdx);
     }
 
-    if( opt::inputSequenceFile.empty() )
+    if(opt::numThreads > 1 && opt::inputSequenceFile.empty() && !useReverseIndex)
+      std::cerr << "Warning: the reverse indices were not found, using a single thread" << std::endl;
+
+    if( !opt::tableFile.empty() )
+    {
+      // build the table of kmer counts
+      KmerCountTable table(opt::kmerLength, opt::minCount, bwtIndicies[0].pBWT);
+      if(useReverseIndex)
+        traverse_kmer_partitioned(bwtIndicies, KOM_TABLE, &table, NULL);
+      else
+        traverse_kmer(bwtIndicies, &table);
+      table.write(opt::tableFile);
+      std::cerr << "Wrote " << table.getNumKmers() << " kmers to " << opt::tableFile << std::endl;
+    }
+    else if( !opt::binaryFile.empty() )
+    {
+      // write the sorted kmers and their counts, then fill in the number of kmers
+      std::ofstream out(opt::binaryFile.c_str(), std::ios::out | std::ios::binary);
+      assertFileOpen(out, opt::binaryFile);
+
+      KmerCountFileHeader header;
+      header.magic = KMER_COUNT_FILE_MAGIC;
+      header.kmer = opt::kmerLength;
+      header.numIndices = bwtIndicies.size();
+      header.numKmers = 0;
+      out.write((const char*)&header, sizeof(header));
+
+      header.numKmers = traverse_kmer_partitioned(bwtIndicies, KOM_BINARY, NULL, &out);
+      out.seekp(0);
+      out.write((const char*)&header, sizeof(header));
+      std::cerr << "Wrote " << header.numKmers << " kmers to " << opt::binaryFile << std::endl;
+    }
+    else if( opt::inputSequenceFile.empty() )
     {
       // run kmer search
-      traverse_kmer(bwtIndicies);
+      if(useReverseIndex)
+        traverse_kmer_partitioned(bwtIndicies, KOM_TEXT, NULL, NULL);
+      else
+        traverse_kmer(bwtIndicies, NULL);
     }else
     {
       kmers_from_file(opt::inputSequenceFile, bwtIndicies);
@@ -282,6 +666,7 @@ int kmerCountMain(int argc, char** argv)
         ++indexset_it)
     {
       delete (*indexset_it).pBWT;
+      delete (*indexset_it).pRBWT;
       delete (*indexset_it).pCache;
     }
     return 0;
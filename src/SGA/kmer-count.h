@@ -1,6 +1,23 @@
 #ifndef KMERCOUNT_H
 #define KMERCOUNT_H
 #include "config.h"
+#include <stdint.h>
+
+#define KMER_COUNT_FILE_MAGIC 0x4B4D
+
+// The header of the file written by kmer-count --binary. It is followed
+// by numKmers records sorted by key. Each record is the canonical kmer
+// packed into 2 bits per base (A=0,C=1,G=2,T=3, first base in the most
+// significant bits) as a uint64_t, then two uint32_t counts per index:
+// the count of the kmer and the count of its reverse complement.
+// The counts saturate at the largest uint32_t.
+struct KmerCountFileHeader
+{
+    uint64_t magic;
+    uint64_t kmer;
+    uint64_t numIndices;
+    uint64_t numKmers;
+};
 
 int kmerCountMain(int argc, char** argv);
 void parseKmerCountOptions(int argc, char** argv);
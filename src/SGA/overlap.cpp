@@ -19,9 +19,11 @@
 #include "Timer.h"
 #include "BWTAlgorithms.h"
 #include "ASQG.h"
+#include "BSQG.h"
 #include "gzstream.h"
 #include "SequenceProcessFramework.h"
 #include "OverlapProcess.h"
+#include "HitsIO.h"
 #include "ReadInfoTable.h"
 
 //
@@ -43,6 +45,39 @@ size_t computeHitsParallel(int numThreads, const std::string& prefix, const std:
 //
 void convertHitsToASQG(const std::string& indexPrefix, const StringVector& hitsFilenames, std::ostream* pASQGWriter);
 
+// The read information and lexicographic indices used to
+// convert overlap blocks into edges
+struct EdgeConversionTables
+{
+    EdgeConversionTables() : pFwdSAI(NULL), pRevSAI(NULL), pQueryRIT(NULL), pTargetRIT(NULL) {}
+    ~EdgeConversionTables() { clear(); }
+
+    void load(const std::string& indexPrefix);
+    void clear();
+
+    SuffixArray* pFwdSAI;
+    SuffixArray* pRevSAI;
+    ReadInfoTable* pQueryRIT;
+    ReadInfoTable* pTargetRIT;
+};
+
+size_t computeEdgesSerial(const std::string& readsFile, 
+                          const OverlapAlgorithm* pOverlapper, int minOverlap, 
+                          const EdgeConversionTables& tables, bool bBinaryEdges,
+                          OverlapEdgePostProcess* pPostProcessor);
+
+size_t computeEdgesParallel(int numThreads, const std::string& readsFile, 
+                            const OverlapAlgorithm* pOverlapper, int minOverlap, 
+                            const EdgeConversionTables& tables, bool bBinaryEdges,
+                            OverlapEdgePostProcess* pPostProcessor);
+
+size_t computeEdges(const std::string& readsFile, 
+                    const OverlapAlgorithm* pOverlapper, int minOverlap, 
+                    const EdgeConversionTables& tables, bool bBinaryEdges,
+                    OverlapEdgePostProcess* pPostProcessor);
+
+void appendEdges(const std::string& edgesFilename, std::ostream* pASQGWriter);
+
 
 //
 // Getopt
@@ -76,6 +111,12 @@ static const char *OVERLAP_USAGE_MESSAGE =
 "                                       is specified (see above). This parameter defaults to the same value as --seed-length\n"
 "      -d, --sample-rate=N              sample the symbol counts every N symbols in the FM-index. Higher values use significantly\n"
 "                                       less memory at the cost of higher runtime. This value must be a power of 2 (default: 128)\n"
+"          --no-pipeline                write the overlap hits to temporary files and convert them to edges after the\n"
+"                                       search has finished and the FM-index has been freed. By default the hits are\n"
+"                                       converted by the worker threads during the search, which is faster but keeps\n"
+"                                       the read table and lexicographic indices in memory alongside the FM-index.\n"
+"          --binary                     write the graph as a binary BSQG file (default name: READSFILE.bsqg) instead of\n"
+"                                       an ASQG file. This cannot be used with --target-file or --no-pipeline.\n"
 "\nReport bugs to " PACKAGE_BUGREPORT "\n\n";
 
 static const char* PROGRAM_IDENT =
@@ -98,11 +139,13 @@ namespace opt
     static int sampleRate = BWT::DEFAULT_SAMPLE_RATE_SMALL;
     static bool bIrreducibleOnly = true;
     static bool bExactIrreducible = false;
+    static bool bPipelineEdges = true;
+    static bool bBinaryGraph = false;
 }
 
 static const char* shortopts = "m:d:e:t:l:s:o:f:p:vix";
 
-enum { OPT_HELP = 1, OPT_VERSION, OPT_EXACT };
+enum { OPT_HELP = 1, OPT_VERSION, OPT_EXACT, OPT_NO_PIPELINE, OPT_BINARY };
 
 static const struct option longopts[] = {
     { "verbose",     no_argument,       NULL, 'v' },
@@ -117,6 +160,8 @@ static const struct option longopts[] = {
     { "seed-stride", required_argument, NULL, 's' },
     { "exhaustive",  no_argument,       NULL, 'x' },
     { "exact",       no_argument,       NULL, OPT_EXACT },
+    { "no-pipeline", no_argument,       NULL, OPT_NO_PIPELINE },
+    { "binary",      no_argument,       NULL, OPT_BINARY },
     { "help",        no_argument,       NULL, OPT_HELP },
     { "version",     no_argument,       NULL, OPT_VERSION },
     { NULL, 0, NULL, 0 }
@@ -133,16 +178,29 @@ int overlapMain(int argc, char** argv)
     assert(opt::outputType == OT_ASQG);
 
     // Open output file
-    std::ostream* pASQGWriter = createWriter(opt::outFile);
-
-    // Build and write the ASQG header
-    ASQG::HeaderRecord headerRecord;
-    headerRecord.setOverlapTag(opt::minOverlap);
-    headerRecord.setErrorRateTag(opt::errorRate);
-    headerRecord.setInputFileTag(opt::readsFile);
-    headerRecord.setContainmentTag(true); // containments are always present
-    headerRecord.setTransitiveTag(!opt::bIrreducibleOnly);
-    headerRecord.write(*pASQGWriter);
+    std::ostream* pASQGWriter = NULL;
+    BSQG::Writer* pBSQGWriter = NULL;
+    if(opt::bBinaryGraph)
+    {
+        pBSQGWriter = new BSQG::Writer(opt::outFile);
+        pBSQGWriter->setMinOverlap(opt::minOverlap);
+        pBSQGWriter->setErrorRate(opt::errorRate);
+        pBSQGWriter->setContainment(true); // containments are always present
+        pBSQGWriter->setTransitive(!opt::bIrreducibleOnly);
+    }
+    else
+    {
+        pASQGWriter = createWriter(opt::outFile);
+
+        // Build and write the ASQG header
+        ASQG::HeaderRecord headerRecord;
+        headerRecord.setOverlapTag(opt::minOverlap);
+        headerRecord.setErrorRateTag(opt::errorRate);
+        headerRecord.setInputFileTag(opt::readsFile);
+        headerRecord.setContainmentTag(true); // containments are always present
+        headerRecord.setTransitiveTag(!opt::bIrreducibleOnly);
+        headerRecord.write(*pASQGWriter);
+    }
 
     // Compute the overlap hits
     StringVector hitsFilenames;
@@ -180,27 +238,70 @@ int overlapMain(int argc, char** argv)
         outPrefix.append(stripFilename(opt::targetFile));
     }
 
-    if(opt::numThreads <= 1)
+    if(opt::bBinaryGraph)
     {
-        printf("[%s] starting serial-mode overlap computation\n", PROGRAM_IDENT);
-        computeHitsSerial(outPrefix, opt::readsFile, pOverlapper, opt::minOverlap, hitsFilenames, pASQGWriter);
+        // The vertices and edges are written straight to the BSQG file
+        EdgeConversionTables tables;
+        tables.load(indexPrefix);
+
+        OverlapEdgePostProcess postProcessor(pBSQGWriter, pOverlapper);
+        computeEdges(opt::readsFile, pOverlapper, opt::minOverlap, tables, true, &postProcessor);
+
+        delete pOverlapper;
+        delete pBWT; 
+        delete pRBWT;
+        tables.clear();
+
+        pBSQGWriter->close();
     }
-    else
+    else if(opt::bPipelineEdges)
     {
-        printf("[%s] starting parallel-mode overlap computation with %d threads\n", PROGRAM_IDENT, opt::numThreads);
-        computeHitsParallel(opt::numThreads, outPrefix, opt::readsFile, pOverlapper, opt::minOverlap, hitsFilenames, pASQGWriter);
+        // Load the tables used to convert the overlap blocks into edges
+        // so the worker threads can convert them during the search
+        EdgeConversionTables tables;
+        tables.load(indexPrefix);
+
+        // The edges are written to a temporary file in the order of the reads
+        // and added to the ASQG file once all the vertices have been written
+        std::string edgesFilename = outPrefix + EDGES_EXT;
+        std::ostream* pEdgeWriter = createWriter(edgesFilename, std::ios::out | std::ios::binary);
+
+        OverlapEdgePostProcess postProcessor(pASQGWriter, pEdgeWriter, pOverlapper);
+        computeEdges(opt::readsFile, pOverlapper, opt::minOverlap, tables, false, &postProcessor);
+        delete pEdgeWriter;
+
+        delete pOverlapper;
+        delete pBWT; 
+        delete pRBWT;
+        tables.clear();
+
+        appendEdges(edgesFilename, pASQGWriter);
     }
+    else
+    {
+        if(opt::numThreads <= 1)
+        {
+            printf("[%s] starting serial-mode overlap computation\n", PROGRAM_IDENT);
+            computeHitsSerial(outPrefix, opt::readsFile, pOverlapper, opt::minOverlap, hitsFilenames, pASQGWriter);
+        }
+        else
+        {
+            printf("[%s] starting parallel-mode overlap computation with %d threads\n", PROGRAM_IDENT, opt::numThreads);
+            computeHitsParallel(opt::numThreads, outPrefix, opt::readsFile, pOverlapper, opt::minOverlap, hitsFilenames, pASQGWriter);
+        }
 
-    // Get the number of strings in the BWT, this is used to pre-allocated the read table
-    delete pOverlapper;
-    delete pBWT; 
-    delete pRBWT;
+        // Get the number of strings in the BWT, this is used to pre-allocated the read table
+        delete pOverlapper;
+        delete pBWT; 
+        delete pRBWT;
 
-    // Parse the hits files and write the overlaps to the ASQG file
-    convertHitsToASQG(indexPrefix, hitsFilenames, pASQGWriter);
+        // Parse the hits files and write the overlaps to the ASQG file
+        convertHitsToASQG(indexPrefix, hitsFilenames, pASQGWriter);
+    }
 
     // Cleanup
     delete pASQGWriter;
+    delete pBSQGWriter;
     delete pTimer;
     if(opt::numThreads > 1)
         pthread_exit(NULL);
@@ -214,7 +315,7 @@ size_t computeHitsSerial(const std::string& prefix, const std::string& readsFile
                          const OverlapAlgorithm* pOverlapper, int minOverlap, 
                          StringVector& filenameVec, std::ostream* pASQGWriter)
 {
-    std::string filename = prefix + HITS_EXT + GZIP_EXT;
+    std::string filename = prefix + HITS_EXT;
     filenameVec.push_back(filename);
 
     OverlapProcess processor(filename, pOverlapper, minOverlap);
@@ -237,13 +338,13 @@ size_t computeHitsParallel(int numThreads, const std::string& prefix, const std:
                            const OverlapAlgorithm* pOverlapper, int minOverlap, 
                            StringVector& filenameVec, std::ostream* pASQGWriter)
 {
-    std::string filename = prefix + HITS_EXT + GZIP_EXT;
+    std::string filename = prefix + HITS_EXT;
 
     std::vector<OverlapProcess*> processorVector;
     for(int i = 0; i < numThreads; ++i)
     {
         std::stringstream ss;
-        ss << prefix << "-thread" << i << HITS_EXT << GZIP_EXT;
+        ss << prefix << "-thread" << i << HITS_EXT;
         std::string outfile = ss.str();
         filenameVec.push_back(outfile);
         OverlapProcess* pProcessor = new OverlapProcess(outfile, pOverlapper, minOverlap);
@@ -266,56 +367,144 @@ size_t computeHitsParallel(int numThreads, const std::string& prefix, const std:
 //
 void convertHitsToASQG(const std::string& indexPrefix, const StringVector& hitsFilenames, std::ostream* pASQGWriter)
 {
-    // Load the suffix array index and the reverse suffix array index
-    // Note these are not the full suffix arrays
-    SuffixArray* pFwdSAI = new SuffixArray(indexPrefix + SAI_EXT);
-    SuffixArray* pRevSAI = new SuffixArray(indexPrefix + RSAI_EXT);
-
-    // Load the ReadInfoTable for the queries to look up the ID and lengths of the hits
-    ReadInfoTable* pQueryRIT = new ReadInfoTable(opt::readsFile);
-
-    // If the target file is not the query file, load its ReadInfoTable
-    ReadInfoTable* pTargetRIT;
-    if(!opt::targetFile.empty() && opt::targetFile != opt::readsFile)
-        pTargetRIT = new ReadInfoTable(opt::targetFile);
-    else
-        pTargetRIT = pQueryRIT;
-
-    bool bIsSelfCompare = pTargetRIT == pQueryRIT;
+    EdgeConversionTables tables;
+    tables.load(indexPrefix);
+    bool bIsSelfCompare = tables.pTargetRIT == tables.pQueryRIT;
 
     // Convert the hits to overlaps and write them to the asqg file as initial edges
     for(StringVector::const_iterator iter = hitsFilenames.begin(); iter != hitsFilenames.end(); ++iter)
     {
         printf("[%s] parsing file %s\n", PROGRAM_IDENT, iter->c_str());
-        std::istream* pReader = createReader(*iter);
+        HitsReader reader(*iter);
     
         // Read each hit sequentially, converting it to an overlap
-        std::string line;
-        while(getline(*pReader, line))
+        size_t readIdx;
+        bool isSubstring;
+        OverlapBlockList blocks;
+        OverlapVector ov;
+        while(reader.read(readIdx, isSubstring, blocks))
         {
-            size_t readIdx;
             size_t totalEntries;
-            bool isSubstring;
-            OverlapVector ov;
-            OverlapCommon::parseHitsString(line, pQueryRIT, pTargetRIT, pFwdSAI, pRevSAI, bIsSelfCompare, readIdx, totalEntries, ov, isSubstring);
+            ov.clear();
+            convertBlocksToOverlaps(readIdx, blocks, tables.pQueryRIT, tables.pTargetRIT, 
+                                    tables.pFwdSAI, tables.pRevSAI, bIsSelfCompare, totalEntries, ov);
             for(OverlapVector::iterator iter = ov.begin(); iter != ov.end(); ++iter)
             {
                 ASQG::EdgeRecord edgeRecord(*iter);
                 edgeRecord.write(*pASQGWriter);
             }
         }
-        delete pReader;
 
         // delete the hits file
         unlink(iter->c_str());
     }
+}
 
-    // Deallocate data
+// Compute the edges for each read with the number of threads requested
+size_t computeEdges(const std::string& readsFile, 
+                    const OverlapAlgorithm* pOverlapper, int minOverlap, 
+                    const EdgeConversionTables& tables, bool bBinaryEdges,
+                    OverlapEdgePostProcess* pPostProcessor)
+{
+    if(opt::numThreads <= 1)
+    {
+        printf("[%s] starting serial-mode overlap computation\n", PROGRAM_IDENT);
+        return computeEdgesSerial(readsFile, pOverlapper, minOverlap, tables, bBinaryEdges, pPostProcessor);
+    }
+    else
+    {
+        printf("[%s] starting parallel-mode overlap computation with %d threads\n", PROGRAM_IDENT, opt::numThreads);
+        return computeEdgesParallel(opt::numThreads, readsFile, pOverlapper, minOverlap, tables, bBinaryEdges, pPostProcessor);
+    }
+}
+
+// Compute the edges for each read in the input file without threading
+// Return the number of reads processed
+size_t computeEdgesSerial(const std::string& readsFile, 
+                          const OverlapAlgorithm* pOverlapper, int minOverlap, 
+                          const EdgeConversionTables& tables, bool bBinaryEdges,
+                          OverlapEdgePostProcess* pPostProcessor)
+{
+    OverlapEdgeProcess processor(pOverlapper, minOverlap, tables.pQueryRIT, tables.pTargetRIT, 
+                                 tables.pFwdSAI, tables.pRevSAI, bBinaryEdges);
+
+    size_t numProcessed = 
+           SequenceProcessFramework::processSequencesSerial<SequenceWorkItem,
+                                                            OverlapEdgeResult, 
+                                                            OverlapEdgeProcess, 
+                                                            OverlapEdgePostProcess>(readsFile, &processor, pPostProcessor);
+    return numProcessed;
+}
+
+// Compute the edges for each read with threading. The worker threads
+// find the overlap blocks and convert them to edges, the post processor
+// writes the vertices and edges in the order of the input reads.
+// The number of reads processsed is returned
+size_t computeEdgesParallel(int numThreads, const std::string& readsFile, 
+                            const OverlapAlgorithm* pOverlapper, int minOverlap, 
+                            const EdgeConversionTables& tables, bool bBinaryEdges,
+                            OverlapEdgePostProcess* pPostProcessor)
+{
+    std::vector<OverlapEdgeProcess*> processorVector;
+    for(int i = 0; i < numThreads; ++i)
+    {
+        OverlapEdgeProcess* pProcessor = new OverlapEdgeProcess(pOverlapper, minOverlap, 
+                                                                tables.pQueryRIT, tables.pTargetRIT, 
+                                                                tables.pFwdSAI, tables.pRevSAI, bBinaryEdges);
+        processorVector.push_back(pProcessor);
+    }
+
+    size_t numProcessed = 
+           SequenceProcessFramework::processSequencesParallel<SequenceWorkItem,
+                                                              OverlapEdgeResult, 
+                                                              OverlapEdgeProcess, 
+                                                              OverlapEdgePostProcess>(readsFile, processorVector, pPostProcessor);
+    for(int i = 0; i < numThreads; ++i)
+        delete processorVector[i];
+    return numProcessed;
+}
+
+// Copy the edge records into the ASQG file and delete the temporary file
+void appendEdges(const std::string& edgesFilename, std::ostream* pASQGWriter)
+{
+    std::istream* pReader = createReader(edgesFilename, std::ios::in | std::ios::binary);
+    std::vector<char> buffer(1 << 20);
+    while(pReader->read(&buffer[0], buffer.size()) || pReader->gcount() > 0)
+        pASQGWriter->write(&buffer[0], pReader->gcount());
+    delete pReader;
+    unlink(edgesFilename.c_str());
+}
+
+// Load the suffix array index and the reverse suffix array index
+// Note these are not the full suffix arrays
+void EdgeConversionTables::load(const std::string& indexPrefix)
+{
+    pFwdSAI = new SuffixArray(indexPrefix + SAI_EXT);
+    pRevSAI = new SuffixArray(indexPrefix + RSAI_EXT);
+
+    // Load the ReadInfoTable for the queries to look up the ID and lengths of the hits
+    pQueryRIT = new ReadInfoTable(opt::readsFile);
+
+    // If the target file is not the query file, load its ReadInfoTable
+    if(!opt::targetFile.empty() && opt::targetFile != opt::readsFile)
+        pTargetRIT = new ReadInfoTable(opt::targetFile);
+    else
+        pTargetRIT = pQueryRIT;
+}
+
+//
+void EdgeConversionTables::clear()
+{
     if(pTargetRIT != pQueryRIT)
         delete pTargetRIT;
     delete pFwdSAI;
     delete pRevSAI;
     delete pQueryRIT;
+
+    pFwdSAI = NULL;
+    pRevSAI = NULL;
+    pQueryRIT = NULL;
+    pTargetRIT = NULL;
 }
 
 // 
@@ -339,6 +528,8 @@ void parseOverlapOptions(int argc, char** argv)
             case 'd': arg >> opt::sampleRate; break;
             case 'f': arg >> opt::targetFile; break;
             case OPT_EXACT: opt::bExactIrreducible = true; break;
+            case OPT_NO_PIPELINE: opt::bPipelineEdges = false; break;
+            case OPT_BINARY: opt::bBinaryGraph = true; break;
             case 'x': opt::bIrreducibleOnly = false; break;
             case '?': die = true; break;
             case 'v': opt::verbose++; break;
@@ -368,6 +559,12 @@ void parseOverlapOptions(int argc, char** argv)
         die = true;
     }
 
+    if(opt::bBinaryGraph && (!opt::bPipelineEdges || !opt::targetFile.empty()))
+    {
+        std::cerr << SUBPROGRAM ": --binary cannot be used with --target-file or --no-pipeline\n";
+        die = true;
+    }
+
     if(!IS_POWER_OF_2(opt::sampleRate))
     {
         std::cerr << SUBPROGRAM ": invalid parameter to -d/--sample-rate, must be power of 2. got: " << opt::sampleRate << "\n";
@@ -401,6 +598,9 @@ void parseOverlapOptions(int argc, char** argv)
             prefix.append(1,'.');
             prefix.append(stripFilename(opt::targetFile));
         }
-        opt::outFile = prefix + ASQG_EXT + GZIP_EXT;
+        if(opt::bBinaryGraph)
+            opt::outFile = prefix + BSQG_EXT;
+        else
+            opt::outFile = prefix + ASQG_EXT + GZIP_EXT;
     }
 }
@@ -1988,7 +1988,7 @@ int preQCMain(int argc, char** argv)
         fprintf(stderr, "Loading FM-index of %s\n", opt::readsFile.c_str());
         index_set.pBWT = new BWT(opt::prefix + BWT_EXT);
         index_set.pSSA = new SampledSuffixArray(opt::prefix + SAI_EXT, SSA_FT_SAI);
-        index_set.pCache = new BWTIntervalCache(10, index_set.pBWT);
+        index_set.pCache = BWTIntervalCache::load(opt::prefix + IC_EXT, 10, index_set.pBWT, NULL, opt::numThreads);
 
         if(!opt::diploidReferenceMode)
         {
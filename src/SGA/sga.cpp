@@ -30,6 +30,7 @@
 #include "cluster.h"
 #include "gen-ssa.h"
 #include "bwt2fa.h"
+#include "convert-bwt.h"
 #include "graph-diff.h"
 #include "gapfill.h"
 #include "variant-detectability.h"
@@ -59,6 +60,7 @@ static const char *SGA_USAGE_MESSAGE =
 "           index                    build the BWT and FM-index for a set of reads\n"
 "           merge                    merge multiple BWT/FM-index files into a single index\n"
 "           bwt2fa                   transform a bwt back into a set of sequences\n"
+"           convert-bwt              convert a bwt file into a memory-mappable layout\n"
 "           correct                  correct sequencing errors in a set of reads\n"
 "           fm-merge                 merge unambiguously overlapped sequences using the FM-index\n"
 "           overlap                  compute overlaps between reads\n"
@@ -151,6 +153,8 @@ int main(int argc, char** argv)
             genSSAMain(argc - 1, argv + 1);
         else if(command == "bwt2fa")
             bwt2faMain(argc - 1, argv + 1);
+        else if(command == "convert-bwt")
+            convertBWTMain(argc - 1, argv + 1);
         else if(command == "graph-diff")
             graphDiffMain(argc - 1, argv + 1);
         else if(command == "gapfill")
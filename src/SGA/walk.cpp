@@ -267,8 +267,8 @@ void componentWalk(StringGraph* pGraph, SGWalkVector& outWalks)
     for(size_t i = 0; i < selectedComponent.size(); ++i)
     {
         Vertex* pVertex = selectedComponent[i];
-        size_t asCount = pVertex->getEdges(ED_ANTISENSE).size();
-        size_t sCount = pVertex->getEdges(ED_SENSE).size();
+        size_t asCount = pVertex->countEdges(ED_ANTISENSE);
+        size_t sCount = pVertex->countEdges(ED_SENSE);
 
         if(asCount == 0 || sCount == 0)
             terminals.push_back(pVertex);
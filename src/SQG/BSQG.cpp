@@ -0,0 +1,241 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// BSQG - Binary string graph files
+//
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "BSQG.h"
+#include "Alphabet.h"
+
+namespace BSQG
+{
+
+// Sections start on a multiple of this number of bytes
+static const size_t SECTION_ALIGNMENT = 8;
+
+//
+bool isBSQGFile(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    uint32_t magic = 0;
+    file.read((char*)&magic, sizeof(magic));
+    return file.gcount() == sizeof(magic) && magic == FILE_MAGIC;
+}
+
+//
+Writer::Writer(const std::string& filename) : m_filename(filename),
+                                              m_vertexTempName(filename + ".vertices.tmp"),
+                                              m_nameTempName(filename + ".names.tmp"),
+                                              m_seqTempName(filename + ".seqs.tmp"),
+                                              m_nameSize(0),
+                                              m_seqSize(0),
+                                              m_maxEdgeVertex(0),
+                                              m_isClosed(false)
+{
+    memset(&m_header, 0, sizeof(m_header));
+    m_header.magic = FILE_MAGIC;
+    m_header.version = FILE_VERSION;
+
+    m_file.open(filename.c_str(), std::ios::out | std::ios::binary);
+    assertFileOpen(m_file, filename);
+    m_vertexFile.open(m_vertexTempName.c_str(), std::ios::out | std::ios::binary);
+    assertFileOpen(m_vertexFile, m_vertexTempName);
+    m_nameFile.open(m_nameTempName.c_str(), std::ios::out | std::ios::binary);
+    assertFileOpen(m_nameFile, m_nameTempName);
+    m_seqFile.open(m_seqTempName.c_str(), std::ios::out | std::ios::binary);
+    assertFileOpen(m_seqFile, m_seqTempName);
+
+    // The header is rewritten once the sizes of the sections are known.
+    // The edge section follows it.
+    m_file.write((const char*)&m_header, sizeof(m_header));
+    align();
+    m_header.edgeOffset = m_file.tellp();
+}
+
+//
+Writer::~Writer()
+{
+    close();
+}
+
+//
+size_t Writer::addVertex(const std::string& id, const std::string& seq, bool isSubstring)
+{
+    if(seq.size() > (uint32_t)-1)
+    {
+        std::cerr << "Error: the sequence of vertex " << id << " is too long for a BSQG file\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // Edges store the vertex indices in 32 bits
+    if(m_header.numVertices >= (uint32_t)-1)
+    {
+        std::cerr << "Error: the graph has too many vertices for a BSQG file\n";
+        exit(EXIT_FAILURE);
+    }
+
+    VertexEntry entry;
+    entry.nameOffset = m_nameSize;
+    entry.seqOffset = m_seqSize;
+    entry.seqLength = seq.size();
+    entry.flags = isSubstring ? VF_SUBSTRING : 0;
+    m_vertexFile.write((const char*)&entry, sizeof(entry));
+
+    m_nameFile.write(id.c_str(), id.size() + 1);
+    m_nameSize += id.size() + 1;
+
+    // Bases are encoded the same way as in a DNAEncodedString
+    m_packed.assign((seq.size() + 3) / 4, 0);
+    for(size_t i = 0; i < seq.size(); ++i)
+        m_packed[i / 4] |= DNA_ALPHABET::getBaseRank(seq[i]) << (2 * (i % 4));
+    m_seqFile.write(m_packed.data(), m_packed.size());
+    m_seqSize += m_packed.size();
+
+    return m_header.numVertices++;
+}
+
+//
+void Writer::addEdge(size_t idx0, size_t idx1, const Match& match)
+{
+    EdgeEntry entry;
+    entry.vertex[0] = idx0;
+    entry.vertex[1] = idx1;
+    for(size_t i = 0; i < 2; ++i)
+    {
+        entry.start[i] = match.coord[i].interval.start;
+        entry.end[i] = match.coord[i].interval.end;
+    }
+    entry.flags = match.isRC() ? EF_REVERSE : 0;
+    entry.numDiff = match.getNumDiffs();
+    m_file.write((const char*)&entry, sizeof(entry));
+
+    m_maxEdgeVertex = std::max(m_maxEdgeVertex, (uint64_t)std::max(idx0, idx1));
+    m_header.numEdges += 1;
+}
+
+//
+void Writer::close()
+{
+    if(m_isClosed)
+        return;
+    m_isClosed = true;
+
+    if(m_header.numEdges > 0 && m_maxEdgeVertex >= m_header.numVertices)
+    {
+        std::cerr << "Error: an edge of " << m_filename << " refers to vertex " << m_maxEdgeVertex
+                  << " but the graph only has " << m_header.numVertices << " vertices\n";
+        exit(EXIT_FAILURE);
+    }
+
+    m_vertexFile.close();
+    m_nameFile.close();
+    m_seqFile.close();
+
+    writeSection(m_vertexTempName, m_header.vertexOffset);
+    writeSection(m_nameTempName, m_header.nameOffset);
+    writeSection(m_seqTempName, m_header.seqOffset);
+    m_header.nameSize = m_nameSize;
+    m_header.seqSize = m_seqSize;
+
+    m_file.seekp(0);
+    m_file.write((const char*)&m_header, sizeof(m_header));
+    m_file.close();
+    if(m_file.fail())
+    {
+        std::cerr << "Error: failed to write " << m_filename << "\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Append the contents of a temporary file to the output and delete it
+void Writer::writeSection(const std::string& tempName, uint64_t& offset)
+{
+    align();
+    offset = m_file.tellp();
+
+    std::ifstream reader(tempName.c_str(), std::ios::in | std::ios::binary);
+    assertFileOpen(reader, tempName);
+    std::vector<char> buffer(1 << 20);
+    while(reader.read(&buffer[0], buffer.size()) || reader.gcount() > 0)
+        m_file.write(&buffer[0], reader.gcount());
+    reader.close();
+    unlink(tempName.c_str());
+}
+
+// Pad the output to the next section boundary
+void Writer::align()
+{
+    size_t pos = m_file.tellp();
+    static const char padding[SECTION_ALIGNMENT] = { 0 };
+    if(pos % SECTION_ALIGNMENT != 0)
+        m_file.write(padding, SECTION_ALIGNMENT - pos % SECTION_ALIGNMENT);
+}
+
+//
+Reader::Reader(const std::string& filename) : m_file(filename)
+{
+    if(m_file.getSize() < sizeof(FileHeader))
+    {
+        std::cerr << "Error: " << filename << " is not a BSQG file\n";
+        exit(EXIT_FAILURE);
+    }
+
+    m_pHeader = (const FileHeader*)m_file.getData();
+    if(m_pHeader->magic != FILE_MAGIC)
+    {
+        std::cerr << "Error: " << filename << " is not a BSQG file\n";
+        exit(EXIT_FAILURE);
+    }
+
+    if(m_pHeader->version != FILE_VERSION)
+    {
+        std::cerr << "Error: " << filename << " has BSQG version " << m_pHeader->version
+                  << ", expected version " << FILE_VERSION << "\n";
+        exit(EXIT_FAILURE);
+    }
+
+    checkSection(m_pHeader->edgeOffset, m_pHeader->numEdges * sizeof(EdgeEntry));
+    checkSection(m_pHeader->vertexOffset, m_pHeader->numVertices * sizeof(VertexEntry));
+    checkSection(m_pHeader->nameOffset, m_pHeader->nameSize);
+    checkSection(m_pHeader->seqOffset, m_pHeader->seqSize);
+
+    m_pEdges = (const EdgeEntry*)m_file.getData(m_pHeader->edgeOffset);
+    m_pVertices = (const VertexEntry*)m_file.getData(m_pHeader->vertexOffset);
+    m_pNames = m_file.getData(m_pHeader->nameOffset);
+    m_pSeqs = (const uint8_t*)m_file.getData(m_pHeader->seqOffset);
+}
+
+//
+void Reader::checkSection(uint64_t offset, uint64_t size) const
+{
+    if(offset > m_file.getSize() || size > m_file.getSize() - offset)
+    {
+        std::cerr << "Error: BSQG file is truncated or corrupt\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+//
+void Reader::getSeq(size_t idx, std::string& out) const
+{
+    const VertexEntry& entry = m_pVertices[idx];
+    const uint8_t* pPacked = m_pSeqs + entry.seqOffset;
+    out.resize(entry.seqLength);
+    for(size_t i = 0; i < entry.seqLength; ++i)
+        out[i] = DNA_ALPHABET::getBase((pPacked[i / 4] >> (2 * (i % 4))) & 0x3);
+}
+
+//
+Match Reader::getMatch(size_t idx) const
+{
+    const EdgeEntry& entry = m_pEdges[idx];
+    return Match(entry.start[0], entry.end[0], m_pVertices[entry.vertex[0]].seqLength,
+                 entry.start[1], entry.end[1], m_pVertices[entry.vertex[1]].seqLength,
+                 entry.flags & EF_REVERSE, entry.numDiff);
+}
+
+};
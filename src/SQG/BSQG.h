@@ -0,0 +1,159 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// BSQG - Binary string graph files. A BSQG file holds
+// the same graph as an ASQG file in fixed-width tables
+// that can be used directly from a memory mapping.
+//
+// The file starts with a FileHeader that holds the graph
+// parameters and the offsets of the sections:
+//  - the edge table, one EdgeEntry per overlap
+//  - the vertex table, one VertexEntry per vertex
+//  - the vertex names, each terminated by a NUL
+//  - the vertex sequences, packed 2 bits per base with
+//    each sequence starting on a byte boundary
+// Each section starts on an 8 byte boundary. Edges refer to
+// vertices by their position in the vertex table. The ASQG
+// vertex substring tag is stored in the vertex flags.
+//
+#ifndef BSQG_H
+#define BSQG_H
+
+#include <fstream>
+#include "Match.h"
+#include "MappedFile.h"
+
+namespace BSQG
+{
+    const uint32_t FILE_MAGIC = 0x47515342; // "BSQG"
+    const uint32_t FILE_VERSION = 1;
+
+    // Vertex flags
+    const uint32_t VF_SUBSTRING = 0x1;
+
+    // Edge flags
+    const uint32_t EF_REVERSE = 0x1;
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        int32_t minOverlap;
+        uint8_t hasContainment;
+        uint8_t hasTransitive;
+        uint8_t reserved[2];
+        double errorRate;
+
+        uint64_t numVertices;
+        uint64_t numEdges;
+
+        uint64_t edgeOffset;
+        uint64_t vertexOffset;
+        uint64_t nameOffset;
+        uint64_t nameSize;
+        uint64_t seqOffset;
+        uint64_t seqSize;
+    };
+
+    struct VertexEntry
+    {
+        // Offsets into the name and sequence sections, in bytes
+        uint64_t nameOffset;
+        uint64_t seqOffset;
+        uint32_t seqLength;
+        uint32_t flags;
+    };
+
+    // The matching intervals of an overlap between two vertices,
+    // as in the ED record of an ASQG file
+    struct EdgeEntry
+    {
+        uint32_t vertex[2];
+        int32_t start[2];
+        int32_t end[2];
+        uint32_t flags;
+        int32_t numDiff;
+    };
+
+    // Returns true if the file starts with the BSQG magic number
+    bool isBSQGFile(const std::string& filename);
+
+    // Write a BSQG file. The edges are written to the file
+    // as they are added. The vertex sections are spooled to
+    // temporary files and appended when the writer is closed
+    // so that the memory required does not grow with the graph.
+    class Writer
+    {
+        public:
+            Writer(const std::string& filename);
+            ~Writer();
+
+            void setMinOverlap(int minOverlap) { m_header.minOverlap = minOverlap; }
+            void setErrorRate(double errorRate) { m_header.errorRate = errorRate; }
+            void setContainment(bool b) { m_header.hasContainment = b; }
+            void setTransitive(bool b) { m_header.hasTransitive = b; }
+
+            // Add a vertex, returning its index in the vertex table
+            size_t addVertex(const std::string& id, const std::string& seq, bool isSubstring);
+
+            // Add an overlap between the vertices with the given indices.
+            // The vertices do not need to be added before the edge.
+            void addEdge(size_t idx0, size_t idx1, const Match& match);
+
+            // Append the vertex sections and write the header
+            void close();
+
+        private:
+            void writeSection(const std::string& tempName, uint64_t& offset);
+            void align();
+
+            std::string m_filename;
+            std::string m_vertexTempName;
+            std::string m_nameTempName;
+            std::string m_seqTempName;
+
+            std::ofstream m_file;
+            std::ofstream m_vertexFile;
+            std::ofstream m_nameFile;
+            std::ofstream m_seqFile;
+
+            FileHeader m_header;
+            uint64_t m_nameSize;
+            uint64_t m_seqSize;
+            uint64_t m_maxEdgeVertex;
+            std::string m_packed;
+            bool m_isClosed;
+    };
+
+    // Memory mapped BSQG file
+    class Reader
+    {
+        public:
+            Reader(const std::string& filename);
+
+            const FileHeader& getHeader() const { return *m_pHeader; }
+            size_t getNumVertices() const { return m_pHeader->numVertices; }
+            size_t getNumEdges() const { return m_pHeader->numEdges; }
+
+            const VertexEntry& getVertex(size_t idx) const { return m_pVertices[idx]; }
+            const char* getName(size_t idx) const { return m_pNames + m_pVertices[idx].nameOffset; }
+            void getSeq(size_t idx, std::string& out) const;
+
+            const EdgeEntry& getEdge(size_t idx) const { return m_pEdges[idx]; }
+            Match getMatch(size_t idx) const;
+
+        private:
+            void checkSection(uint64_t offset, uint64_t size) const;
+
+            MappedFile m_file;
+            const FileHeader* m_pHeader;
+            const EdgeEntry* m_pEdges;
+            const VertexEntry* m_pVertices;
+            const char* m_pNames;
+            const uint8_t* m_pSeqs;
+    };
+};
+
+#endif
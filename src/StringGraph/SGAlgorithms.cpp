@@ -14,24 +14,29 @@
 
 // add edges to the graph for the given overlap
 Edge* SGAlgorithms::createEdgesFromOverlap(StringGraph* pGraph, const Overlap& o, bool allowContained, size_t maxEdges)
+{
+    Vertex* pX = pGraph->getVertex(o.id[0]);
+    Vertex* pY = pGraph->getVertex(o.id[1]);
+
+    // If one of the vertices is not in the graph, skip this edge
+    // This can occur if one of the verts is a strict substring of some other vertex so it will
+    // never be added to the graph
+    if(pX == NULL || pY == NULL)
+        return NULL;
+    return createEdgesFromOverlap(pGraph, pX, pY, o, allowContained, maxEdges);
+}
+
+//
+Edge* SGAlgorithms::createEdgesFromOverlap(StringGraph* pGraph, Vertex* pX, Vertex* pY, 
+                                           const Overlap& o, bool allowContained, size_t maxEdges)
 {
     // Initialize data and perform checks
-    Vertex* pVerts[2];
+    Vertex* pVerts[2] = { pX, pY };
     EdgeComp comp = (o.match.isRC()) ? EC_REVERSE : EC_SAME;
 
     bool isContainment = o.match.isContainment();
     assert(allowContained || !isContainment);
     (void)allowContained;
-    for(size_t idx = 0; idx < 2; ++idx)
-    {
-        pVerts[idx] = pGraph->getVertex(o.id[idx]);
-
-        // If one of the vertices is not in the graph, skip this edge
-        // This can occur if one of the verts is a strict substring of some other vertex so it will
-        // never be added to the graph
-        if(pVerts[idx] == NULL)
-            return NULL;
-    }
 
     // Check if this is a substring containment, if so mark the contained read
     // but do not create edges
@@ -35,6 +35,12 @@ void remodelVertexForExcision(StringGraph* pGraph, Vertex* pVertex, Edge* pDelet
 // if the edges cannot be added
 Edge* createEdgesFromOverlap(StringGraph* pGraph, const Overlap& o, bool allowContained, size_t maxEdges = -1);
 
+// As above for an overlap between the vertices pX and pY, which must
+// be the vertices named by o.id. The ids are only used when the vertices
+// are contained in each other.
+Edge* createEdgesFromOverlap(StringGraph* pGraph, Vertex* pX, Vertex* pY, 
+                             const Overlap& o, bool allowContained, size_t maxEdges = -1);
+
 // Calculate the error rate between the two vertex sequences
 double calcErrorRate(const Vertex* pX, const Vertex* pY, const Overlap& ovrXY);
 
@@ -11,107 +11,382 @@
 #include "SeqReader.h"
 #include "SGAlgorithms.h"
 #include "SGVisitors.h"
+#include "WorkStealingPool.h"
+#include "BSQG.h"
+#include <algorithm>
+#include <deque>
 
-StringGraph* SGUtil::loadASQG(const std::string& filename, const unsigned int minOverlap, 
-                              bool allowContainments, size_t maxEdges)
+// The size of the blocks of text parsed by the threads of the parallel loader
+static const size_t ASQG_BLOCK_SIZE = 1 << 20;
+
+// The number of blocks per thread that can be in flight
+static const size_t ASQG_BLOCKS_PER_THREAD = 4;
+
+// Add the records of an ASQG file to a graph. The records
+// must be added in the order they appear in the file so
+// the serial and parallel loaders build the same graph.
+class ASQGGraphBuilder
 {
-    // Initialize graph
-    StringGraph* pGraph = new StringGraph;
+    public:
+        ASQGGraphBuilder(StringGraph* pGraph, unsigned int minOverlap, 
+                         bool allowContainments, size_t maxEdges) : m_pGraph(pGraph),
+                                                                    m_minOverlap(minOverlap),
+                                                                    m_allowContainments(allowContainments),
+                                                                    m_maxEdges(maxEdges),
+                                                                    m_stage(0) {}
+
+        void addHeader(const std::string& recordLine, size_t line)
+        {
+            if(m_stage != 0)
+            {
+                std::cerr << "Error: Unexpected header record found at line " << line << "\n";
+                exit(EXIT_FAILURE);
+            }
 
-    std::istream* pReader = createReader(filename);
+            ASQG::HeaderRecord headerRecord(recordLine);
+            const SQG::IntTag& overlapTag = headerRecord.getOverlapTag();
+            if(overlapTag.isInitialized())
+                m_pGraph->setMinOverlap(overlapTag.get());
+            else
+                m_pGraph->setMinOverlap(0);
 
-    int stage = 0;
-    int line = 0;
-    std::string recordLine;
-    while(getline(*pReader, recordLine))
-    {
-        ASQG::RecordType rt = ASQG::getRecordType(recordLine);
-        switch(rt)
+            const SQG::FloatTag& errorRateTag = headerRecord.getErrorRateTag();
+            if(errorRateTag.isInitialized())
+                m_pGraph->setErrorRate(errorRateTag.get());
+            
+            const SQG::IntTag& containmentTag = headerRecord.getContainmentTag();
+            if(containmentTag.isInitialized())
+                m_pGraph->setContainmentFlag(containmentTag.get());
+            else
+                m_pGraph->setContainmentFlag(true); // conservatively assume containments are present
+
+            const SQG::IntTag& transitiveTag = headerRecord.getTransitiveTag();
+            if(!transitiveTag.isInitialized())
+            {
+                std::cerr << "Warning: ASQG does not have transitive tag\n";
+                m_pGraph->setTransitiveFlag(true);
+            }
+            else
+            {
+                m_pGraph->setTransitiveFlag(transitiveTag.get());
+            }
+        }
+
+        void addVertex(const ASQG::VertexRecord& vertexRecord, size_t line)
         {
-            case ASQG::RT_HEADER:
+            // progress the stage if we are done the header
+            if(m_stage == 0)
+                m_stage = 1;
+
+            if(m_stage != 1)
             {
-                if(stage != 0)
-                {
-                    std::cerr << "Error: Unexpected header record found at line " << line << "\n";
-                    exit(EXIT_FAILURE);
-                }
+                std::cerr << "Error: Unexpected vertex record found at line " << line << "\n";
+                exit(EXIT_FAILURE);
+            }
 
-                ASQG::HeaderRecord headerRecord(recordLine);
-                const SQG::IntTag& overlapTag = headerRecord.getOverlapTag();
-                if(overlapTag.isInitialized())
-                    pGraph->setMinOverlap(overlapTag.get());
-                else
-                    pGraph->setMinOverlap(0);
-
-                const SQG::FloatTag& errorRateTag = headerRecord.getErrorRateTag();
-                if(errorRateTag.isInitialized())
-                    pGraph->setErrorRate(errorRateTag.get());
-                
-                const SQG::IntTag& containmentTag = headerRecord.getContainmentTag();
-                if(containmentTag.isInitialized())
-                    pGraph->setContainmentFlag(containmentTag.get());
-                else
-                    pGraph->setContainmentFlag(true); // conservatively assume containments are present
-
-                const SQG::IntTag& transitiveTag = headerRecord.getTransitiveTag();
-                if(!transitiveTag.isInitialized())
-                {
-                    std::cerr << "Warning: ASQG does not have transitive tag\n";
-                    pGraph->setTransitiveFlag(true);
-                }
-                else
-                {
-                    pGraph->setTransitiveFlag(transitiveTag.get());
-                }
+            const SQG::IntTag& ssTag = vertexRecord.getSubstringTag();
+            createVertex(vertexRecord.getID(), vertexRecord.getSeq(), ssTag.isInitialized() && ssTag.get() == 1);
+        }
 
-                break;
+        void addEdge(const Overlap& ovr, size_t line)
+        {
+            if(m_stage == 1)
+                m_stage = 2;
+            
+            if(m_stage != 2)
+            {
+                std::cerr << "Error: Unexpected edge record found at line " << line << "\n";
+                exit(EXIT_FAILURE);
             }
-            case ASQG::RT_VERTEX:
+
+            // Add the edge to the graph
+            if(ovr.match.getMinOverlapLength() >= (int)m_minOverlap)
+                SGAlgorithms::createEdgesFromOverlap(m_pGraph, ovr, m_allowContainments, m_maxEdges);
+        }
+
+        // Add a vertex without checking the order of the records
+        Vertex* createVertex(const std::string& id, const std::string& seq, bool isSubstring)
+        {
+            Vertex* pVertex = m_pGraph->createVertex(id, seq);
+            if(isSubstring)
             {
-                // progress the stage if we are done the header
-                if(stage == 0)
-                    stage = 1;
+                // Vertex is a substring of some other vertex, mark it as contained
+                pVertex->setContained(true);
+                m_pGraph->setContainmentFlag(true);
+            }
+            m_pGraph->addVertex(pVertex);
+            return pVertex;
+        }
 
-                if(stage != 1)
-                {
-                    std::cerr << "Error: Unexpected vertex record found at line " << line << "\n";
-                    exit(EXIT_FAILURE);
-                }
+        // Add the edges for an overlap between two vertices that are known to be in the graph
+        void createEdges(Vertex* pX, Vertex* pY, const Overlap& ovr)
+        {
+            if(ovr.match.getMinOverlapLength() >= (int)m_minOverlap)
+                SGAlgorithms::createEdgesFromOverlap(m_pGraph, pX, pY, ovr, m_allowContainments, m_maxEdges);
+        }
 
-                ASQG::VertexRecord vertexRecord(recordLine);
-                const SQG::IntTag& ssTag = vertexRecord.getSubstringTag();
+    private:
+        StringGraph* m_pGraph;
+        unsigned int m_minOverlap;
+        bool m_allowContainments;
+        size_t m_maxEdges;
+        int m_stage;
+};
 
-                Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(vertexRecord.getID(), vertexRecord.getSeq());
-                if(ssTag.isInitialized() && ssTag.get() == 1)
+// A block of complete lines of the ASQG file
+struct ASQGTextBlock
+{
+    std::string text;
+    size_t firstLine;
+};
+
+// The records parsed from an ASQG text block. Header records are
+// rare so they are kept as text and parsed when they are added.
+struct ASQGRecordBlock
+{
+    struct Record
+    {
+        ASQG::RecordType type;
+        size_t index;
+    };
+
+    std::vector<Record> records;
+    std::vector<std::string> headers;
+    std::vector<ASQG::VertexRecord> vertices;
+    std::vector<Overlap> overlaps;
+};
+
+// Tokenize and parse the records of a text block
+class ASQGParseProcess
+{
+    public:
+        ASQGRecordBlock* process(const ASQGTextBlock& block)
+        {
+            ASQGRecordBlock* pOut = new ASQGRecordBlock;
+            const std::string& text = block.text;
+            std::string recordLine;
+            size_t pos = 0;
+            while(pos < text.size())
+            {
+                size_t end = text.find('\n', pos);
+                if(end == std::string::npos)
+                    end = text.size();
+                recordLine.assign(text, pos, end - pos);
+                pos = end + 1;
+
+                ASQGRecordBlock::Record record;
+                record.type = ASQG::getRecordType(recordLine);
+                switch(record.type)
                 {
-                    // Vertex is a substring of some other vertex, mark it as contained
-                    pVertex->setContained(true);
-                    pGraph->setContainmentFlag(true);
+                    case ASQG::RT_HEADER:
+                        record.index = pOut->headers.size();
+                        pOut->headers.push_back(recordLine);
+                        break;
+                    case ASQG::RT_VERTEX:
+                        record.index = pOut->vertices.size();
+                        pOut->vertices.push_back(ASQG::VertexRecord(recordLine));
+                        break;
+                    case ASQG::RT_EDGE:
+                        record.index = pOut->overlaps.size();
+                        pOut->overlaps.push_back(ASQG::EdgeRecord(recordLine).getOverlap());
+                        break;
                 }
-                pGraph->addVertex(pVertex);
+                pOut->records.push_back(record);
+            }
+            return pOut;
+        }
+};
+
+typedef WorkStealingPool<ASQGTextBlock, ASQGRecordBlock*, ASQGParseProcess> ASQGParsePool;
+
+// Read the next block of complete lines into pChunk. Text after the
+// last newline is held in leftover until the next block is read.
+// Returns false if the file is exhausted.
+static bool readASQGBlock(std::istream* pReader, std::string& leftover, 
+                          size_t& nextLine, ASQGParsePool::Chunk* pChunk)
+{
+    ASQGTextBlock& block = pChunk->input[0];
+    block.text.swap(leftover);
+    leftover.clear();
+
+    bool eof = false;
+    size_t cut = std::string::npos;
+    while(!eof && cut == std::string::npos)
+    {
+        size_t oldSize = block.text.size();
+        block.text.resize(oldSize + ASQG_BLOCK_SIZE);
+        pReader->read(&block.text[oldSize], ASQG_BLOCK_SIZE);
+        block.text.resize(oldSize + pReader->gcount());
+        eof = pReader->gcount() < (std::streamsize)ASQG_BLOCK_SIZE;
+        cut = block.text.rfind('\n');
+    }
+
+    if(!eof)
+    {
+        leftover.assign(block.text, cut + 1, std::string::npos);
+        block.text.resize(cut + 1);
+    }
+
+    if(block.text.empty())
+        return false;
+
+    block.firstLine = nextLine;
+    nextLine += std::count(block.text.begin(), block.text.end(), '\n');
+    return true;
+}
+
+// Parse the file on numThreads threads and add the records
+// to the graph on this thread in file order
+static void loadASQGParallel(std::istream* pReader, ASQGGraphBuilder& builder, int numThreads)
+{
+    std::vector<ASQGParseProcess*> processPtrVector;
+    for(int i = 0; i < numThreads; ++i)
+        processPtrVector.push_back(new ASQGParseProcess);
+
+    ASQGParsePool pool(processPtrVector);
+    pool.start();
+
+    std::deque<ASQGParsePool::Chunk*> reorderQueue;
+    size_t maxChunks = ASQG_BLOCKS_PER_THREAD * numThreads;
+    std::string leftover;
+    size_t nextLine = 0;
+    bool done = false;
+    while(true)
+    {
+        while(!done && reorderQueue.size() < maxChunks)
+        {
+            ASQGParsePool::Chunk* pChunk = new ASQGParsePool::Chunk;
+            pChunk->input.resize(1);
+            if(!readASQGBlock(pReader, leftover, nextLine, pChunk))
+            {
+                delete pChunk;
+                done = true;
                 break;
             }
-            case ASQG::RT_EDGE:
+            pool.submit(pChunk);
+            reorderQueue.push_back(pChunk);
+        }
+
+        if(reorderQueue.empty())
+            break;
+
+        ASQGParsePool::Chunk* pChunk = reorderQueue.front();
+        reorderQueue.pop_front();
+        pool.wait(pChunk);
+
+        ASQGRecordBlock* pBlock = pChunk->output[0];
+        size_t line = pChunk->input[0].firstLine;
+        for(size_t i = 0; i < pBlock->records.size(); ++i, ++line)
+        {
+            const ASQGRecordBlock::Record& record = pBlock->records[i];
+            switch(record.type)
             {
-                if(stage == 1)
-                    stage = 2;
-                
-                if(stage != 2)
-                {
-                    std::cerr << "Error: Unexpected edge record found at line " << line << "\n";
-                    exit(EXIT_FAILURE);
-                }
+                case ASQG::RT_HEADER:
+                    builder.addHeader(pBlock->headers[record.index], line);
+                    break;
+                case ASQG::RT_VERTEX:
+                    builder.addVertex(pBlock->vertices[record.index], line);
+                    break;
+                case ASQG::RT_EDGE:
+                    builder.addEdge(pBlock->overlaps[record.index], line);
+                    break;
+            }
+        }
+        delete pBlock;
+        delete pChunk;
+    }
 
-                ASQG::EdgeRecord edgeRecord(recordLine);
-                const Overlap& ovr = edgeRecord.getOverlap();
+    pool.stop();
+    for(int i = 0; i < numThreads; ++i)
+        delete processPtrVector[i];
+}
 
-                // Add the edge to the graph
-                if(ovr.match.getMinOverlapLength() >= (int)minOverlap)
-                    SGAlgorithms::createEdgesFromOverlap(pGraph, ovr, allowContainments, maxEdges);
-                break;
+// Add the vertices and edges of a memory-mapped BSQG file to the graph.
+// The records are added in the same order as the records of the ASQG
+// file the graph was written from.
+static void loadBSQG(const std::string& filename, StringGraph* pGraph, ASQGGraphBuilder& builder)
+{
+    BSQG::Reader reader(filename);
+    const BSQG::FileHeader& header = reader.getHeader();
+    pGraph->setMinOverlap(header.minOverlap);
+    pGraph->setErrorRate(header.errorRate);
+    pGraph->setContainmentFlag(header.hasContainment);
+    pGraph->setTransitiveFlag(header.hasTransitive);
+
+    size_t numVertices = reader.getNumVertices();
+    std::vector<Vertex*> vertices(numVertices);
+    std::string seq;
+    for(size_t i = 0; i < numVertices; ++i)
+    {
+        reader.getSeq(i, seq);
+        bool isSubstring = reader.getVertex(i).flags & BSQG::VF_SUBSTRING;
+        vertices[i] = builder.createVertex(reader.getName(i), seq, isSubstring);
+    }
+
+    Overlap ovr;
+    for(size_t i = 0; i < reader.getNumEdges(); ++i)
+    {
+        const BSQG::EdgeEntry& entry = reader.getEdge(i);
+        if(entry.vertex[0] >= numVertices || entry.vertex[1] >= numVertices)
+        {
+            std::cerr << "Error: edge " << i << " of " << filename << " refers to a vertex that does not exist\n";
+            exit(EXIT_FAILURE);
+        }
+
+        Vertex* pX = vertices[entry.vertex[0]];
+        Vertex* pY = vertices[entry.vertex[1]];
+        ovr.match = reader.getMatch(i);
+
+        // The ids are only needed to resolve containments
+        if(ovr.match.isContainment())
+        {
+            ovr.id[0] = pX->getID();
+            ovr.id[1] = pY->getID();
+        }
+        builder.createEdges(pX, pY, ovr);
+    }
+}
+
+//
+StringGraph* SGUtil::loadASQG(const std::string& filename, const unsigned int minOverlap, 
+                              bool allowContainments, size_t maxEdges, int numThreads)
+{
+    // Initialize graph
+    StringGraph* pGraph = new StringGraph;
+    ASQGGraphBuilder builder(pGraph, minOverlap, allowContainments, maxEdges);
+
+    std::istream* pReader = NULL;
+    if(BSQG::isBSQGFile(filename))
+    {
+        loadBSQG(filename, pGraph, builder);
+    }
+    else if(numThreads > 1)
+    {
+        pReader = createReader(filename);
+        loadASQGParallel(pReader, builder, numThreads);
+    }
+    else
+    {
+        pReader = createReader(filename);
+        size_t line = 0;
+        std::string recordLine;
+        while(getline(*pReader, recordLine))
+        {
+            ASQG::RecordType rt = ASQG::getRecordType(recordLine);
+            switch(rt)
+            {
+                case ASQG::RT_HEADER:
+                    builder.addHeader(recordLine, line);
+                    break;
+                case ASQG::RT_VERTEX:
+                    builder.addVertex(ASQG::VertexRecord(recordLine), line);
+                    break;
+                case ASQG::RT_EDGE:
+                    builder.addEdge(ASQG::EdgeRecord(recordLine).getOverlap(), line);
+                    break;
             }
+            ++line;
         }
-        ++line;
     }
 
     // Completely delete the edges for all nodes that were marked as super-repetitive in the graph
@@ -120,10 +395,9 @@ StringGraph* SGUtil::loadASQG(const std::string& filename, const unsigned int mi
 
     // Remove any duplicate edges
     SGDuplicateVisitor dupVisit;
-    pGraph->visit(dupVisit);
+    pGraph->visitParallel(dupVisit, numThreads);
 
-    SGGraphStatsVisitor statsVisit;
-    pGraph->visit(statsVisit);
+    pGraph->printStats();
     // Remove identical vertices
     // This is much cheaper to do than remove via
     // SGContainRemove as no remodelling needs to occur
@@ -151,7 +425,7 @@ StringGraph* SGUtil::loadFASTA(const std::string& filename)
 
     while(reader.get(record))
     {
-        Vertex* pVertex = new(pGraph->getVertexAllocator()) Vertex(record.id, record.seq.toString());
+        Vertex* pVertex = pGraph->createVertex(record.id, record.seq.toString());
         pGraph->addVertex(pVertex);
     }
     return pGraph;
@@ -21,7 +21,11 @@ namespace SGUtil
 // Main string graph loading function
 // The allowContainments flag forces the string graph to retain identical vertices
 // Vertices that are substrings of other vertices (SS flag = 1) are never kept
-StringGraph* loadASQG(const std::string& filename, const unsigned int minOverlap, bool allowContainments = false, size_t maxEdges = -1);
+// The file may also be a BSQG file, which is memory mapped and loaded directly.
+// If numThreads is greater than one the records are parsed by a pool of threads.
+// The records are added to the graph in file order so the graph is the same.
+StringGraph* loadASQG(const std::string& filename, const unsigned int minOverlap, bool allowContainments = false, 
+                      size_t maxEdges = -1, int numThreads = 1);
 
 // Load a string graph from a fasta file.
 // Returns a graph where each sequence in the fasta is a vertex but there are no edges in the graph.
@@ -29,6 +29,17 @@ bool SGFastaVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
 // SGTransRedVisitor - Perform a transitive reduction about this vertex
 // This uses Myers' algorithm (2005, The fragment assembly string graph)
 // Precondition: the edge list is sorted by length (ascending)
+//
+
+// The states of the vertices in Myers' algorithm
+enum TRMark
+{
+    TR_VACANT = 0,
+    TR_INPLAY,
+    TR_ELIMINATED
+};
+
+//
 void SGTransitiveReductionVisitor::previsit(StringGraph* pGraph)
 {
     // The graph must not have containments
@@ -38,6 +49,11 @@ void SGTransitiveReductionVisitor::previsit(StringGraph* pGraph)
     pGraph->setColors(GC_WHITE);
     pGraph->sortVertexAdjListsByLen();
 
+    // The edges of each vertex are in the compact view in length order
+    m_pAdjacency = &pGraph->freeze();
+    m_marks.assign(pGraph->getVertexIndexLimit(), TR_VACANT);
+    m_log.clear();
+
     marked_verts = 0;
     marked_edges = 0;
 }
@@ -48,39 +64,48 @@ bool SGTransitiveReductionVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVerte
     size_t trans_count = 0;
     static const size_t FUZZ = 10; // see myers
 
+    VertexIndex v = pVertex->getIndex();
     for(size_t idx = 0; idx < ED_COUNT; idx++)
     {
         EdgeDir dir = EDGE_DIRECTIONS[idx];
-        EdgePtrVec edges = pVertex->getEdges(dir); // These edges are already sorted
-        if(edges.size() == 0)
+
+        // These edges are already sorted
+        m_dirEdges.clear();
+        for(CompactAdjacency::const_iterator iter = m_pAdjacency->begin(v); iter != m_pAdjacency->end(v); ++iter)
+        {
+            if(iter->getDir() == dir)
+                m_dirEdges.push_back(iter);
+        }
+
+        if(m_dirEdges.size() == 0)
             continue;
 
-        for(size_t i = 0; i < edges.size(); ++i)
-            (edges[i])->getEnd()->setColor(GC_GRAY);
+        for(size_t i = 0; i < m_dirEdges.size(); ++i)
+            m_marks[m_dirEdges[i]->end] = TR_INPLAY;
 
-        Edge* pLongestEdge = edges.back();
-        size_t longestLen = pLongestEdge->getSeqLen() + FUZZ;
+        size_t longestLen = m_dirEdges.back()->labelLength + FUZZ;
         
         // Stage 1
-        for(size_t i = 0; i < edges.size(); ++i)
+        for(size_t i = 0; i < m_dirEdges.size(); ++i)
         {
-            Edge* pVWEdge = edges[i];
-            Vertex* pWVert = pVWEdge->getEnd();
+            const CompactEdge* pVWEdge = m_dirEdges[i];
+            VertexIndex w = pVWEdge->end;
 
             EdgeDir transDir = !pVWEdge->getTwinDir();
-            if(pWVert->getColor() == GC_GRAY)
+            if(m_marks[w] == TR_INPLAY)
             {
-                EdgePtrVec w_edges = pWVert->getEdges(transDir);
-                for(size_t j = 0; j < w_edges.size(); ++j)
+                for(CompactAdjacency::const_iterator pWXEdge = m_pAdjacency->begin(w); pWXEdge != m_pAdjacency->end(w); ++pWXEdge)
                 {
-                    Edge* pWXEdge = w_edges[j];
-                    size_t trans_len = pVWEdge->getSeqLen() + pWXEdge->getSeqLen();
+                    if(pWXEdge->getDir() != transDir)
+                        continue;
+
+                    size_t trans_len = pVWEdge->labelLength + pWXEdge->labelLength;
                     if(trans_len <= longestLen)
                     {
-                        if(pWXEdge->getEnd()->getColor() == GC_GRAY)
+                        if(m_marks[pWXEdge->end] == TR_INPLAY)
                         {
                             // X is the endpoint of an edge of V, therefore it is transitive
-                            pWXEdge->getEnd()->setColor(GC_BLACK);
+                            m_marks[pWXEdge->end] = TR_ELIMINATED;
                         }
                     }
                     else
@@ -90,47 +115,45 @@ bool SGTransitiveReductionVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVerte
         }
         
         // Stage 2
-        for(size_t i = 0; i < edges.size(); ++i)
+        for(size_t i = 0; i < m_dirEdges.size(); ++i)
         {
-            Edge* pVWEdge = edges[i];
-            Vertex* pWVert = pVWEdge->getEnd();
+            const CompactEdge* pVWEdge = m_dirEdges[i];
+            VertexIndex w = pVWEdge->end;
 
             EdgeDir transDir = !pVWEdge->getTwinDir();
-            EdgePtrVec w_edges = pWVert->getEdges(transDir);
-            for(size_t j = 0; j < w_edges.size(); ++j)
+            size_t j = 0;
+            for(CompactAdjacency::const_iterator pWXEdge = m_pAdjacency->begin(w); pWXEdge != m_pAdjacency->end(w); ++pWXEdge)
             {
-                Edge* pWXEdge = w_edges[j];
-                size_t len = pWXEdge->getSeqLen();
+                if(pWXEdge->getDir() != transDir)
+                    continue;
 
-                if(len < FUZZ || j == 0)
+                if(pWXEdge->labelLength < FUZZ || j == 0)
                 {
-                    if(pWXEdge->getEnd()->getColor() == GC_GRAY)
+                    if(m_marks[pWXEdge->end] == TR_INPLAY)
                     {
                         // X is the endpoint of an edge of V, therefore it is transitive
-                        pWXEdge->getEnd()->setColor(GC_BLACK);
+                        m_marks[pWXEdge->end] = TR_ELIMINATED;
                     }
                 }
                 else
                 {
                     break;
                 }
+
+                // j is the position of the edge among the transDir edges of w
+                ++j;
             }
         }
 
-        for(size_t i = 0; i < edges.size(); ++i)
+        for(size_t i = 0; i < m_dirEdges.size(); ++i)
         {
-            if(edges[i]->getEnd()->getColor() == GC_BLACK)
+            if(m_marks[m_dirEdges[i]->end] == TR_ELIMINATED)
             {
                 // Mark the edge and its twin for removal
-                if(edges[i]->getColor() != GC_BLACK || edges[i]->getTwin()->getColor() != GC_BLACK)
-                {
-                    edges[i]->setColor(GC_BLACK);
-                    edges[i]->getTwin()->setColor(GC_BLACK);
-                    marked_edges += 2;
-                    trans_count++;
-                }
+                m_log.setEdgeColor(m_dirEdges[i]->pEdge, GC_BLACK);
+                trans_count++;
             }
-            edges[i]->getEnd()->setColor(GC_WHITE);
+            m_marks[m_dirEdges[i]->end] = TR_VACANT;
         }
     }
 
@@ -140,11 +163,19 @@ bool SGTransitiveReductionVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVerte
     return false;
 }
 
+//
+void SGTransitiveReductionVisitor::merge(SGTransitiveReductionVisitor& other)
+{
+    marked_verts += other.marked_verts;
+    other.m_log.apply();
+}
+
 // Remove all the marked edges
 void SGTransitiveReductionVisitor::postvisit(StringGraph* pGraph)
 {
+    m_log.apply();
+    marked_edges = pGraph->sweepEdges(GC_BLACK);
     //printf("TR marked %d verts and %d edges\n", marked_verts, marked_edges);
-    pGraph->sweepEdges(GC_BLACK);
     pGraph->setTransitiveFlag(false);
     assert(pGraph->checkColors(GC_WHITE));
 }
@@ -209,6 +240,16 @@ void SGContainRemoveVisitor::previsit(StringGraph* pGraph)
     // during this algorithm the flag will be reset and another
     // round must be re-run
     pGraph->setContainmentFlag(false);    
+    m_log.clear();
+}
+
+// The neighbors of a removed vertex only need to be remodelled 
+// when the graph is not exact and has been transitively reduced. 
+// Otherwise the vertices are just marked and the sweep removes
+// them along with their edges.
+bool SGContainRemoveVisitor::isParallelSafe(const StringGraph* pGraph) const
+{
+    return pGraph->hasTransitive() || pGraph->isExactMode();
 }
 
 //
@@ -216,28 +257,31 @@ bool SGContainRemoveVisitor::visit(StringGraph* pGraph, Vertex* pVertex)
 {
     if(!pVertex->isContained())
         return false;
+
+    if(isParallelSafe(pGraph))
+    {
+        m_log.setVertexColor(pVertex, GC_BLACK);
+        return false;
+    }
+
     // Add any new irreducible edges that exist when pToRemove is deleted
     // from the graph
     EdgePtrVec neighborEdges = pVertex->getEdges();
     
-    // If the graph has been transitively reduced, we have to check all
-    // the neighbors to see if any new edges need to be added. If the graph is a
-    // complete overlap graph we can just remove the edges to the deletion vertex
-    if(!pGraph->hasTransitive() && !pGraph->isExactMode())
-    {
-        // This must be done in order of edge length or some transitive edges
-        // may be created
-        EdgeLenComp comp;
-        std::sort(neighborEdges.begin(), neighborEdges.end(), comp);
+    // The graph has been transitively reduced so we have to check all
+    // the neighbors to see if any new edges need to be added. 
+    // This must be done in order of edge length or some transitive edges
+    // may be created
+    EdgeLenComp comp;
+    std::sort(neighborEdges.begin(), neighborEdges.end(), comp);
 
-        for(size_t j = 0; j < neighborEdges.size(); ++j)
-        {
-            Vertex* pRemodelVert = neighborEdges[j]->getEnd();
-            Edge* pRemodelEdge = neighborEdges[j]->getTwin();
-            SGAlgorithms::remodelVertexForExcision(pGraph, 
-                                                   pRemodelVert, 
-                                                   pRemodelEdge);
-        }
+    for(size_t j = 0; j < neighborEdges.size(); ++j)
+    {
+        Vertex* pRemodelVert = neighborEdges[j]->getEnd();
+        Edge* pRemodelEdge = neighborEdges[j]->getTwin();
+        SGAlgorithms::remodelVertexForExcision(pGraph, 
+                                               pRemodelVert, 
+                                               pRemodelEdge);
     }
             
     // Delete the edges from the graph
@@ -245,8 +289,8 @@ bool SGContainRemoveVisitor::visit(StringGraph* pGraph, Vertex* pVertex)
     {
         Vertex* pRemodelVert = neighborEdges[j]->getEnd();
         Edge* pRemodelEdge = neighborEdges[j]->getTwin();
-        pRemodelVert->deleteEdge(pRemodelEdge);
-        pVertex->deleteEdge(neighborEdges[j]);
+        pGraph->deleteEdge(pRemodelVert, pRemodelEdge);
+        pGraph->deleteEdge(pVertex, neighborEdges[j]);
     }
     pVertex->setColor(GC_BLACK);
     return false;
@@ -254,6 +298,7 @@ bool SGContainRemoveVisitor::visit(StringGraph* pGraph, Vertex* pVertex)
 
 void SGContainRemoveVisitor::postvisit(StringGraph* pGraph)
 {
+    m_log.apply();
     pGraph->sweepVertices(GC_BLACK);
 }
 
@@ -299,6 +344,7 @@ void SGTrimVisitor::previsit(StringGraph* pGraph)
     num_island = 0;
     num_terminal = 0;
     pGraph->setColors(GC_WHITE);
+    m_log.clear();
 }
 
 // Mark any nodes that either dont have edges or edges in only one direction for removal
@@ -309,7 +355,7 @@ bool SGTrimVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
         // Is an island, remove if the sequence length is less than the threshold
         if(pVertex->getSeqLen() < m_minLength)
         {
-            pVertex->setColor(GC_BLACK);
+            m_log.setVertexColor(pVertex, GC_BLACK);
             ++num_island;
         }
     }
@@ -321,7 +367,7 @@ bool SGTrimVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
             EdgeDir dir = EDGE_DIRECTIONS[idx];
             if(pVertex->countEdges(dir) == 0 && pVertex->getSeqLen() < m_minLength)
             {
-                pVertex->setColor(GC_BLACK);
+                m_log.setVertexColor(pVertex, GC_BLACK);
                 ++num_terminal;
             }
         }
@@ -330,9 +376,18 @@ bool SGTrimVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
     return false;
 }
 
+//
+void SGTrimVisitor::merge(SGTrimVisitor& other)
+{
+    num_island += other.num_island;
+    num_terminal += other.num_terminal;
+    other.m_log.apply();
+}
+
 // Remove all the marked edges
 void SGTrimVisitor::postvisit(StringGraph* pGraph)
 {
+    m_log.apply();
     pGraph->sweepVertices(GC_BLACK);
     printf("StringGraphTrim: Removed %d island and %d dead-end short vertices\n", num_island, num_terminal);
 }
@@ -345,17 +400,29 @@ void SGDuplicateVisitor::previsit(StringGraph* pGraph)
     assert(pGraph->checkColors(GC_WHITE));
     (void)pGraph;
     m_hasDuplicate = false;
+    m_log.clear();
 }
 
 bool SGDuplicateVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
 {
-    m_hasDuplicate = pVertex->markDuplicateEdges(GC_RED) || m_hasDuplicate;
+    EdgePtrVec duplicates;
+    pVertex->findDuplicateEdges(duplicates);
+    for(size_t i = 0; i < duplicates.size(); ++i)
+        m_log.setEdgeColor(duplicates[i], GC_RED);
+    m_hasDuplicate = !duplicates.empty() || m_hasDuplicate;
     return false;
 }
 
+//
+void SGDuplicateVisitor::merge(SGDuplicateVisitor& other)
+{
+    m_hasDuplicate = other.m_hasDuplicate || m_hasDuplicate;
+    other.m_log.apply();
+}
 
 void SGDuplicateVisitor::postvisit(StringGraph* pGraph)
 {
+    m_log.apply();
     assert(pGraph->checkColors(GC_WHITE));
     if(m_hasDuplicate)
     {
@@ -375,7 +442,7 @@ void SGSmallRepeatResolveVisitor::previsit(StringGraph*)
 }
 
 //
-bool SGSmallRepeatResolveVisitor::visit(StringGraph* /*pGraph*/, Vertex* pX)
+bool SGSmallRepeatResolveVisitor::visit(StringGraph* pGraph, Vertex* pX)
 {
     bool changed = false;
 
@@ -431,8 +498,8 @@ bool SGSmallRepeatResolveVisitor::visit(StringGraph* /*pGraph*/, Vertex* pX)
 
             if(x_diff > m_minDiff && y_diff > m_minDiff)
             {
-                pX->deleteEdge(pXY);
-                pY->deleteEdge(pYX);
+                pGraph->deleteEdge(pX, pXY);
+                pGraph->deleteEdge(pY, pYX);
                 changed = true;
             }
         }
@@ -453,7 +520,7 @@ void SGSmallRepeatResolveVisitor::postvisit(StringGraph* pGraph)
 // 
 void SGOverlapRatioVisitor::previsit(StringGraph*)
 {
-
+    m_log.clear();
 }
 
 //
@@ -476,8 +543,7 @@ bool SGOverlapRatioVisitor::visit(StringGraph* /*pGraph*/, Vertex* pX)
             double ratio = (double)curr_len / x_longest_len;
             if(ratio < m_minRatio)
             {
-                x_edges[i]->setColor(GC_RED);
-                x_edges[i]->getTwin()->setColor(GC_RED);
+                m_log.setEdgeColor(x_edges[i], GC_RED);
                 changed = true;
             }
         }
@@ -489,6 +555,7 @@ bool SGOverlapRatioVisitor::visit(StringGraph* /*pGraph*/, Vertex* pX)
 //
 void SGOverlapRatioVisitor::postvisit(StringGraph* pGraph)
 {
+    m_log.apply();
     pGraph->sweepEdges(GC_RED);
 }
 
@@ -503,11 +570,11 @@ void SGSuperRepeatVisitor::previsit(StringGraph*)
 }
 
 //
-bool SGSuperRepeatVisitor::visit(StringGraph*, Vertex* pVertex)
+bool SGSuperRepeatVisitor::visit(StringGraph* pGraph, Vertex* pVertex)
 {
     if(pVertex->isSuperRepeat())
     {
-        pVertex->deleteEdges();
+        pGraph->deleteEdges(pVertex);
         m_num_superrepeats += 1;
         return true;
     }
@@ -784,59 +851,3 @@ void SGSmoothingVisitor::postvisit(StringGraph* pGraph)
 
     printf("VariationSmoother: Removed %d simple and %d complex bubbles\n", m_simpleBubblesRemoved, m_complexBubblesRemoved);
 }
-
-//
-// SGGraphStatsVisitor - Collect summary stasitics
-// about the graph
-//
-void SGGraphStatsVisitor::previsit(StringGraph* /*pGraph*/)
-{
-    num_terminal = 0;
-    num_island = 0;
-    num_monobranch = 0;
-    num_dibranch = 0;
-    num_simple = 0;
-    num_edges = 0;
-    num_vertex = 0;
-    sum_edgeLen = 0;
-}
-
-// Find bubbles (nodes where there is a split and then immediate rejoin) and mark them for removal
-bool SGGraphStatsVisitor::visit(StringGraph* /*pGraph*/, Vertex* pVertex)
-{
-    int s_count = pVertex->countEdges(ED_SENSE);
-    int as_count = pVertex->countEdges(ED_ANTISENSE);
-    if(s_count == 0 && as_count == 0)
-    {
-        ++num_island;
-    }
-    else if(s_count == 0 || as_count == 0)
-    {
-        ++num_terminal;
-    }
-
-    if(s_count > 1 && as_count > 1)
-        ++num_dibranch;
-    else if(s_count > 1 || as_count > 1)
-        ++num_monobranch;
-
-    if(s_count == 1 || as_count == 1)
-        ++num_simple;
-
-    num_edges += (s_count + as_count);
-    ++num_vertex;
-
-    EdgePtrVec edges = pVertex->getEdges();
-    for(size_t i = 0; i < edges.size(); ++i)
-        sum_edgeLen += edges[i]->getSeqLen();
-
-    return false;
-}
-
-//
-void SGGraphStatsVisitor::postvisit(StringGraph* /*pGraph*/)
-{
-    printf("Vertices: %d Edges: %d Islands: %d Tips: %d Monobranch: %d Dibranch: %d Simple: %d\n", num_vertex, num_edges, 
-                                                                                                   num_island, num_terminal,
-                                                                                                   num_monobranch, num_dibranch, num_simple);
-}
@@ -10,10 +10,15 @@
 //
 #include "SGAlgorithms.h"
 #include "SGUtil.h"
+#include "MutationLog.h"
 
 #ifndef SGVISITORS_H
 #define SGVISITORS_H
 
+// The visitors below that define isParallelSafe() and merge() can be
+// run by StringGraph::visitParallel. Their visit functions do not change
+// the graph, the changes are recorded in m_log and applied in postvisit.
+
 // Visit each node, writing it to a file as a fasta record
 struct SGFastaVisitor
 {
@@ -31,15 +36,26 @@ struct SGFastaVisitor
 };
 
 // Run the Myers transitive reduction algorithm on each node
+// The edges are read from the compact view of the graph and the
+// neighbors are marked in an array owned by the visitor rather than
+// with the vertex colors, so each thread can use its own copy.
 struct SGTransitiveReductionVisitor
 {
-    SGTransitiveReductionVisitor() {}
+    SGTransitiveReductionVisitor() : m_pAdjacency(NULL) {}
     void previsit(StringGraph* pGraph);
     bool visit(StringGraph* pGraph, Vertex* pVertex);
     void postvisit(StringGraph*);
 
+    bool isParallelSafe(const StringGraph*) const { return true; }
+    void merge(SGTransitiveReductionVisitor& other);
+
     int marked_verts;
     int marked_edges;
+
+    const CompactAdjacency* m_pAdjacency;
+    std::vector<uint8_t> m_marks;
+    std::vector<const CompactEdge*> m_dirEdges;
+    MutationLog m_log;
 };
 
 // Remove identical vertices from the graph
@@ -53,12 +69,19 @@ struct SGIdenticalRemoveVisitor
 };
 
 // Remove contained vertices from the graph
+// This can only be run in parallel when the neighbors of the
+// removed vertices do not need to be remodelled.
 struct SGContainRemoveVisitor
 {
     SGContainRemoveVisitor() {}
     void previsit(StringGraph* pGraph);
     bool visit(StringGraph* pGraph, Vertex* pVertex);
     void postvisit(StringGraph* pGraph);
+
+    bool isParallelSafe(const StringGraph* pGraph) const;
+    void merge(SGContainRemoveVisitor& other) { other.m_log.apply(); }
+
+    MutationLog m_log;
 };
 
 // Validate that the graph does not contain
@@ -91,7 +114,11 @@ struct SGOverlapRatioVisitor
     bool visit(StringGraph* pGraph, Vertex* pVertex);
     void postvisit(StringGraph*);
 
+    bool isParallelSafe(const StringGraph*) const { return true; }
+    void merge(SGOverlapRatioVisitor& other) { other.m_log.apply(); }
+
     double m_minRatio;
+    MutationLog m_log;
 };
 
 // Detects and removes small "tip" vertices from the graph
@@ -103,9 +130,13 @@ struct SGTrimVisitor
     bool visit(StringGraph* pGraph, Vertex* pVertex);
     void postvisit(StringGraph*);
 
+    bool isParallelSafe(const StringGraph*) const { return true; }
+    void merge(SGTrimVisitor& other);
+
     size_t m_minLength;
     int num_island;
     int num_terminal;
+    MutationLog m_log;
 };
 
 // Detect and remove duplicate edges
@@ -116,8 +147,12 @@ struct SGDuplicateVisitor
     bool visit(StringGraph* pGraph, Vertex* pVertex);
     void postvisit(StringGraph*);
 
+    bool isParallelSafe(const StringGraph*) const { return true; }
+    void merge(SGDuplicateVisitor& other);
+
     bool m_hasDuplicate;
     bool m_bSilent;
+    MutationLog m_log;
 };
 
 // Remove the edges of super-repetitive vertices in the graph
@@ -157,22 +192,4 @@ struct SGSmoothingVisitor
     std::ofstream m_outFile;
 };
 
-// Compile summary statistics for the graph
-struct SGGraphStatsVisitor
-{
-    SGGraphStatsVisitor() {}
-    void previsit(StringGraph* pGraph);
-    bool visit(StringGraph* pGraph, Vertex* pVertex);
-    void postvisit(StringGraph*);
-
-    int num_terminal;
-    int num_island;
-    int num_monobranch;
-    int num_dibranch;
-    int num_simple;
-    int num_edges;
-    int num_vertex;
-    size_t sum_edgeLen;
-};
-
 #endif
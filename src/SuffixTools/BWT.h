@@ -10,14 +10,23 @@
 // (SBWT) or the run-length encoded version (RLBWT). This could 
 // be done using inheritence but the BWT is so used so much that 
 // overhead of calling virtual functions is unwanted
-//          
+//
+// The cache-line blocked version (BlockBWT) uses more memory
+// than the RLBWT but answers each occurrence query with a single
+// memory access. It is selected by configuring with --enable-block-bwt.
 //
 #ifndef BWT_H
 #define BWT_H
 
+#include "config.h"
 #include "RLBWT.h"
 #include "SBWT.h"
+#include "BlockBWT.h"
 
+#if USE_BLOCK_BWT
+typedef BlockBWT BWT;
+#else
 typedef RLBWT BWT;
+#endif
 
 #endif
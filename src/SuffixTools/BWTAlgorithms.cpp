@@ -92,6 +92,23 @@ BWTIntervalPair BWTAlgorithms::findIntervalPair(const BWT* pBWT, const BWT* pRev
     return intervals;
 }
 
+// Find the interval pair corresponding to w in an index of both strands
+BWTIntervalPair BWTAlgorithms::findIntervalPairBothStrands(const BWT* pBWT, const std::string& w)
+{
+    BWTIntervalPair intervals;
+    int j = w.size() - 1;
+    initIntervalPairBothStrands(intervals, w[j], pBWT);
+    --j;
+
+    for(;j >= 0; --j)
+    {
+        updateBothLBothStrands(intervals, w[j], pBWT);
+        if(!intervals.isValid())
+            return intervals;
+    }
+    return intervals;
+}
+
 // Find the interval pair corresponding to w using a cached intervals for short substrings
 BWTIntervalPair BWTAlgorithms::findIntervalPairWithCache(const BWT* pBWT, 
                                                          const BWT* pRevBWT, 
@@ -125,6 +142,37 @@ BWTIntervalPair BWTAlgorithms::findIntervalPairWithCache(const BWT* pBWT,
     return ip;
 }
 
+// Find the interval pair corresponding to w using a cache with intervals for both indices
+BWTIntervalPair BWTAlgorithms::findIntervalPairWithCache(const BWT* pBWT, 
+                                                         const BWT* pRevBWT, 
+                                                         const BWTIntervalCache* pCache,
+                                                         const std::string& w)
+{
+    assert(pCache->hasReverse());
+    size_t cacheLen = pCache->getCachedLength();
+    if(w.size() < cacheLen)
+        return findIntervalPair(pBWT, pRevBWT, w);
+    
+    int len = w.size();
+    int j = len - cacheLen;
+
+    // Strings containing a '$' are not cached
+    if(index(w.c_str() + j, '$') != NULL)
+        return findIntervalPair(pBWT, pRevBWT, w);
+
+    BWTIntervalPair ip = pCache->lookupPair(w.c_str() + j);
+    
+    // Extend the interval to the full length of w as normal
+    j -= 1;
+    for(;j >= 0; --j)
+    {
+        updateBothL(ip, w[j], pBWT);
+        if(!ip.isValid())
+            return ip;
+    }
+    return ip;
+}
+
 // Count the number of occurrences of string w, including the reverse complement
 size_t BWTAlgorithms::countSequenceOccurrences(const std::string& w, const BWT* pBWT)
 {
@@ -172,6 +220,231 @@ size_t BWTAlgorithms::countSequenceOccurrencesSingleStrand(const std::string& w,
     return interval.isValid() ? interval.size() : 0;
 }
 
+//
+void BWTAlgorithms::updateIntervalBatch(BWTInterval* intervals, const char* symbols, size_t n, const BWT* pBWT)
+{
+    for(size_t i = 0; i < n; ++i)
+        if(intervals[i].isValid())
+            prefetchIntervalMarkers(intervals[i], pBWT);
+
+    for(size_t i = 0; i < n; ++i)
+        if(intervals[i].isValid())
+            prefetchIntervalSymbols(intervals[i], pBWT);
+
+    for(size_t i = 0; i < n; ++i)
+        if(intervals[i].isValid())
+            updateInterval(intervals[i], symbols[i], pBWT);
+}
+
+//
+void BWTAlgorithms::updateBothLBatch(BWTIntervalPair* pairs, const char* symbols, size_t n, const BWT* pBWT)
+{
+    for(size_t i = 0; i < n; ++i)
+        if(pairs[i].interval[0].isValid())
+            prefetchIntervalMarkers(pairs[i].interval[0], pBWT);
+
+    for(size_t i = 0; i < n; ++i)
+        if(pairs[i].interval[0].isValid())
+            prefetchIntervalSymbols(pairs[i].interval[0], pBWT);
+
+    for(size_t i = 0; i < n; ++i)
+        if(pairs[i].interval[0].isValid())
+            updateBothL(pairs[i], symbols[i], pBWT);
+}
+
+//
+void BWTAlgorithms::updateBothRBatch(BWTIntervalPair* pairs, const char* symbols, size_t n, const BWT* pRevBWT)
+{
+    for(size_t i = 0; i < n; ++i)
+        if(pairs[i].interval[1].isValid())
+            prefetchIntervalMarkers(pairs[i].interval[1], pRevBWT);
+
+    for(size_t i = 0; i < n; ++i)
+        if(pairs[i].interval[1].isValid())
+            prefetchIntervalSymbols(pairs[i].interval[1], pRevBWT);
+
+    for(size_t i = 0; i < n; ++i)
+        if(pairs[i].interval[1].isValid())
+            updateBothR(pairs[i], symbols[i], pRevBWT);
+}
+
+// The state of one backward search in countSequenceOccurrencesBatch
+struct BatchedSearch
+{
+    const char* str;
+    int next; // the index of the next symbol to prepend, -1 when the search is finished
+    BWTInterval interval;
+};
+
+// The number of searches that are kept in flight at once. Each search
+// issues two rank queries per step.
+#define BWT_SEARCH_BATCH_SIZE 32
+
+//
+void BWTAlgorithms::countSequenceOccurrencesBatch(const std::vector<std::string>& w, const BWTIndexSet& indices, std::vector<size_t>& counts)
+{
+    assert(indices.pBWT != NULL);
+    const BWT* pBWT = indices.pBWT;
+    size_t cacheLen = indices.pCache != NULL ? indices.pCache->getCachedLength() : 0;
+
+    counts.assign(w.size(), 0);
+
+    // Each input string is searched for on both strands
+    std::vector<std::string> rc_w(w.size());
+    for(size_t i = 0; i < w.size(); ++i)
+        rc_w[i] = reverseComplement(w[i]);
+
+    size_t num_searches = 2 * w.size();
+    BatchedSearch batch[BWT_SEARCH_BATCH_SIZE];
+    for(size_t batch_start = 0; batch_start < num_searches; batch_start += BWT_SEARCH_BATCH_SIZE)
+    {
+        size_t batch_size = std::min((size_t)BWT_SEARCH_BATCH_SIZE, num_searches - batch_start);
+
+        // Start each search from the cache, if possible, or the last symbol of the string
+        for(size_t i = 0; i < batch_size; ++i)
+        {
+            size_t search_idx = batch_start + i;
+            const std::string& s = (search_idx & 1) ? rc_w[search_idx >> 1] : w[search_idx >> 1];
+            BatchedSearch& search = batch[i];
+            search.str = s.c_str();
+
+            int len = s.size();
+            if(cacheLen > 0 && s.size() >= cacheLen && index(search.str + len - cacheLen, '$') == NULL)
+            {
+                search.interval = indices.pCache->lookup(search.str + len - cacheLen);
+                search.next = len - cacheLen - 1;
+            }
+            else
+            {
+                initInterval(search.interval, search.str[len - 1], pBWT);
+                search.next = len - 2;
+            }
+        }
+
+        // Advance all the unfinished searches by one symbol at a time
+        bool active = true;
+        while(active)
+        {
+            for(size_t i = 0; i < batch_size; ++i)
+                if(batch[i].next >= 0 && batch[i].interval.isValid())
+                    prefetchIntervalMarkers(batch[i].interval, pBWT);
+
+            for(size_t i = 0; i < batch_size; ++i)
+                if(batch[i].next >= 0 && batch[i].interval.isValid())
+                    prefetchIntervalSymbols(batch[i].interval, pBWT);
+
+            active = false;
+            for(size_t i = 0; i < batch_size; ++i)
+            {
+                BatchedSearch& search = batch[i];
+                if(search.next >= 0 && search.interval.isValid())
+                {
+                    updateInterval(search.interval, search.str[search.next], pBWT);
+                    search.next -= 1;
+                    active = active || (search.next >= 0 && search.interval.isValid());
+                }
+            }
+        }
+
+        for(size_t i = 0; i < batch_size; ++i)
+            if(batch[i].interval.isValid())
+                counts[(batch_start + i) >> 1] += batch[i].interval.size();
+    }
+}
+
+// Count the k-mers of s starting at positions [a, b), with b - a <= k.
+// All of these k-mers contain the core s[b - 1, a + k), whose intervals
+// are given by pair. pBWT is used to extend the core to the left and
+// pRevBWT to extend it to the right.
+static void countKmerBlock(const char* s, int k, int a, int b, const BWTIntervalPair& pair,
+                           const BWT* pBWT, const BWT* pRevBWT, size_t* counts)
+{
+    if(!pair.isValid())
+        return;
+
+    if(b - a == 1)
+    {
+        counts[a] += pair.interval[0].size();
+        return;
+    }
+
+    int h = (a + b) / 2;
+
+    // The core of the k-mers [a, h) is s[h - 1, a + k)
+    BWTIntervalPair left = pair;
+    for(int j = b - 2; j >= h - 1 && left.isValid(); --j)
+        BWTAlgorithms::updateBothL(left, s[j], pBWT);
+    countKmerBlock(s, k, a, h, left, pBWT, pRevBWT, counts);
+
+    // The core of the k-mers [h, b) is s[b - 1, h + k)
+    BWTIntervalPair right = pair;
+    for(int j = a + k; j < h + k && right.isValid(); ++j)
+        BWTAlgorithms::updateBothR(right, s[j], pRevBWT);
+    countKmerBlock(s, k, h, b, right, pBWT, pRevBWT, counts);
+}
+
+// Count the k-mers of the n symbols of s on one strand, adding the
+// counts to the output array
+static void countKmerStrand(const char* s, int n, int k, const BWT* pBWT, const BWT* pRevBWT, size_t* counts)
+{
+    int nk = n - k + 1;
+    for(int a = 0; a < nk; a += k)
+    {
+        int b = std::min(a + k, nk);
+
+        // Search for the core of the block, s[b - 1, a + k)
+        BWTIntervalPair pair;
+        BWTAlgorithms::initIntervalPair(pair, s[a + k - 1], pBWT, pRevBWT);
+        for(int j = a + k - 2; j >= b - 1 && pair.isValid(); --j)
+            BWTAlgorithms::updateBothL(pair, s[j], pBWT);
+        countKmerBlock(s, k, a, b, pair, pBWT, pRevBWT, counts);
+    }
+}
+
+//
+void BWTAlgorithms::countKmerOccurrences(const std::string& w, int k, const BWTIndexSet& indices, std::vector<size_t>& counts)
+{
+    assert(indices.pBWT != NULL);
+    assert(k > 0);
+
+    int n = w.size();
+    counts.assign(std::max(n - k + 1, 0), 0);
+    if(n < k)
+        return;
+
+    if(indices.pRBWT == NULL)
+    {
+        std::vector<std::string> kmers(counts.size());
+        for(size_t i = 0; i < kmers.size(); ++i)
+            kmers[i] = w.substr(i, k);
+        countSequenceOccurrencesBatch(kmers, indices, counts);
+        for(size_t i = 0; i < kmers.size(); ++i)
+            if(kmers[i].find_first_not_of("ACGT") != std::string::npos)
+                counts[i] = 0;
+        return;
+    }
+
+    // Count the k-mers of each run of unambiguous bases. The reverse complement
+    // of a k-mer x is counted as the complement of x in the reverse index, so the
+    // second strand is searched with the roles of the indices swapped.
+    int start = 0;
+    while(start < n)
+    {
+        int end = start;
+        while(end < n && IUPAC::isUnambiguous(w[end]))
+            ++end;
+
+        if(end - start >= k)
+        {
+            std::string run = w.substr(start, end - start);
+            std::string comp = complement(run);
+            countKmerStrand(run.c_str(), run.size(), k, indices.pBWT, indices.pRBWT, &counts[start]);
+            countKmerStrand(comp.c_str(), comp.size(), k, indices.pRBWT, indices.pBWT, &counts[start]);
+        }
+        start = end + 1;
+    }
+}
+
 
 // Return the count of all the possible one base extensions of the string w.
 // This returns the number of times the suffix w[i, l]A, w[i, l]C, etc 
@@ -375,6 +648,35 @@ AlphaCount64 BWTAlgorithms::calculateDeBruijnExtensionsSingleIndex(const std::st
     return extensions;
 }
 
+//
+AlphaCount64 BWTAlgorithms::calculateDeBruijnExtensionsBothStrands(const std::string str,
+                                                                   const BWT* pBWT,
+                                                                   EdgeDir direction)
+{
+    size_t p = str.size() - 1;
+    std::string pmer = (direction == ED_SENSE) ? str.substr(1, p) : str.substr(0, p);
+
+    // The index contains both strands so the counts do not need to be
+    // combined with the counts for the reverse complement
+    AlphaCount64 extensions;
+    BWTIntervalPair pair = findIntervalPairBothStrands(pBWT, pmer);
+    if(!pair.isValid())
+        return extensions;
+
+    if(direction == ED_SENSE)
+    {
+        // The bases following pmer are the complements of
+        // the bases preceding its reverse complement
+        extensions = BWTAlgorithms::getExtCount(pair.interval[1], pBWT);
+        extensions.complement();
+    }
+    else
+    {
+        extensions = BWTAlgorithms::getExtCount(pair.interval[0], pBWT);
+    }
+    return extensions;
+}
+
 // Return a random string from the BWT
 std::string BWTAlgorithms::sampleRandomString(const BWT* pBWT)
 {
@@ -47,6 +47,12 @@ BWTIntervalPair findIntervalPairWithCache(const BWT* pBWT,
                                           const BWTIntervalCache* pRevCache,
                                           const std::string& w);
 
+// As above, using a cache holding the intervals in both pBWT and pRevBWT
+BWTIntervalPair findIntervalPairWithCache(const BWT* pBWT, 
+                                          const BWT* pRevBWT, 
+                                          const BWTIntervalCache* pCache,
+                                          const std::string& w);
+
 // Count the number of times the sequence w appears in the collection, including
 // its reverse complement
 size_t countSequenceOccurrences(const std::string& w, const BWT* pBWT);
@@ -122,6 +128,56 @@ inline void updateBothL(BWTIntervalPair& pair, char b, const BWT* pBWT)
     updateBothL(pair, b, pBWT, l, u);
 }
 
+//
+// Batched updates
+//
+// Each step of a backward search depends on the result of the previous
+// step so a single search stalls on a cache miss at every symbol. When many
+// independent searches are available, the memory for all of their rank queries
+// can be requested up-front with software prefetches. This is done in two
+// stages: first the sampled markers are requested, then the markers are read
+// and the symbol data they point to is requested. Only then are the intervals
+// updated, by which time most of the data is in cache.
+//
+
+// Request the markers needed to update interval
+inline void prefetchIntervalMarkers(const BWTInterval& interval, const BWT* pBWT)
+{
+    pBWT->prefetchMarker(interval.lower - 1);
+    pBWT->prefetchMarker(interval.upper);
+}
+
+// Request the symbols needed to update interval
+inline void prefetchIntervalSymbols(const BWTInterval& interval, const BWT* pBWT)
+{
+    pBWT->prefetchSymbols(interval.lower - 1);
+    pBWT->prefetchSymbols(interval.upper);
+}
+
+// Update each of the n intervals with the corresponding symbol in symbols.
+// Invalid intervals are skipped.
+void updateIntervalBatch(BWTInterval* intervals, const char* symbols, size_t n, const BWT* pBWT);
+
+// Batched versions of updateBothL/updateBothR. Pairs whose interval in the
+// queried index is invalid are skipped.
+void updateBothLBatch(BWTIntervalPair* pairs, const char* symbols, size_t n, const BWT* pBWT);
+void updateBothRBatch(BWTIntervalPair* pairs, const char* symbols, size_t n, const BWT* pRevBWT);
+
+// Count the number of times each sequence in w appears in the collection, including
+// its reverse complement. The searches are performed in batches using the functions above.
+void countSequenceOccurrencesBatch(const std::vector<std::string>& w, const BWTIndexSet& indices, std::vector<size_t>& counts);
+
+// Count the occurrences of every k-mer of w, including its reverse complement.
+// On return counts[i] is the count of w.substr(i, k). K-mers that contain a
+// symbol other than A,C,G,T have a count of zero.
+// If the reverse index is available the windows are counted with a bidirectional
+// search that shares the work between overlapping k-mers. Adjacent windows are
+// grouped into blocks of k, which all contain a common core. The core is searched
+// once and then extended left and right to split the block in half, recursively,
+// so each k-mer takes about log2(k) steps instead of k. Without the reverse
+// index the k-mers are counted independently with countSequenceOccurrencesBatch.
+void countKmerOccurrences(const std::string& w, int k, const BWTIndexSet& indices, std::vector<size_t>& counts);
+
 
 // Initialize the interval of index idx to be the range containining all the b suffixes
 inline void initInterval(BWTInterval& interval, char b, const BWT* pB)
@@ -143,6 +199,71 @@ inline AlphaCount64 getExtCount(const BWTInterval& interval, const BWT* pBWT)
     return pBWT->getOccDiff(interval.lower - 1, interval.upper);
 }
 
+//
+// Bidirectional search in a single index
+//
+// When the index is built from the reads and their reverse complements
+// (sga index --both-strands) a single BWT can be used for bidirectional
+// search. The interval pair has the same semantics as above except
+// interval[1] is the interval of the reverse complement of the string
+// in the same index, rather than the interval of the reversed string in
+// the reverse index. Extending a string to the right is the same as
+// extending its reverse complement to the left so both extensions are
+// answered by one structure.
+//
+
+// Complement b, leaving the sentinel unchanged
+inline char complementBothStrands(char b)
+{
+    return b == '$' ? '$' : complement(b);
+}
+
+// Initialize the pair to the intervals of the string b
+inline void initIntervalPairBothStrands(BWTIntervalPair& pair, char b, const BWT* pBWT)
+{
+    initInterval(pair.interval[0], b, pBWT);
+    initInterval(pair.interval[1], complementBothStrands(b), pBWT);
+}
+
+// Update the interval pair for the left extension to symbol b.
+// In this version the AlphaCounts for the upper and lower intervals
+// have been calculated.
+inline void updateBothLBothStrands(BWTIntervalPair& pair, char b, const BWT* pBWT,
+                                   AlphaCount64& l, AlphaCount64& u)
+{
+    // The reverse complement of bS is rc(S)c(b). The occurrences of rc(S)c(b)
+    // are ordered within the interval for rc(S) by the complement of the
+    // symbol that precedes S.
+    AlphaCount64 diff = u - l;
+    pair.interval[1].lower = pair.interval[1].lower + diff.getComplementLessThan(b);
+    pair.interval[1].upper = pair.interval[1].lower + diff.get(b) - 1;
+
+    size_t pb = pBWT->getPC(b);
+    pair.interval[0].lower = pb + l.get(b);
+    pair.interval[0].upper = pb + u.get(b) - 1;
+}
+
+//
+inline void updateBothLBothStrands(BWTIntervalPair& pair, char b, const BWT* pBWT)
+{
+    AlphaCount64 l = pBWT->getFullOcc(pair.interval[0].lower - 1);
+    AlphaCount64 u = pBWT->getFullOcc(pair.interval[0].upper);
+    updateBothLBothStrands(pair, b, pBWT, l, u);
+}
+
+// Update the interval pair for the right extension to symbol b.
+// This is a left extension of the reverse complement so the roles
+// of the two intervals are swapped.
+inline void updateBothRBothStrands(BWTIntervalPair& pair, char b, const BWT* pBWT)
+{
+    std::swap(pair.interval[0], pair.interval[1]);
+    updateBothLBothStrands(pair, complementBothStrands(b), pBWT);
+    std::swap(pair.interval[0], pair.interval[1]);
+}
+
+// Find the interval pair for w using only left extensions
+BWTIntervalPair findIntervalPairBothStrands(const BWT* pBWT, const std::string& w);
+
 // Return the count of all the possible one base extensions of the string w.
 // This returns the number of times the suffix w[i, l]A, w[i, l]C, etc 
 // appears in the FM-index for all i s.t. length(w[i, l]) >= minOverlap.
@@ -168,6 +289,13 @@ AlphaCount64 calculateDeBruijnExtensionsSingleIndex(const std::string str,
                                                     EdgeDir direction,
                                                     const BWTIntervalCache* pFwdCache = NULL);
 
+// Calculate de Bruijn graph extensions of the given sequence using a single
+// index of both strands of the reads. Only one search is performed
+// as the interval pair gives the extensions in both directions.
+AlphaCount64 calculateDeBruijnExtensionsBothStrands(const std::string str,
+                                                    const BWT* pBWT,
+                                                    EdgeDir direction);
+
 // Extract the complete string starting at idx in the BWT
 std::string extractString(const BWT* pBWT, size_t idx);
 
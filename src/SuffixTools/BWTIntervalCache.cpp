@@ -9,44 +9,219 @@
 //
 #include "BWTIntervalCache.h"
 #include "BWTAlgorithms.h"
+#include <fstream>
 
-BWTIntervalCache::BWTIntervalCache(size_t k, const BWT* pBWT) : m_kmer(k)
+BWTIntervalCache::BWTIntervalCache(size_t k, const BWT* pBWT, int numThreads) : m_kmer(k),
+                                                                                m_numSymbols(pBWT->getBWLen()),
+                                                                                m_numStrings(pBWT->getNumStrings()),
+                                                                                m_pFwdTable(NULL),
+                                                                                m_pRevTable(NULL),
+                                                                                m_pMappedFile(NULL)
 {
-    build(pBWT);
+    build(pBWT, m_fwdTable, numThreads);
+    m_pFwdTable = &m_fwdTable[0];
+}
+
+//
+BWTIntervalCache::BWTIntervalCache(size_t k, const BWT* pBWT, const BWT* pRevBWT, int numThreads) : m_kmer(k),
+                                                                                                    m_numSymbols(pBWT->getBWLen()),
+                                                                                                    m_numStrings(pBWT->getNumStrings()),
+                                                                                                    m_pFwdTable(NULL),
+                                                                                                    m_pRevTable(NULL),
+                                                                                                    m_pMappedFile(NULL)
+{
+    build(pBWT, m_fwdTable, numThreads);
+    build(pRevBWT, m_revTable, numThreads);
+    m_pFwdTable = &m_fwdTable[0];
+    m_pRevTable = &m_revTable[0];
+}
+
+// Map the tables from a file written by write()
+BWTIntervalCache::BWTIntervalCache(const std::string& filename, const BWT* pBWT, const BWT* pRevBWT) : m_kmer(0),
+                                                                                                        m_numSymbols(0),
+                                                                                                        m_numStrings(0),
+                                                                                                        m_pFwdTable(NULL),
+                                                                                                        m_pRevTable(NULL),
+                                                                                                        m_pMappedFile(NULL)
+{
+    m_pMappedFile = new MappedFile(filename);
+
+    const BWTIntervalCacheHeader* pHeader = (const BWTIntervalCacheHeader*)m_pMappedFile->getData();
+    if(m_pMappedFile->getSize() < sizeof(BWTIntervalCacheHeader) ||
+       pHeader->magic != INTERVAL_CACHE_FILE_MAGIC ||
+       pHeader->kmer == 0 || pHeader->kmer > MAX_INTERVAL_CACHE_LENGTH)
+    {
+        std::cerr << "Interval cache file " << filename << " is not properly formatted, aborting\n";
+        exit(EXIT_FAILURE);
+    }
+
+    m_kmer = pHeader->kmer;
+    m_numSymbols = pHeader->numSymbols;
+    m_numStrings = pHeader->numStrings;
+
+    size_t num_entries = 1ull << 2*m_kmer;
+    size_t num_tables = pHeader->hasReverse ? 2 : 1;
+    if(m_pMappedFile->getSize() != sizeof(BWTIntervalCacheHeader) + num_tables * num_entries * sizeof(BWTInterval))
+    {
+        std::cerr << "Interval cache file " << filename << " is truncated, aborting\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // The size of the index is checked first as it is cheap. The intervals
+    // of a sample of the strings are then checked against each index.
+    const BWTInterval* pFwdTable = (const BWTInterval*)m_pMappedFile->getData(sizeof(BWTIntervalCacheHeader));
+    const BWTInterval* pRevTable = pHeader->hasReverse ? pFwdTable + num_entries : NULL;
+    bool valid = m_numSymbols == pBWT->getBWLen() && m_numStrings == pBWT->getNumStrings() && sampleCheck(pBWT, pFwdTable);
+    if(valid && pRevTable != NULL && pRevBWT != NULL)
+    {
+        valid = m_numSymbols == pRevBWT->getBWLen() && m_numStrings == pRevBWT->getNumStrings() && 
+                sampleCheck(pRevBWT, pRevTable);
+    }
+
+    if(!valid)
+    {
+        std::cerr << "Interval cache file " << filename << " was not built for this FM-index. ";
+        std::cerr << "Please rebuild it with sga index, aborting\n";
+        exit(EXIT_FAILURE);
+    }
+
+    m_pFwdTable = pFwdTable;
+    if(pRevBWT != NULL)
+        m_pRevTable = pRevTable;
+}
+
+//
+BWTIntervalCache::~BWTIntervalCache()
+{
+    delete m_pMappedFile;
+}
+
+//
+BWTIntervalCache* BWTIntervalCache::load(const std::string& filename, size_t k, const BWT* pBWT,
+                                         const BWT* pRevBWT, int numThreads)
+{
+    std::ifstream probe(filename.c_str());
+    if(probe.is_open())
+        return new BWTIntervalCache(filename, pBWT, pRevBWT);
+    else if(k > 0)
+        return new BWTIntervalCache(k, pBWT, numThreads);
+    else
+        return NULL;
+}
+
+//
+BWTIntervalCache* BWTIntervalCache::loadExact(const std::string& filename, size_t k, const BWT* pBWT, int numThreads)
+{
+    assert(k > 0);
+    std::ifstream probe(filename.c_str());
+    if(probe.is_open())
+    {
+        BWTIntervalCache* pCache = new BWTIntervalCache(filename, pBWT);
+        if(pCache->getCachedLength() == k)
+            return pCache;
+
+        std::cerr << "The interval cache in " << filename << " holds strings of length " << pCache->getCachedLength()
+                  << ", building a cache of length " << k << "\n";
+        delete pCache;
+    }
+    return new BWTIntervalCache(k, pBWT, numThreads);
+}
+
+//
+void BWTIntervalCache::write(const std::string& filename) const
+{
+    std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+    assertFileOpen(out, filename);
+
+    BWTIntervalCacheHeader header;
+    header.magic = INTERVAL_CACHE_FILE_MAGIC;
+    header.kmer = m_kmer;
+    header.numSymbols = m_numSymbols;
+    header.numStrings = m_numStrings;
+    header.hasReverse = hasReverse() ? 1 : 0;
+    out.write((const char*)&header, sizeof(header));
+
+    size_t num_entries = 1ull << 2*m_kmer;
+    out.write((const char*)m_pFwdTable, num_entries * sizeof(BWTInterval));
+    if(hasReverse())
+        out.write((const char*)m_pRevTable, num_entries * sizeof(BWTInterval));
 }
 
 // Build the table for the given bwt
-void BWTIntervalCache::build(const BWT* pBWT)
+void BWTIntervalCache::build(const BWT* pBWT, std::vector<BWTInterval>& table, int numThreads)
 {
     // Restrict the kmer parameter to something reasonable
     // so we don't try to allocate an absurdly large array
-    assert(m_kmer <= 12);
+    assert(m_kmer > 0 && m_kmer <= MAX_INTERVAL_CACHE_LENGTH);
 
-    size_t num_entries = 1 << 2*m_kmer;
-    m_table.resize(num_entries);
+    size_t num_entries = 1ull << 2*m_kmer;
+    table.resize(num_entries);
 
-    // Construct the table
-    for(size_t i = 0; i < num_entries; ++i)
+    // The table is filled in by extending each suffix of the cached strings
+    // by one symbol at a time. The short suffixes are searched for directly
+    // then the subtrees below them are constructed in parallel.
+    size_t suffix_length = std::min(m_kmer, (size_t)3);
+    int num_suffixes = 1 << 2*suffix_length;
+
+#pragma omp parallel for schedule(dynamic) num_threads(numThreads)
+    for(int i = 0; i < num_suffixes; ++i)
     {
-        std::string w = int2string(i);
-        //printf("i: %zu w: %s o: %zu\n", i, w.c_str(), string2int(w));
-        BWTInterval interval = BWTAlgorithms::findInterval(pBWT, w);
-        m_table[i] = interval;
+        std::string suffix(suffix_length, 'A');
+        for(size_t k = 0; k < suffix_length; ++k)
+            suffix[k] = DNA_ALPHABET::getBase((i >> 2*(suffix_length - k - 1)) & 3);
+
+        BWTInterval interval = BWTAlgorithms::findInterval(pBWT, suffix);
+        buildRecursive(pBWT, interval, i, suffix_length, table);
     }
 }
 
-// Construct the corresponding string for integer i
-std::string BWTIntervalCache::int2string(size_t i) const
+//
+void BWTIntervalCache::buildRecursive(const BWT* pBWT, BWTInterval interval, size_t code, size_t depth, std::vector<BWTInterval>& table)
 {
-    std::string out(m_kmer, 'A');
-    for(size_t k = 0; k < m_kmer; ++k)
+    if(depth == m_kmer)
+    {
+        table[code] = interval;
+        return;
+    }
+
+    if(!interval.isValid())
     {
-        // Get the character as position k (0 = left-most position)
-        size_t code = (i >> 2*(m_kmer - k - 1)) & 3;
-        char b = DNA_ALPHABET::getBase(code);
-        out[k] = b;
+        // None of the strings with this suffix are in the bwt
+        size_t num_prefixes = 1ull << 2*(m_kmer - depth);
+        for(size_t p = 0; p < num_prefixes; ++p)
+            table[(p << 2*depth) | code] = interval;
+        return;
+    }
+
+    for(size_t r = 0; r < DNA_ALPHABET::size; ++r)
+    {
+        BWTInterval extended = interval;
+        BWTAlgorithms::updateInterval(extended, DNA_ALPHABET::getBase(r), pBWT);
+        buildRecursive(pBWT, extended, code | (r << 2*depth), depth + 1, table);
+    }
+}
+
+//
+bool BWTIntervalCache::sampleCheck(const BWT* pBWT, const BWTInterval* table) const
+{
+    static const size_t NUM_SAMPLES = 256;
+    size_t num_entries = 1ull << 2*m_kmer;
+    std::string w(m_kmer, 'A');
+    for(size_t i = 0; i < NUM_SAMPLES; ++i)
+    {
+        // Spread the sampled entries over the table
+        size_t code = (i * 2654435761u) & (num_entries - 1);
+        for(size_t k = 0; k < m_kmer; ++k)
+            w[k] = DNA_ALPHABET::getBase((code >> 2*(m_kmer - k - 1)) & 3);
+
+        BWTInterval interval = BWTAlgorithms::findInterval(pBWT, w);
+        const BWTInterval& stored = table[code];
+        if(interval.isValid() != stored.isValid())
+            return false;
+        if(interval.isValid() && (interval.lower != stored.lower || interval.upper != stored.upper))
+            return false;
     }
-    return out;
+    return true;
 }
 
 // Return the length of the cached strings
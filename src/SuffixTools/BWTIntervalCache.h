@@ -12,30 +12,99 @@
 
 #include "BWT.h"
 #include "BWTInterval.h"
+#include "MappedFile.h"
+
+// The largest length of the strings that can be cached.
+// The tables take 16 * 4^k bytes each.
+#define MAX_INTERVAL_CACHE_LENGTH 14
+
+#define INTERVAL_CACHE_FILE_MAGIC 0x1C1C
+
+// The header of a cache file written by sga index. The table of
+// intervals in the bwt follows the header. If hasReverse is set,
+// the table of intervals in the reverse bwt follows it.
+struct BWTIntervalCacheHeader
+{
+    uint64_t magic;
+    uint64_t kmer;
+    uint64_t numSymbols;
+    uint64_t numStrings;
+    uint64_t hasReverse;
+};
 
 class BWTIntervalCache
 {
     public:
 
-        //
-        BWTIntervalCache(size_t k, const BWT* pBWT);
-        
+        // Build the table using numThreads threads
+        BWTIntervalCache(size_t k, const BWT* pBWT, int numThreads = 1);
+
+        // Build the tables for both the bwt and the reverse bwt
+        // so that lookupPair can be used
+        BWTIntervalCache(size_t k, const BWT* pBWT, const BWT* pRevBWT, int numThreads = 1);
+
+        // Map a cache file from disk. The file must have been
+        // constructed for pBWT. If the file holds the table of the
+        // reverse bwt it must have been constructed for pRevBWT too.
+        // The reverse table is not used if pRevBWT is NULL.
+        BWTIntervalCache(const std::string& filename, const BWT* pBWT, const BWT* pRevBWT = NULL);
+
+        ~BWTIntervalCache();
+
+        // Return the cache stored in filename if the file exists, otherwise
+        // build a cache of length k for pBWT. If k is zero and the file
+        // does not exist, NULL is returned.
+        static BWTIntervalCache* load(const std::string& filename, size_t k, const BWT* pBWT,
+                                      const BWT* pRevBWT = NULL, int numThreads = 1);
+
+        // Return the cache stored in filename if the file exists and holds
+        // strings of length k, otherwise build a cache of length k for pBWT
+        static BWTIntervalCache* loadExact(const std::string& filename, size_t k, const BWT* pBWT, int numThreads = 1);
+
+        // Write the cache to disk
+        void write(const std::string& filename) const;
+
         // Look up the bwt interval for the given string
         inline BWTInterval lookup(const char* w) const
         {
             // Convert the string to an integer index in the lookup table
             size_t idx = str2int(w);
-            return m_table[idx];
+            return m_pFwdTable[idx];
         }
 
-        // 
+        // Look up the intervals of the given string in the bwt and
+        // of its reverse in the reverse bwt
+        // Precondition: hasReverse() is true
+        inline BWTIntervalPair lookupPair(const char* w) const
+        {
+            assert(m_pRevTable != NULL);
+            BWTIntervalPair pair;
+            pair.interval[0] = m_pFwdTable[str2int(w)];
+            pair.interval[1] = m_pRevTable[rev_str2int(w)];
+            return pair;
+        }
+
+        //
         size_t getCachedLength() const;
+        bool hasReverse() const { return m_pRevTable != NULL; }
 
     private:
 
+        // Caches cannot be copied
+        BWTIntervalCache(const BWTIntervalCache&);
+        BWTIntervalCache& operator=(const BWTIntervalCache&);
+
         // Build the array for the given BWt
-        void build(const BWT* pBWT);
-        
+        void build(const BWT* pBWT, std::vector<BWTInterval>& table, int numThreads);
+
+        // Return true if a sample of the entries of table match
+        // the intervals found by searching pBWT
+        bool sampleCheck(const BWT* pBWT, const BWTInterval* table) const;
+
+        // Fill in the table entries for all the strings ending
+        // with the suffix encoded by code, which is depth symbols long
+        void buildRecursive(const BWT* pBWT, BWTInterval interval, size_t code, size_t depth, std::vector<BWTInterval>& table);
+
         // Map a string to an integer
         // Precondition: w must be at least m_kmer symbols long
         inline size_t str2int(const char* w) const
@@ -48,11 +117,27 @@ class BWTIntervalCache
             return out;
         }
 
-        // Map an integer to a string
-        std::string int2string(size_t i) const;
+        // Map the reverse of a string to an integer
+        inline size_t rev_str2int(const char* w) const
+        {
+            size_t out = 0;
+            for(size_t k = 0; k < m_kmer; ++k) {
+                assert(w[k] != '$');
+                out |= DNA_ALPHABET::getBaseRank(w[k]) << 2*k;
+            }
+            return out;
+        }
 
         size_t m_kmer;
-        std::vector<BWTInterval> m_table;
+        size_t m_numSymbols;
+        size_t m_numStrings;
+
+        // The tables are either stored in the vectors or mapped from disk
+        std::vector<BWTInterval> m_fwdTable;
+        std::vector<BWTInterval> m_revTable;
+        const BWTInterval* m_pFwdTable;
+        const BWTInterval* m_pRevTable;
+        MappedFile* m_pMappedFile;
 };
 
 #endif
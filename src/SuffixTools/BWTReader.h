@@ -32,6 +32,44 @@ enum BWFlag
 
 const uint16_t RLBWT_FILE_MAGIC = 0xCACA;
 const uint16_t BWT_FILE_MAGIC = 0xEFEF;
+const uint16_t BLOCKBWT_FILE_MAGIC = 0xCBCB;
+
+// Files flagged with BWF_HASFMI store the FM-index marker arrays
+// after the runs of the bw string, starting at the next 8-byte
+// boundary. The section begins with this header, followed by the
+// C(a) array, the large markers and the small markers. The layout
+// matches the in-memory structures so the file can be mapped directly.
+struct FMIndexSectionHeader
+{
+    uint64_t largeSampleRate;
+    uint64_t smallSampleRate;
+    uint64_t numLargeMarkers;
+    uint64_t numSmallMarkers;
+};
+
+// Return the size of the header of a binary BWT file, which
+// is also the offset of the first run
+inline size_t getBWTHeaderSize()
+{
+    return sizeof(RLBWT_FILE_MAGIC) + 3 * sizeof(size_t) + sizeof(BWFlag);
+}
+
+// Return the offset in the file of the FM-index section
+inline size_t getFMIndexSectionOffset(size_t num_runs)
+{
+    size_t offset = getBWTHeaderSize() + num_runs;
+    return (offset + 7) & ~(size_t)7;
+}
+
+// Blocked BWT files (BLOCKBWT_FILE_MAGIC) share the header of the run-length
+// encoded files, with the number of blocks in place of the number of runs. 
+// The header is followed by the C(a) array, the number of superblocks and the
+// superblock counts, then the blocks aligned to a 64-byte boundary.
+inline size_t getBlockSectionOffset(size_t num_superblocks)
+{
+    size_t offset = ((getBWTHeaderSize() + 7) & ~(size_t)7) + (num_superblocks + 1) * sizeof(AlphaCount64) + sizeof(uint64_t);
+    return (offset + 63) & ~(size_t)63;
+}
 
 class RLBWT;
 
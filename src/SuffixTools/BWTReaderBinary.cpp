@@ -9,9 +9,10 @@
 #include "BWTReaderBinary.h"
 #include "SBWT.h"
 #include "RLBWT.h"
+#include "BlockBWT.h"
 
 //
-BWTReaderBinary::BWTReaderBinary(const std::string& filename) : m_stage(IOS_NONE), m_numRunsOnDisk(0), m_numRunsRead(0)
+BWTReaderBinary::BWTReaderBinary(const std::string& filename) : m_filename(filename), m_stage(IOS_NONE), m_magic(0), m_numRunsOnDisk(0), m_numRunsRead(0)
 {
     m_pReader = createReader(filename, std::ios::binary);
     m_stage = IOS_HEADER;
@@ -29,12 +30,66 @@ void BWTReaderBinary::read(RLBWT* pRLBWT)
     readHeader(pRLBWT->m_numStrings, pRLBWT->m_numSymbols, flag);
 
     assert(m_numRunsOnDisk > 0);
+
+    // Files that carry a pre-built FM-index are mapped rather than copied into memory
+    if(flag == BWF_HASFMI && !isGzip(m_filename))
+    {
+        mapRLBWT(pRLBWT);
+        return;
+    }
+
     readRuns(pRLBWT->m_rlString, m_numRunsOnDisk);
 
     //pRLBWT->printInfo();
     //pRLBWT->print();
 }
 
+// Point the runs of the RLBWT into a read-only mapping of the file. If
+// the markers in the file were sampled at the rate requested by the RLBWT
+// they are also used in place, otherwise the caller must rebuild them.
+void BWTReaderBinary::mapRLBWT(RLBWT* pRLBWT)
+{
+    MappedFile* pMappedFile = new MappedFile(m_filename);
+    size_t section_offset = getFMIndexSectionOffset(m_numRunsOnDisk);
+    size_t data_offset = section_offset + sizeof(FMIndexSectionHeader) + sizeof(AlphaCount64);
+    if(pMappedFile->getSize() < data_offset)
+    {
+        std::cerr << "BWT file " << m_filename << " is truncated, aborting\n";
+        exit(EXIT_FAILURE);
+    }
+
+    pRLBWT->m_pMappedFile = pMappedFile;
+    pRLBWT->m_pRuns = reinterpret_cast<const RLUnit*>(pMappedFile->getData(getBWTHeaderSize()));
+    pRLBWT->m_numRuns = m_numRunsOnDisk;
+    m_numRunsRead = m_numRunsOnDisk;
+
+    const FMIndexSectionHeader* pHeader = reinterpret_cast<const FMIndexSectionHeader*>(pMappedFile->getData(section_offset));
+    if(pHeader->smallSampleRate != pRLBWT->m_smallSampleRate || pHeader->largeSampleRate != pRLBWT->m_largeSampleRate)
+    {
+        std::cerr << "Warning: the FM-index in " << m_filename << " has sample rates " << pHeader->smallSampleRate 
+                  << " (small) and " << pHeader->largeSampleRate << " (large) but " << pRLBWT->m_smallSampleRate 
+                  << " (small) and " << pRLBWT->m_largeSampleRate << " (large) were requested. The markers will be rebuilt in memory.\n";
+        return;
+    }
+
+    size_t num_large_markers = pRLBWT->getNumRequiredMarkers(pRLBWT->m_numSymbols, pRLBWT->m_largeSampleRate);
+    size_t num_small_markers = pRLBWT->getNumRequiredMarkers(pRLBWT->m_numSymbols, pRLBWT->m_smallSampleRate);
+    size_t small_offset = data_offset + num_large_markers * sizeof(LargeMarker);
+    size_t end_offset = small_offset + num_small_markers * sizeof(SmallMarker);
+    if(pHeader->numLargeMarkers != num_large_markers || pHeader->numSmallMarkers != num_small_markers || 
+       pMappedFile->getSize() < end_offset)
+    {
+        std::cerr << "The FM-index in BWT file " << m_filename << " is not properly formatted, aborting\n";
+        exit(EXIT_FAILURE);
+    }
+
+    pRLBWT->m_predCount = *reinterpret_cast<const AlphaCount64*>(pMappedFile->getData(data_offset - sizeof(AlphaCount64)));
+    pRLBWT->m_pLargeMarkers = reinterpret_cast<const LargeMarker*>(pMappedFile->getData(data_offset));
+    pRLBWT->m_pSmallMarkers = reinterpret_cast<const SmallMarker*>(pMappedFile->getData(small_offset));
+    pRLBWT->m_smallShiftValue = Occurrence::calculateShiftValue(pRLBWT->m_smallSampleRate);
+    pRLBWT->m_largeShiftValue = Occurrence::calculateShiftValue(pRLBWT->m_largeSampleRate);
+}
+
 void BWTReaderBinary::read(SBWT* pSBWT)
 {
     BWFlag flag;
@@ -51,14 +106,70 @@ void BWTReaderBinary::read(SBWT* pSBWT)
     assert(m_numRunsOnDisk > 0);
 }
 
-//
+// Read a BlockBWT. Blocked files are mapped, run-length encoded 
+// files are decoded into the blocks of the BlockBWT.
+void BWTReaderBinary::read(BlockBWT* pBlockBWT)
+{
+    BWFlag flag;
+    readAnyHeader(pBlockBWT->m_numStrings, pBlockBWT->m_numSymbols, flag);
+    if(m_magic == RLBWT_FILE_MAGIC)
+    {
+        pBlockBWT->allocate(pBlockBWT->m_numSymbols);
+        for(size_t i = 0; i < pBlockBWT->m_numSymbols; ++i)
+            pBlockBWT->setChar(i, readBWChar());
+        return;
+    }
+
+    if(isGzip(m_filename))
+    {
+        std::cerr << "Error: blocked BWT file " << m_filename << " must not be compressed\n";
+        exit(EXIT_FAILURE);
+    }
+
+    MappedFile* pMappedFile = new MappedFile(m_filename);
+    size_t offset = (getBWTHeaderSize() + 7) & ~(size_t)7;
+    if(pMappedFile->getSize() < offset + sizeof(AlphaCount64) + sizeof(uint64_t))
+    {
+        std::cerr << "BWT file " << m_filename << " is truncated, aborting\n";
+        exit(EXIT_FAILURE);
+    }
+
+    pBlockBWT->m_predCount = *reinterpret_cast<const AlphaCount64*>(pMappedFile->getData(offset));
+    offset += sizeof(AlphaCount64);
+    uint64_t num_superblocks = *reinterpret_cast<const uint64_t*>(pMappedFile->getData(offset));
+    offset += sizeof(uint64_t);
+
+    const AlphaCount64* pSuper = reinterpret_cast<const AlphaCount64*>(pMappedFile->getData(offset));
+    size_t block_offset = getBlockSectionOffset(num_superblocks);
+    size_t num_blocks = m_numRunsOnDisk;
+    if(num_blocks != BlockBWT::getNumRequiredBlocks(pBlockBWT->m_numSymbols) ||
+       pMappedFile->getSize() < block_offset + num_blocks * sizeof(BWTBlock))
+    {
+        std::cerr << "Blocked BWT file " << m_filename << " is not properly formatted, aborting\n";
+        exit(EXIT_FAILURE);
+    }
+
+    pBlockBWT->m_superCounts.assign(pSuper, pSuper + num_superblocks);
+    pBlockBWT->m_pBlocks = reinterpret_cast<const BWTBlock*>(pMappedFile->getData(block_offset));
+    pBlockBWT->m_numBlocks = num_blocks;
+    pBlockBWT->m_pMappedFile = pMappedFile;
+}
+
+// Read the header of a run-length encoded BWT file
 void BWTReaderBinary::readHeader(size_t& num_strings, size_t& num_symbols, BWFlag& flag)
+{
+    readAnyHeader(num_strings, num_symbols, flag);
+    assertRunLengthEncoded();
+}
+
+// Read the header of either a run-length encoded or a blocked BWT file
+void BWTReaderBinary::readAnyHeader(size_t& num_strings, size_t& num_symbols, BWFlag& flag)
 {
     assert(m_stage == IOS_HEADER);
     uint16_t magic_number;
     m_pReader->read(reinterpret_cast<char*>(&magic_number), sizeof(magic_number));
     
-    if(magic_number != RLBWT_FILE_MAGIC)
+    if(magic_number != RLBWT_FILE_MAGIC && magic_number != BLOCKBWT_FILE_MAGIC)
     {
         std::cerr << "BWT file is not properly formatted, aborting\n";
         exit(EXIT_FAILURE);
@@ -68,6 +179,7 @@ void BWTReaderBinary::readHeader(size_t& num_strings, size_t& num_symbols, BWFla
     m_pReader->read(reinterpret_cast<char*>(&num_symbols), sizeof(num_symbols));
     m_pReader->read(reinterpret_cast<char*>(&m_numRunsOnDisk), sizeof(m_numRunsOnDisk));
     m_pReader->read(reinterpret_cast<char*>(&flag), sizeof(flag));
+    m_magic = magic_number;
     
     //std::cout << "Read magic: " << magic_number << "\n";
     //std::cout << "strings:" << num_strings << "\n";
@@ -108,3 +220,14 @@ char BWTReaderBinary::readBWChar()
     m_currRun.decrementCount();
     return m_currRun.getChar();
 }
+
+//
+void BWTReaderBinary::assertRunLengthEncoded() const
+{
+    if(m_magic != RLBWT_FILE_MAGIC)
+    {
+        std::cerr << "BWT file " << m_filename << " is in the blocked format, which can only be read when sga is "
+                  << "configured with --enable-block-bwt\n";
+        exit(EXIT_FAILURE);
+    }
+}
@@ -18,6 +18,7 @@
 
 class SBWT;
 class RLBWT;
+class BlockBWT;
 
 class BWTReaderBinary : public IBWTReader
 {
@@ -28,14 +29,27 @@ class BWTReaderBinary : public IBWTReader
         //
         virtual void read(RLBWT* pRLBWT);
         virtual void read(SBWT* pSBWT);
+        virtual void read(BlockBWT* pBlockBWT);
 
         virtual void readHeader(size_t& num_strings, size_t& num_symbols, BWFlag& flag);
         virtual char readBWChar();
         virtual void readRuns(RLVector& out, size_t numRuns);
 
     private:
+
+        // Map the runs and FM-index of a file with an embedded FM-index
+        void mapRLBWT(RLBWT* pRLBWT);
+
+        // Read the header without checking that the file is run-length encoded
+        void readAnyHeader(size_t& num_strings, size_t& num_symbols, BWFlag& flag);
+
+        // Abort if the file is not run-length encoded
+        void assertRunLengthEncoded() const;
+
+        std::string m_filename;
         std::istream* m_pReader;
         BWIOStage m_stage;
+        uint16_t m_magic;
         RLUnit m_currRun;
         size_t m_numRunsOnDisk;
         size_t m_numRunsRead;
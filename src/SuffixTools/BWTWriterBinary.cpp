@@ -9,6 +9,7 @@
 #include "BWTWriterBinary.h"
 #include "SBWT.h"
 #include "RLBWT.h"
+#include "BlockBWT.h"
 
 //
 BWTWriterBinary::BWTWriterBinary(const std::string& filename) : m_numRuns(0), m_runFileOffset(0), m_stage(IOS_NONE)
@@ -39,7 +40,6 @@ void BWTWriterBinary::writeHeader(const size_t& num_strings, const size_t& num_s
     m_numRuns = 0;
     m_pWriter->write(reinterpret_cast<const char*>(&m_numRuns), sizeof(m_numRuns));
 
-    assert(flag == BWF_NOFMI);
     m_pWriter->write(reinterpret_cast<const char*>(&flag), sizeof(flag));
 
     m_stage = IOS_BWSTR;    
@@ -92,3 +92,65 @@ void BWTWriterBinary::finalize()
     m_stage = IOS_DONE;
 }
 
+
+// Write the full RLBWT with its marker arrays in the layout described in BWTReader.h
+void BWTWriterBinary::write(const RLBWT* pRLBWT)
+{
+    writeHeader(pRLBWT->m_numStrings, pRLBWT->m_numSymbols, BWF_HASFMI);
+    
+    // Write the runs in a single block
+    m_numRuns = pRLBWT->m_numRuns;
+    m_pWriter->write(reinterpret_cast<const char*>(pRLBWT->m_pRuns), m_numRuns * sizeof(RLUnit));
+
+    // Fill in the number of runs
+    m_pWriter->seekp(m_runFileOffset);
+    m_pWriter->write(reinterpret_cast<const char*>(&m_numRuns), sizeof(m_numRuns));
+    m_pWriter->seekp(0, std::ios_base::end);
+
+    // Pad the runs so the markers are aligned
+    size_t section_offset = getFMIndexSectionOffset(m_numRuns);
+    size_t padding = section_offset - getBWTHeaderSize() - m_numRuns;
+    const char zeros[8] = { 0 };
+    m_pWriter->write(zeros, padding);
+
+    FMIndexSectionHeader header;
+    header.largeSampleRate = pRLBWT->m_largeSampleRate;
+    header.smallSampleRate = pRLBWT->m_smallSampleRate;
+    header.numLargeMarkers = pRLBWT->getNumRequiredMarkers(pRLBWT->m_numSymbols, pRLBWT->m_largeSampleRate);
+    header.numSmallMarkers = pRLBWT->getNumRequiredMarkers(pRLBWT->m_numSymbols, pRLBWT->m_smallSampleRate);
+    m_pWriter->write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_pWriter->write(reinterpret_cast<const char*>(&pRLBWT->m_predCount), sizeof(pRLBWT->m_predCount));
+    m_pWriter->write(reinterpret_cast<const char*>(pRLBWT->m_pLargeMarkers), header.numLargeMarkers * sizeof(LargeMarker));
+    m_pWriter->write(reinterpret_cast<const char*>(pRLBWT->m_pSmallMarkers), header.numSmallMarkers * sizeof(SmallMarker));
+    m_stage = IOS_DONE;
+}
+
+//
+void BWTWriterBinary::write(const BlockBWT* pBlockBWT)
+{
+    assert(m_stage == IOS_HEADER);
+    BWFlag flag = BWF_HASFMI;
+    uint64_t num_blocks = pBlockBWT->m_numBlocks;
+    uint64_t num_superblocks = pBlockBWT->m_superCounts.size();
+    m_pWriter->write(reinterpret_cast<const char*>(&BLOCKBWT_FILE_MAGIC), sizeof(BLOCKBWT_FILE_MAGIC));
+    m_pWriter->write(reinterpret_cast<const char*>(&pBlockBWT->m_numStrings), sizeof(pBlockBWT->m_numStrings));
+    m_pWriter->write(reinterpret_cast<const char*>(&pBlockBWT->m_numSymbols), sizeof(pBlockBWT->m_numSymbols));
+    m_pWriter->write(reinterpret_cast<const char*>(&num_blocks), sizeof(num_blocks));
+    m_pWriter->write(reinterpret_cast<const char*>(&flag), sizeof(flag));
+
+    const char zeros[64] = { 0 };
+    size_t offset = getBWTHeaderSize();
+    size_t padding = ((offset + 7) & ~(size_t)7) - offset;
+    m_pWriter->write(zeros, padding);
+    offset += padding;
+
+    m_pWriter->write(reinterpret_cast<const char*>(&pBlockBWT->m_predCount), sizeof(pBlockBWT->m_predCount));
+    m_pWriter->write(reinterpret_cast<const char*>(&num_superblocks), sizeof(num_superblocks));
+    m_pWriter->write(reinterpret_cast<const char*>(&pBlockBWT->m_superCounts[0]), num_superblocks * sizeof(AlphaCount64));
+    offset += sizeof(AlphaCount64) * (num_superblocks + 1) + sizeof(num_superblocks);
+
+    // Align the blocks to the cache line size
+    m_pWriter->write(zeros, getBlockSectionOffset(num_superblocks) - offset);
+    m_pWriter->write(reinterpret_cast<const char*>(pBlockBWT->m_pBlocks), num_blocks * sizeof(BWTBlock));
+    m_stage = IOS_DONE;
+}
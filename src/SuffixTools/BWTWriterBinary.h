@@ -19,6 +19,7 @@
 
 class SBWT;
 class RLBWT;
+class BlockBWT;
 
 class BWTWriterBinary : public IBWTWriter
 {
@@ -31,6 +32,13 @@ class BWTWriterBinary : public IBWTWriter
         virtual void writeBWChar(char b);
         virtual void finalize(); // this method must be called after writing the BW string
 
+        // Write the runs and the FM-index of an already-loaded RLBWT so that 
+        // the file can be memory-mapped when it is read back in
+        virtual void write(const RLBWT* pRLBWT);
+
+        // Write a BlockBWT in the blocked layout described in BWTReader.h
+        virtual void write(const BlockBWT* pBlockBWT);
+
     private:
 
         void writeRun(RLUnit& unit);
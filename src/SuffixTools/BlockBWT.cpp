@@ -0,0 +1,166 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// BlockBWT - Burrows-Wheeler transform stored as
+// cache-line sized blocks
+//
+#include "BlockBWT.h"
+#include "BWTReaderBinary.h"
+#include <cstdlib>
+#include <algorithm>
+
+// Each block must occupy exactly one cache line
+typedef char BWTBlockSizeCheck[sizeof(BWTBlock) == 64 ? 1 : -1];
+
+// Parse a BWT from a file. The file can either be a run-length encoded
+// BWT, which is converted into blocks as it is read, or a blocked BWT written
+// by sga convert-bwt, which is memory-mapped. The block size is fixed so the
+// sample rate is ignored.
+BlockBWT::BlockBWT(const std::string& filename, int /*sampleRate*/) : m_pBlocks(NULL),
+                                                                      m_pOwnedBlocks(NULL),
+                                                                      m_numBlocks(0),
+                                                                      m_pMappedFile(NULL),
+                                                                      m_numStrings(0),
+                                                                      m_numSymbols(0)
+{
+    BWTReaderBinary reader(filename);
+    reader.read(this);
+    if(m_pMappedFile == NULL)
+        initializeFMIndex();
+}
+
+// Construct the BWT from a suffix array
+BlockBWT::BlockBWT(const SuffixArray* pSA, const ReadTable* pRT) : m_pBlocks(NULL),
+                                                                   m_pOwnedBlocks(NULL),
+                                                                   m_numBlocks(0),
+                                                                   m_pMappedFile(NULL)
+{
+    size_t n = pSA->getSize();
+    m_numStrings = pSA->getNumStrings();
+    allocate(n);
+
+    for(size_t i = 0; i < n; ++i)
+    {
+        SAElem saElem = pSA->get(i);
+        const SeqItem& si = pRT->getRead(saElem.getID());
+
+        // Get the position of the start of the suffix
+        uint64_t f_pos = saElem.getPos();
+        uint64_t l_pos = (f_pos == 0) ? si.seq.length() : f_pos - 1;
+        char b = (l_pos == si.seq.length()) ? '$' : si.seq.get(l_pos);
+        setChar(i, b);
+    }
+
+    initializeFMIndex();
+}
+
+//
+BlockBWT::~BlockBWT()
+{
+    free(m_pOwnedBlocks);
+    delete m_pMappedFile;
+}
+
+// Allocate the blocks. They are aligned to the cache line size
+// so that each block only occupies a single line.
+void BlockBWT::allocate(size_t n)
+{
+    m_numSymbols = n;
+    m_numBlocks = getNumRequiredBlocks(n);
+
+    void* ptr = NULL;
+    if(posix_memalign(&ptr, 64, m_numBlocks * sizeof(BWTBlock)) != 0)
+    {
+        std::cerr << "Error: could not allocate memory for " << m_numBlocks << " BWT blocks\n";
+        exit(EXIT_FAILURE);
+    }
+    memset(ptr, 0, m_numBlocks * sizeof(BWTBlock));
+    m_pOwnedBlocks = static_cast<BWTBlock*>(ptr);
+    m_pBlocks = m_pOwnedBlocks;
+}
+
+//
+void BlockBWT::setChar(size_t idx, char b)
+{
+    assert(m_pOwnedBlocks != NULL && idx < m_numSymbols);
+    BWTBlock& block = m_pOwnedBlocks[idx >> BLOCK_BWT_SHIFT];
+    size_t word = (idx >> 6) & 1;
+    uint64_t bit = 1ull << (idx & 63);
+
+    if(b == '$')
+    {
+        block.dollar[word] |= bit;
+    }
+    else
+    {
+        uint8_t rank = DNA_ALPHABET::getBaseRank(b);
+        if(rank & 1)
+            block.lo[word] |= bit;
+        if(rank & 2)
+            block.hi[word] |= bit;
+    }
+}
+
+// Fill in the counts of each block and the superblocks
+void BlockBWT::initializeFMIndex()
+{
+    assert(m_pOwnedBlocks != NULL);
+    m_superCounts.clear();
+
+    AlphaCount64 running_ac;
+    for(size_t i = 0; i < m_numBlocks; ++i)
+    {
+        if((i & ((1ull << BLOCK_BWT_SUPERBLOCK_SHIFT) - 1)) == 0)
+            m_superCounts.push_back(running_ac);
+        const AlphaCount64& super = m_superCounts.back();
+
+        BWTBlock& block = m_pOwnedBlocks[i];
+        for(size_t j = 0; j < 4; ++j)
+            block.counts[j] = running_ac.getByIdx(j) - super.getByIdx(j);
+
+        // Only count the symbols that are part of the bw string
+        size_t block_start = i << BLOCK_BWT_SHIFT;
+        size_t n = 0;
+        if(block_start < m_numSymbols)
+            n = std::min((size_t)BLOCK_BWT_SYMBOLS, m_numSymbols - block_start);
+        for(size_t j = 0; j < ALPHABET_SIZE; ++j)
+            running_ac.setByIdx(j, running_ac.getByIdx(j) + countInBlock(block, j, n));
+    }
+
+    assert(running_ac.getSum() == m_numSymbols);
+
+    // Initialize C(a)
+    m_predCount.set('$', 0);
+    m_predCount.set('A', running_ac.get('$'));
+    m_predCount.set('C', m_predCount.get('A') + running_ac.get('A'));
+    m_predCount.set('G', m_predCount.get('C') + running_ac.get('C'));
+    m_predCount.set('T', m_predCount.get('G') + running_ac.get('G'));
+}
+
+// Print the BWT
+void BlockBWT::print() const
+{
+    std::string bwt;
+    for(size_t i = 0; i < m_numSymbols; ++i)
+        bwt.push_back(getChar(i));
+    std::cout << "B: " << bwt << "\n";
+}
+
+// Print information about the BWT
+void BlockBWT::printInfo() const
+{
+    size_t blocks_size = m_numBlocks * sizeof(BWTBlock);
+    size_t super_size = m_superCounts.size() * sizeof(AlphaCount64);
+    size_t other_size = sizeof(*this);
+    size_t total_size = blocks_size + super_size + other_size;
+
+    double mb = (double)(1024 * 1024);
+    printf("\nBlockBWT info:\n");
+    printf("Contains %zu symbols in %zu blocks of %d symbols%s\n", m_numSymbols, m_numBlocks, BLOCK_BWT_SYMBOLS,
+                                                                   m_pMappedFile != NULL ? " (memory-mapped)" : "");
+    printf("Total Memory -- Blocks: %zu (%.1lf MB) Superblocks: %zu Misc: %zu Total: %zu (%lf MB)\n",
+           blocks_size, blocks_size / mb, super_size, other_size, total_size, total_size / mb);
+    printf("N: %zu Bytes per symbol: %lf\n\n", m_numSymbols, (double)total_size / m_numSymbols);
+}
@@ -0,0 +1,214 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// BlockBWT - Burrows-Wheeler transform stored as
+// cache-line sized blocks. Each block holds the
+// occurrence counts up to the start of the block and
+// the packed symbols of the block itself, so a rank
+// query touches a single cache line.
+//
+#ifndef BLOCKBWT_H
+#define BLOCKBWT_H
+
+#include "STCommon.h"
+#include "SuffixArray.h"
+#include "ReadTable.h"
+#include "BWTReader.h"
+#include "MappedFile.h"
+
+// The number of symbols in a block. This must match the
+// number of bits in the symbol planes of BWTBlock
+#define BLOCK_BWT_SYMBOLS 128
+#define BLOCK_BWT_SHIFT 7
+
+// The counts in a block are relative to the superblock containing
+// it so that they fit in 32 bits. A superblock spans 2^32 symbols
+// so there are only a handful of them, which stay cached.
+#define BLOCK_BWT_SUPERBLOCK_SHIFT (32 - BLOCK_BWT_SHIFT)
+
+// A block is 64 bytes. The symbols are stored as three bit-planes:
+// the two bits of the DNA rank (A=0,C=1,G=2,T=3) and a mask of the
+// positions holding a '$'.
+struct BWTBlock
+{
+    // The number of times $,A,C,G have been seen between the start of
+    // the superblock and the start of this block. The count for T is
+    // implied by the position of the block.
+    uint32_t counts[4];
+
+    uint64_t lo[2];
+    uint64_t hi[2];
+    uint64_t dollar[2];
+};
+
+//
+// BlockBWT
+//
+class BlockBWT
+{
+    public:
+
+        // Constructors
+        BlockBWT(const std::string& filename, int sampleRate = DEFAULT_SAMPLE_RATE_SMALL);
+        BlockBWT(const SuffixArray* pSA, const ReadTable* pRT);
+        ~BlockBWT();
+
+        // Compute the block counts, superblocks and C(a) from the symbols
+        void initializeFMIndex();
+
+        inline char getChar(size_t idx) const
+        {
+            const BWTBlock& block = m_pBlocks[idx >> BLOCK_BWT_SHIFT];
+            size_t word = (idx >> 6) & 1;
+            size_t bit = idx & 63;
+            if((block.dollar[word] >> bit) & 1)
+                return '$';
+            size_t rank = (((block.hi[word] >> bit) & 1) << 1) | ((block.lo[word] >> bit) & 1);
+            return DNA_ALPHABET::getBase(rank);
+        }
+
+        inline BaseCount getPC(char b) const { return m_predCount.get(b); }
+
+        // Return the number of times char b appears in bwt[0, idx]
+        inline BaseCount getOcc(char b, size_t idx) const
+        {
+            // Count the symbols in the half-open range [0, idx + 1)
+            ++idx;
+            size_t block_idx = idx >> BLOCK_BWT_SHIFT;
+            size_t offset = idx & (BLOCK_BWT_SYMBOLS - 1);
+            const BWTBlock& block = m_pBlocks[block_idx];
+            const AlphaCount64& super = m_superCounts[block_idx >> BLOCK_BWT_SUPERBLOCK_SHIFT];
+
+            uint8_t rank = BWT_ALPHABET::getRank(b);
+            BaseCount count = super.getByIdx(rank);
+            if(rank < 4)
+            {
+                count += block.counts[rank];
+            }
+            else
+            {
+                // Infer the number of Ts before this block from its position
+                size_t relative_pos = (block_idx << BLOCK_BWT_SHIFT) & ((1ull << 32) - 1);
+                count += relative_pos - block.counts[0] - block.counts[1] - block.counts[2] - block.counts[3];
+            }
+            return count + countInBlock(block, rank, offset);
+        }
+
+        // Return the number of times each symbol in the alphabet appears in bwt[0, idx]
+        inline AlphaCount64 getFullOcc(size_t idx) const
+        {
+            ++idx;
+            size_t block_idx = idx >> BLOCK_BWT_SHIFT;
+            size_t offset = idx & (BLOCK_BWT_SYMBOLS - 1);
+            const BWTBlock& block = m_pBlocks[block_idx];
+            AlphaCount64 out = m_superCounts[block_idx >> BLOCK_BWT_SUPERBLOCK_SHIFT];
+
+            size_t relative_pos = (block_idx << BLOCK_BWT_SHIFT) & ((1ull << 32) - 1);
+            size_t relative_t = relative_pos;
+            for(size_t i = 0; i < 4; ++i)
+            {
+                relative_t -= block.counts[i];
+                out.setByIdx(i, out.getByIdx(i) + block.counts[i] + countInBlock(block, i, offset));
+            }
+            out.setByIdx(4, out.getByIdx(4) + relative_t + countInBlock(block, 4, offset));
+            return out;
+        }
+
+        // Prefetch the block that getOcc/getFullOcc will read for idx.
+        // The counts and symbols share a cache line so there is
+        // nothing left to fetch in the second stage.
+        inline void prefetchMarker(size_t idx) const
+        {
+            __builtin_prefetch(m_pBlocks + ((idx + 1) >> BLOCK_BWT_SHIFT));
+        }
+
+        inline void prefetchSymbols(size_t /*idx*/) const {}
+
+        // Return the number of times each symbol in the alphabet appears ins bwt[idx0, idx1]
+        inline AlphaCount64 getOccDiff(size_t idx0, size_t idx1) const
+        {
+            return getFullOcc(idx1) - getFullOcc(idx0);
+        }
+
+        inline size_t getNumStrings() const { return m_numStrings; }
+        inline size_t getBWLen() const { return m_numSymbols; }
+
+        // Return the first letter of the suffix starting at idx
+        inline char getF(size_t idx) const
+        {
+            size_t ci = 0;
+            while(ci < ALPHABET_SIZE && m_predCount.getByIdx(ci) <= idx)
+                ci++;
+            assert(ci != 0);
+            return RANK_ALPHABET[ci - 1];
+        }
+
+        // Print the size of the BWT
+        void printInfo() const;
+        void print() const;
+        void printRunLengths() const { std::cout << "Using BlockBWT - No run lengths\n"; }
+
+        // IO
+        friend class BWTReaderBinary;
+        friend class BWTWriterBinary;
+
+        static const int DEFAULT_SAMPLE_RATE_SMALL = BLOCK_BWT_SYMBOLS;
+
+    private:
+
+        // Default constructor and copying are not allowed
+        BlockBWT() {}
+        BlockBWT(const BlockBWT&);
+        BlockBWT& operator=(const BlockBWT&);
+
+        // Count the occurrences of the symbol with the given rank (in RANK_ALPHABET)
+        // in the first n symbols of the block
+        static inline size_t countInBlock(const BWTBlock& block, size_t rank, size_t n)
+        {
+            // Masks selecting the first n bits of each word
+            uint64_t m0 = n >= 64 ? ~0ull : (1ull << n) - 1;
+            uint64_t m1 = n <= 64 ? 0ull : (n >= 128 ? ~0ull : (1ull << (n - 64)) - 1);
+
+            if(rank == 0)
+                return __builtin_popcountll(block.dollar[0] & m0) + __builtin_popcountll(block.dollar[1] & m1);
+
+            // Select the positions whose two rank bits match the DNA rank of the symbol
+            size_t dna_rank = rank - 1;
+            uint64_t hi_x = (dna_rank & 2) ? 0ull : ~0ull;
+            uint64_t lo_x = (dna_rank & 1) ? 0ull : ~0ull;
+            uint64_t w0 = (block.hi[0] ^ hi_x) & (block.lo[0] ^ lo_x) & ~block.dollar[0];
+            uint64_t w1 = (block.hi[1] ^ hi_x) & (block.lo[1] ^ lo_x) & ~block.dollar[1];
+            return __builtin_popcountll(w0 & m0) + __builtin_popcountll(w1 & m1);
+        }
+
+        // Allocate the (zeroed) blocks for a bw string of length n
+        void allocate(size_t n);
+
+        // Set the symbol at position idx. Only valid while the blocks are being filled in.
+        void setChar(size_t idx, char b);
+
+        // The number of blocks required to answer queries for positions [0, n]
+        static size_t getNumRequiredBlocks(size_t n) { return (n >> BLOCK_BWT_SHIFT) + 1; }
+
+        // The C(a) array
+        AlphaCount64 m_predCount;
+
+        // The absolute count of each symbol at the start of each superblock
+        std::vector<AlphaCount64> m_superCounts;
+
+        // The blocks. These are either owned by this object (m_pOwnedBlocks) or mapped from disk.
+        const BWTBlock* m_pBlocks;
+        BWTBlock* m_pOwnedBlocks;
+        size_t m_numBlocks;
+        MappedFile* m_pMappedFile;
+
+        // The number of strings in the collection
+        size_t m_numStrings;
+
+        // The total length of the bw string
+        size_t m_numSymbols;
+};
+
+#endif
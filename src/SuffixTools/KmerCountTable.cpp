@@ -0,0 +1,158 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// KmerCountTable - Table of the counts of all the k-mers
+// of an FM-index, built once by sga kmer-count --table
+//
+#include "KmerCountTable.h"
+#include <fstream>
+
+const size_t KmerCountTable::MAX_COUNT;
+
+//
+KmerCountTable::KmerCountTable(int k, size_t minCount, const BWT* pBWT) : m_kmer(k),
+                                                                         m_minCount(minCount),
+                                                                         m_numKmers(0),
+                                                                         m_numBucketBits(0),
+                                                                         m_numSymbols(pBWT->getBWLen()),
+                                                                         m_numStrings(pBWT->getNumStrings()),
+                                                                         m_pOffsets(NULL),
+                                                                         m_pKeys(NULL),
+                                                                         m_pCounts(NULL),
+                                                                         m_pMappedFile(NULL)
+{
+    assert(k > 0 && k <= MAX_KMER_LENGTH);
+}
+
+// Map the table from a file written by write()
+KmerCountTable::KmerCountTable(const std::string& filename, const BWT* pBWT) : m_kmer(0),
+                                                                               m_minCount(0),
+                                                                               m_numKmers(0),
+                                                                               m_numBucketBits(0),
+                                                                               m_numSymbols(0),
+                                                                               m_numStrings(0),
+                                                                               m_pOffsets(NULL),
+                                                                               m_pKeys(NULL),
+                                                                               m_pCounts(NULL),
+                                                                               m_pMappedFile(NULL)
+{
+    m_pMappedFile = new MappedFile(filename);
+
+    const KmerCountTableHeader* pHeader = (const KmerCountTableHeader*)m_pMappedFile->getData();
+    if(m_pMappedFile->getSize() < sizeof(KmerCountTableHeader) ||
+       pHeader->magic != KMER_COUNT_TABLE_FILE_MAGIC ||
+       pHeader->kmer == 0 || pHeader->kmer > (uint64_t)MAX_KMER_LENGTH ||
+       pHeader->numBucketBits > 2 * pHeader->kmer)
+    {
+        std::cerr << "Kmer count table " << filename << " is not properly formatted, aborting\n";
+        exit(EXIT_FAILURE);
+    }
+
+    m_kmer = pHeader->kmer;
+    m_minCount = pHeader->minCount;
+    m_numKmers = pHeader->numKmers;
+    m_numBucketBits = pHeader->numBucketBits;
+    m_numSymbols = pHeader->numSymbols;
+    m_numStrings = pHeader->numStrings;
+
+    size_t num_buckets = 1ull << m_numBucketBits;
+    if(m_pMappedFile->getSize() != sizeof(KmerCountTableHeader) + (num_buckets + 1) * sizeof(uint64_t) +
+                                   m_numKmers * (sizeof(uint64_t) + sizeof(uint8_t)))
+    {
+        std::cerr << "Kmer count table " << filename << " is truncated, aborting\n";
+        exit(EXIT_FAILURE);
+    }
+
+    if(m_numSymbols != pBWT->getBWLen() || m_numStrings != pBWT->getNumStrings())
+    {
+        std::cerr << "Kmer count table " << filename << " was not built for this FM-index. ";
+        std::cerr << "Please rebuild it with sga kmer-count --table, aborting\n";
+        exit(EXIT_FAILURE);
+    }
+
+    m_pOffsets = (const uint64_t*)m_pMappedFile->getData(sizeof(KmerCountTableHeader));
+    m_pKeys = m_pOffsets + num_buckets + 1;
+    m_pCounts = (const uint8_t*)(m_pKeys + m_numKmers);
+}
+
+//
+KmerCountTable::~KmerCountTable()
+{
+    delete m_pMappedFile;
+}
+
+//
+void KmerCountTable::add(const std::string& kmer, size_t count)
+{
+    assert(kmer.size() == m_kmer);
+    uint64_t key;
+    if(packCanonicalKmer(kmer.c_str(), m_kmer, key))
+        add(key, count);
+}
+
+//
+void KmerCountTable::add(uint64_t key, size_t count)
+{
+    assert(m_pMappedFile == NULL);
+    if(count < m_minCount)
+        return;
+    m_added.push_back(std::make_pair(key, (uint8_t)std::min(count, MAX_COUNT)));
+}
+
+//
+void KmerCountTable::build()
+{
+    std::sort(m_added.begin(), m_added.end());
+
+    m_numKmers = m_added.size();
+    m_keys.resize(m_numKmers);
+    m_counts.resize(m_numKmers);
+    for(size_t i = 0; i < m_numKmers; ++i)
+    {
+        m_keys[i] = m_added[i].first;
+        m_counts[i] = m_added[i].second;
+    }
+    std::vector<std::pair<uint64_t, uint8_t> >().swap(m_added);
+
+    // Use about four keys per bucket so a lookup touches one or two lines of the key array
+    m_numBucketBits = 0;
+    while(m_numBucketBits < 2 * m_kmer && (4ull << m_numBucketBits) < m_numKmers)
+        m_numBucketBits += 1;
+
+    size_t num_buckets = 1ull << m_numBucketBits;
+    size_t shift = 2 * m_kmer - m_numBucketBits;
+    m_offsets.assign(num_buckets + 1, 0);
+    for(size_t i = 0; i < m_numKmers; ++i)
+        m_offsets[(m_keys[i] >> shift) + 1] += 1;
+    for(size_t i = 1; i <= num_buckets; ++i)
+        m_offsets[i] += m_offsets[i - 1];
+
+    m_pOffsets = &m_offsets[0];
+    m_pKeys = m_keys.empty() ? NULL : &m_keys[0];
+    m_pCounts = m_counts.empty() ? NULL : &m_counts[0];
+}
+
+//
+void KmerCountTable::write(const std::string& filename)
+{
+    assert(m_pMappedFile == NULL);
+    build();
+
+    std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+    assertFileOpen(out, filename);
+
+    KmerCountTableHeader header;
+    header.magic = KMER_COUNT_TABLE_FILE_MAGIC;
+    header.kmer = m_kmer;
+    header.minCount = m_minCount;
+    header.numKmers = m_numKmers;
+    header.numBucketBits = m_numBucketBits;
+    header.numSymbols = m_numSymbols;
+    header.numStrings = m_numStrings;
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)m_pOffsets, m_offsets.size() * sizeof(uint64_t));
+    out.write((const char*)m_pKeys, m_numKmers * sizeof(uint64_t));
+    out.write((const char*)m_pCounts, m_numKmers * sizeof(uint8_t));
+}
@@ -0,0 +1,122 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// KmerCountTable - Table of the counts of all the k-mers
+// of an FM-index, built once by sga kmer-count --table
+//
+// The canonical k-mers are packed into 2 bits per base and
+// stored in a sorted array. The counts are stored in a parallel
+// array and saturate at 255. An index of bucket offsets, one per
+// prefix of the packed k-mers, narrows a lookup down to a few
+// adjacent keys so a query costs one or two cache misses, instead
+// of a backwards search for the k-mer and its reverse complement.
+//
+#ifndef KMERCOUNTTABLE_H
+#define KMERCOUNTTABLE_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include "BWT.h"
+#include "MappedFile.h"
+#include "Util.h"
+
+#define KMER_COUNT_TABLE_FILE_MAGIC 0x4B43
+
+// The header of a table file. The bucket offsets, the
+// sorted keys and then the counts follow the header.
+struct KmerCountTableHeader
+{
+    uint64_t magic;
+    uint64_t kmer;
+    uint64_t minCount;
+    uint64_t numKmers;
+    uint64_t numBucketBits;
+    uint64_t numSymbols;
+    uint64_t numStrings;
+};
+
+class KmerCountTable
+{
+    public:
+
+        // The longest k-mer that can be stored in the table
+        static const int MAX_KMER_LENGTH = 31;
+
+        // The largest count that can be stored
+        static const size_t MAX_COUNT = 255;
+
+        // Start building an empty table of the k-mers of length k
+        // in pBWT that are seen at least minCount times
+        KmerCountTable(int k, size_t minCount, const BWT* pBWT);
+
+        // Map a table file from disk. The file must have been
+        // constructed for pBWT.
+        KmerCountTable(const std::string& filename, const BWT* pBWT);
+        ~KmerCountTable();
+
+        // Add a k-mer to the table being built. The count is the number
+        // of times the k-mer and its reverse complement were seen.
+        // K-mers seen fewer than minCount times are not added.
+        void add(const std::string& kmer, size_t count);
+
+        // Add a k-mer that has already been packed into its canonical key
+        void add(uint64_t key, size_t count);
+
+        // Sort the table and write it to disk. The table can be queried afterwards.
+        void write(const std::string& filename);
+
+        // Return the number of times the k-mer starting at w, or its reverse
+        // complement, is seen. The count saturates at MAX_COUNT. K-mers that
+        // are not in the table, including those seen fewer than minCount times,
+        // have a count of zero.
+        inline size_t count(const char* w) const
+        {
+            uint64_t key;
+            if(!packCanonicalKmer(w, m_kmer, key))
+                return 0;
+
+            uint64_t bucket = key >> (2 * m_kmer - m_numBucketBits);
+            const uint64_t* pFirst = m_pKeys + m_pOffsets[bucket];
+            const uint64_t* pLast = m_pKeys + m_pOffsets[bucket + 1];
+            const uint64_t* pKey = std::lower_bound(pFirst, pLast, key);
+            return (pKey != pLast && *pKey == key) ? m_pCounts[pKey - m_pKeys] : 0;
+        }
+
+        size_t getKmerLength() const { return m_kmer; }
+        size_t getMinCount() const { return m_minCount; }
+        size_t getNumKmers() const { return m_numKmers; }
+
+    private:
+
+        // Tables cannot be copied
+        KmerCountTable(const KmerCountTable&);
+        KmerCountTable& operator=(const KmerCountTable&);
+
+        // Sort the k-mers that have been added and build the bucket index
+        void build();
+
+        size_t m_kmer;
+        size_t m_minCount;
+        size_t m_numKmers;
+        size_t m_numBucketBits;
+        size_t m_numSymbols;
+        size_t m_numStrings;
+
+        // The k-mers added while building the table
+        std::vector<std::pair<uint64_t, uint8_t> > m_added;
+
+        // The arrays are either stored in the vectors or mapped from disk
+        std::vector<uint64_t> m_offsets;
+        std::vector<uint64_t> m_keys;
+        std::vector<uint8_t> m_counts;
+        const uint64_t* m_pOffsets;
+        const uint64_t* m_pKeys;
+        const uint8_t* m_pCounts;
+        MappedFile* m_pMappedFile;
+};
+
+#endif
@@ -23,16 +23,29 @@
 RLBWT::RLBWT(const std::string& filename, int sampleRate) : m_numStrings(0), 
                                                             m_numSymbols(0), 
                                                             m_largeSampleRate(DEFAULT_SAMPLE_RATE_LARGE),
-                                                            m_smallSampleRate(sampleRate)
+                                                            m_smallSampleRate(sampleRate),
+                                                            m_pRuns(NULL),
+                                                            m_numRuns(0),
+                                                            m_pLargeMarkers(NULL),
+                                                            m_pSmallMarkers(NULL),
+                                                            m_pMappedFile(NULL)
 {
     IBWTReader* pReader = BWTReader::createReader(filename);
     pReader->read(this);
-    initializeFMIndex();
+
+    // The reader sets the marker pointers if the file contains
+    // a pre-built FM-index with the requested sample rate
+    if(m_pLargeMarkers == NULL)
+        initializeFMIndex();
     delete pReader;
 }
 
 // Construct the BWT from a suffix array
-RLBWT::RLBWT(const SuffixArray* pSA, const ReadTable* pRT)
+RLBWT::RLBWT(const SuffixArray* pSA, const ReadTable* pRT) : m_pRuns(NULL),
+                                                             m_numRuns(0),
+                                                             m_pLargeMarkers(NULL),
+                                                             m_pSmallMarkers(NULL),
+                                                             m_pMappedFile(NULL)
 {
     // Set up BWT state
     size_t n = pSA->getSize();
@@ -82,6 +95,12 @@ RLBWT::RLBWT(const SuffixArray* pSA, const ReadTable* pRT)
     initializeFMIndex();
 }
 
+//
+RLBWT::~RLBWT()
+{
+    delete m_pMappedFile;
+}
+
 //
 void RLBWT::append(char b)
 {
@@ -111,6 +130,13 @@ void RLBWT::initializeFMIndex()
     m_smallShiftValue = Occurrence::calculateShiftValue(m_smallSampleRate);
     m_largeShiftValue = Occurrence::calculateShiftValue(m_largeSampleRate);
 
+    // Mapped runs are set up by the reader, otherwise the runs are held in m_rlString
+    if(m_pMappedFile == NULL)
+    {
+        m_pRuns = m_rlString.empty() ? NULL : &m_rlString[0];
+        m_numRuns = m_rlString.size();
+    }
+
     // initialize the marker vectors,
     // LargeMarkers are placed every 2048 bases (by default) containing the absolute count
     // of symbols seen up to that point. SmallMarkers are placed every 128 bases with the
@@ -142,10 +168,10 @@ void RLBWT::initializeFMIndex()
     size_t running_total = 0;
     AlphaCount64 running_ac;
 
-    for(size_t i = 0; i < m_rlString.size(); ++i)
+    for(size_t i = 0; i < m_numRuns; ++i)
     {
         // Update the count and advance the running total
-        RLUnit& unit = m_rlString[i];
+        const RLUnit& unit = m_pRuns[i];
 
         char symbol = unit.getChar();
         uint8_t run_len = unit.getCount();
@@ -153,7 +179,7 @@ void RLBWT::initializeFMIndex()
         running_total += run_len;
 
         size_t curr_unit_index = i + 1;
-        bool last_symbol = i == m_rlString.size() - 1;
+        bool last_symbol = i == m_numRuns - 1;
 
         // Check whether to place a new large marker
         bool place_last_large_marker = last_symbol && curr_large_marker_index < num_large_markers;
@@ -238,6 +264,8 @@ void RLBWT::initializeFMIndex()
 
     assert(curr_small_marker_index == num_small_markers);
     assert(curr_large_marker_index == num_large_markers);
+    m_pLargeMarkers = &m_largeMarkers[0];
+    m_pSmallMarkers = &m_smallMarkers[0];
 
     // Initialize C(a)
     m_predCount.set('$', 0);
@@ -263,7 +291,7 @@ void RLBWT::print() const
     std::string bwt;
     for(size_t i = 0; i < numRuns; ++i)
     {
-        const RLUnit& unit = m_rlString[i];
+        const RLUnit& unit = m_pRuns[i];
         char symbol = unit.getChar();
         size_t length = unit.getCount();
         for(size_t j = 0; j < length; ++j)
@@ -277,11 +305,13 @@ void RLBWT::print() const
 // Print information about the BWT
 void RLBWT::printInfo() const
 {
-    size_t small_m_size = m_smallMarkers.capacity() * sizeof(SmallMarker);
-    size_t large_m_size = m_largeMarkers.capacity() * sizeof(LargeMarker);
+    size_t num_small_markers = getNumRequiredMarkers(m_numSymbols, m_smallSampleRate);
+    size_t num_large_markers = getNumRequiredMarkers(m_numSymbols, m_largeSampleRate);
+    size_t small_m_size = num_small_markers * sizeof(SmallMarker);
+    size_t large_m_size = num_large_markers * sizeof(LargeMarker);
     size_t total_marker_size = small_m_size + large_m_size;
 
-    size_t bwStr_size = m_rlString.capacity() * sizeof(RLUnit);
+    size_t bwStr_size = m_numRuns * sizeof(RLUnit);
     size_t other_size = sizeof(*this);
     size_t total_size = total_marker_size + bwStr_size + other_size;
 
@@ -291,7 +321,9 @@ void RLBWT::printInfo() const
     printf("\nRLBWT info:\n");
     printf("Large Sample rate: %zu\n", m_largeSampleRate);
     printf("Small Sample rate: %zu\n", m_smallSampleRate);
-    printf("Contains %zu symbols in %zu runs (%1.4lf symbols per run)\n", m_numSymbols, m_rlString.size(), (double)m_numSymbols / m_rlString.size());
+    printf("Contains %zu symbols in %zu runs (%1.4lf symbols per run)\n", m_numSymbols, m_numRuns, (double)m_numSymbols / m_numRuns);
+    if(isMapped())
+        printf("Runs are memory-mapped from disk (%s)\n", m_smallMarkers.empty() ? "markers mapped" : "markers rebuilt in memory");
     printf("Marker Memory -- Small Markers: %zu (%.1lf MB) Large Markers: %zu (%.1lf MB)\n", small_m_size, small_m_size / mb, large_m_size, large_m_size / mb);
     printf("Total Memory -- Markers: %zu (%.1lf MB) Str: %zu (%.1lf MB) Misc: %zu Total: %zu (%lf MB)\n", total_marker_size, total_marker_size / mb, bwStr_size, bwStr_size / mb, other_size, total_size, total_mb);
     printf("N: %zu Bytes per symbol: %lf\n\n", m_numSymbols, (double)total_size / m_numSymbols);
@@ -311,7 +343,7 @@ void RLBWT::printRunLengths() const
     size_t totalRuns = 0;
     for(size_t i = 0; i < numRuns; ++i)
     {
-        const RLUnit& unit = m_rlString[i];
+        const RLUnit& unit = m_pRuns[i];
         size_t length = unit.getCount();
         if(unit.getChar() == prevSym)
         {
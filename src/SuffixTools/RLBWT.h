@@ -18,6 +18,7 @@
 #include "EncodedString.h"
 #include "FMMarkers.h"
 #include "RLUnit.h"
+#include "MappedFile.h"
 
 // Defines
 //#define RLBWT_VALIDATE 1
@@ -32,10 +33,14 @@ class RLBWT
         // Constructors
         RLBWT(const std::string& filename, int sampleRate = DEFAULT_SAMPLE_RATE_SMALL);
         RLBWT(const SuffixArray* pSA, const ReadTable* pRT);
+        ~RLBWT();
 
         //    
         void initializeFMIndex();
 
+        // Returns true if the bw string is memory-mapped from disk
+        inline bool isMapped() const { return m_pMappedFile != NULL; }
+
         // Append a symbol to the bw string
         void append(char b);
 
@@ -53,11 +58,11 @@ class RLBWT
             {
                 assert(symbol_index != 0);
                 symbol_index -= 1;
-                current_position -= m_rlString[symbol_index].getCount();
+                current_position -= m_pRuns[symbol_index].getCount();
             }
 
             // symbol_index is now the index of the run containing the idx symbol
-            const RLUnit& unit = m_rlString[symbol_index];
+            const RLUnit& unit = m_pRuns[symbol_index];
             assert(current_position <= idx && current_position + unit.getCount() >= idx);
             return unit.getChar();
         }
@@ -108,8 +113,8 @@ class RLBWT
             size_t target_position = target_small_idx << m_smallShiftValue;
             size_t curr_large_idx = target_position >> m_largeShiftValue;
 
-            LargeMarker absoluteMarker = m_largeMarkers[curr_large_idx];
-            const SmallMarker& relative = m_smallMarkers[target_small_idx];
+            LargeMarker absoluteMarker = m_pLargeMarkers[curr_large_idx];
+            const SmallMarker& relative = m_pSmallMarkers[target_small_idx];
             alphacount_add16(absoluteMarker.counts, relative.counts);
             absoluteMarker.unitIndex += relative.unitCount;
             return absoluteMarker;
@@ -160,10 +165,45 @@ class RLBWT
             return running_count;
         }
 
+        // Prefetch the markers that getOcc/getFullOcc will read for idx.
+        // This is the first stage of a batched rank query (see BWTAlgorithms)
+        inline void prefetchMarker(size_t idx) const
+        {
+            ++idx;
+            size_t small_idx = getNearestMarkerIdx(idx, m_smallSampleRate, m_smallShiftValue);
+            size_t large_idx = (small_idx << m_smallShiftValue) >> m_largeShiftValue;
+            __builtin_prefetch(m_pSmallMarkers + small_idx);
+            __builtin_prefetch(m_pLargeMarkers + large_idx);
+        }
+
+        // Prefetch the first run that getOcc/getFullOcc will scan for idx.
+        // This reads the markers so it should be called after prefetchMarker
+        inline void prefetchSymbols(size_t idx) const
+        {
+            ++idx;
+            const LargeMarker& marker = getNearestMarker(idx);
+            size_t unit_index = marker.unitIndex;
+            if(marker.getActualPosition() >= idx && unit_index > 0)
+                unit_index -= 1;
+            __builtin_prefetch(m_pRuns + unit_index);
+        }
+
         // Adds to the count of symbol b in the range [targetPosition, currentPosition)
         // Precondition: currentPosition <= targetPosition
         inline void accumulateBackwards(AlphaCount64& running_count, size_t currentUnitIndex, size_t currentPosition, const size_t targetPosition) const
         {
+            // Skip over whole blocks of runs that start after the target
+            while(currentUnitIndex >= RL_BLOCK_UNITS && currentPosition - targetPosition >= RL_BLOCK_UNITS)
+            {
+                const RLUnit* pBlock = m_pRuns + currentUnitIndex - RL_BLOCK_UNITS;
+                size_t block_length = rl_block_length(pBlock);
+                if(block_length > currentPosition - targetPosition)
+                    break;
+                rl_block_subtract(running_count, pBlock);
+                currentPosition -= block_length;
+                currentUnitIndex -= RL_BLOCK_UNITS;
+            }
+
             // Search backwards (towards 0) until idx is found
             while(currentPosition != targetPosition)
             {
@@ -173,7 +213,7 @@ class RLBWT
 #endif
                 --currentUnitIndex;
 
-                const RLUnit& curr_unit = m_rlString[currentUnitIndex];
+                const RLUnit& curr_unit = m_pRuns[currentUnitIndex];
                 currentPosition -= curr_unit.subtractAlphaCount(running_count, diff);
             }
         }
@@ -182,14 +222,26 @@ class RLBWT
         // Precondition: currentPosition <= targetPosition
         inline void accumulateForwards(AlphaCount64& running_count, size_t currentUnitIndex, size_t currentPosition, const size_t targetPosition) const
         {
+            // Skip over whole blocks of runs that end before the target
+            while(currentUnitIndex + RL_BLOCK_UNITS <= m_numRuns && targetPosition - currentPosition >= RL_BLOCK_UNITS)
+            {
+                const RLUnit* pBlock = m_pRuns + currentUnitIndex;
+                size_t block_length = rl_block_length(pBlock);
+                if(block_length > targetPosition - currentPosition)
+                    break;
+                rl_block_add(running_count, pBlock);
+                currentPosition += block_length;
+                currentUnitIndex += RL_BLOCK_UNITS;
+            }
+
             // Search backwards (towards 0) until idx is found
             while(currentPosition != targetPosition)
             {
                 size_t diff = targetPosition - currentPosition;
 #ifdef RLBWT_VALIDATE
-                assert(currentUnitIndex != m_rlString.size());
+                assert(currentUnitIndex != m_numRuns);
 #endif
-                const RLUnit& curr_unit = m_rlString[currentUnitIndex];
+                const RLUnit& curr_unit = m_pRuns[currentUnitIndex];
                 currentPosition += curr_unit.addAlphaCount(running_count, diff);
                 ++currentUnitIndex;
             }
@@ -199,6 +251,19 @@ class RLBWT
         // Precondition: currentPosition <= targetPosition
         inline void accumulateBackwards(char b, size_t& running_count, size_t currentUnitIndex, size_t currentPosition, const size_t targetPosition) const
         {
+            // Skip over whole blocks of runs that start after the target
+            uint8_t rank = BWT_ALPHABET::getRank(b);
+            while(currentUnitIndex >= RL_BLOCK_UNITS && currentPosition - targetPosition >= RL_BLOCK_UNITS)
+            {
+                const RLUnit* pBlock = m_pRuns + currentUnitIndex - RL_BLOCK_UNITS;
+                size_t block_length = rl_block_length(pBlock);
+                if(block_length > currentPosition - targetPosition)
+                    break;
+                running_count -= rl_block_count(pBlock, rank);
+                currentPosition -= block_length;
+                currentUnitIndex -= RL_BLOCK_UNITS;
+            }
+
             // Search backwards (towards 0) until idx is found
             while(currentPosition != targetPosition)
             {
@@ -207,7 +272,7 @@ class RLBWT
                 assert(currentUnitIndex != 0);
 #endif
                 --currentUnitIndex;
-                const RLUnit& curr_unit = m_rlString[currentUnitIndex];
+                const RLUnit& curr_unit = m_pRuns[currentUnitIndex];
                 currentPosition -= curr_unit.subtractCount(b, running_count, diff);
             }
         }
@@ -216,14 +281,27 @@ class RLBWT
         // Precondition: currentPosition <= targetPosition
         inline void accumulateForwards(char b, size_t& running_count, size_t currentUnitIndex, size_t currentPosition, const size_t targetPosition) const
         {
+            // Skip over whole blocks of runs that end before the target
+            uint8_t rank = BWT_ALPHABET::getRank(b);
+            while(currentUnitIndex + RL_BLOCK_UNITS <= m_numRuns && targetPosition - currentPosition >= RL_BLOCK_UNITS)
+            {
+                const RLUnit* pBlock = m_pRuns + currentUnitIndex;
+                size_t block_length = rl_block_length(pBlock);
+                if(block_length > targetPosition - currentPosition)
+                    break;
+                running_count += rl_block_count(pBlock, rank);
+                currentPosition += block_length;
+                currentUnitIndex += RL_BLOCK_UNITS;
+            }
+
             // Search backwards (towards 0) until idx is found
             while(currentPosition != targetPosition)
             {
                 size_t diff = targetPosition - currentPosition;
 #ifdef RLBWT_VALIDATE
-                assert(currentUnitIndex != m_rlString.size());
+                assert(currentUnitIndex != m_numRuns);
 #endif
-                const RLUnit& curr_unit = m_rlString[currentUnitIndex];
+                const RLUnit& curr_unit = m_pRuns[currentUnitIndex];
                 currentPosition += curr_unit.addCount(b, running_count, diff);
                 ++currentUnitIndex;
             }
@@ -237,7 +315,7 @@ class RLBWT
 
         inline size_t getNumStrings() const { return m_numStrings; } 
         inline size_t getBWLen() const { return m_numSymbols; }
-        inline size_t getNumRuns() const { return m_rlString.size(); }
+        inline size_t getNumRuns() const { return m_numRuns; }
 
         // Return the first letter of the suffix starting at idx
         inline char getF(size_t idx) const
@@ -267,8 +345,10 @@ class RLBWT
     private:
 
 
-        // Default constructor is not allowed
+        // Default constructor and copying are not allowed
         RLBWT() {}
+        RLBWT(const RLBWT&);
+        RLBWT& operator=(const RLBWT&);
         
         // Calculate the number of markers to place
         size_t getNumRequiredMarkers(size_t n, size_t d) const;
@@ -297,5 +377,14 @@ class RLBWT
         int m_smallShiftValue;
         int m_largeShiftValue;
 
+        // Pointers to the runs and markers used by the queries. These
+        // point into the vectors above or into the mapped file when the
+        // FM-index was loaded directly from disk.
+        const RLUnit* m_pRuns;
+        size_t m_numRuns;
+        const LargeMarker* m_pLargeMarkers;
+        const SmallMarker* m_pSmallMarkers;
+        MappedFile* m_pMappedFile;
+
 };
 #endif
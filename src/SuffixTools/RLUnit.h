@@ -9,6 +9,12 @@
 #ifndef RLUNIT_H
 #define RLUNIT_H
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 //
 #define RL_COUNT_MASK 0x1F  //00011111
 #define RL_SYMBOL_MASK 0xE0 //11100000
@@ -150,4 +156,107 @@ struct RLUnit
 };
 typedef std::vector<RLUnit> RLVector;
 
+//
+// Block operations on runs
+//
+// Scanning from a marker to a target position visits every run in between,
+// one byte at a time. These functions count a fixed-size block of consecutive
+// runs at once: the total number of symbols in the block and the number of
+// symbols in runs of a given symbol. The rank queries use them to skip whole
+// blocks that end before the target position and fall back to the per-run
+// functions above for the final partial block.
+//
+#if defined(__AVX2__)
+#define RL_BLOCK_UNITS 32
+#else
+#define RL_BLOCK_UNITS 16
+#endif
+
+#if defined(__AVX2__)
+
+// Sum the bytes of v
+inline size_t rl_block_sum(__m256i v)
+{
+    __m256i sad = _mm256_sad_epu8(v, _mm256_setzero_si256());
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(sad), _mm256_extracti128_si256(sad, 1));
+    return _mm_cvtsi128_si32(sum) + _mm_extract_epi16(sum, 4);
+}
+
+// Return the number of symbols in the block of runs starting at pUnits
+inline size_t rl_block_length(const RLUnit* pUnits)
+{
+    __m256i v = _mm256_loadu_si256((const __m256i*)pUnits);
+    return rl_block_sum(_mm256_and_si256(v, _mm256_set1_epi8(RL_COUNT_MASK)));
+}
+
+// Return the number of symbols in runs with the given rank in BWT_ALPHABET
+inline size_t rl_block_count(const RLUnit* pUnits, uint8_t rank)
+{
+    __m256i v = _mm256_loadu_si256((const __m256i*)pUnits);
+    __m256i symbols = _mm256_and_si256(v, _mm256_set1_epi8((char)RL_SYMBOL_MASK));
+    __m256i match = _mm256_cmpeq_epi8(symbols, _mm256_set1_epi8((char)(rank << RL_SYMBOL_SHIFT)));
+    return rl_block_sum(_mm256_and_si256(_mm256_and_si256(v, _mm256_set1_epi8(RL_COUNT_MASK)), match));
+}
+
+#elif defined(__SSE2__)
+
+// Sum the bytes of v
+inline size_t rl_block_sum(__m128i v)
+{
+    __m128i sad = _mm_sad_epu8(v, _mm_setzero_si128());
+    return _mm_cvtsi128_si32(sad) + _mm_extract_epi16(sad, 4);
+}
+
+// Return the number of symbols in the block of runs starting at pUnits
+inline size_t rl_block_length(const RLUnit* pUnits)
+{
+    __m128i v = _mm_loadu_si128((const __m128i*)pUnits);
+    return rl_block_sum(_mm_and_si128(v, _mm_set1_epi8(RL_COUNT_MASK)));
+}
+
+// Return the number of symbols in runs with the given rank in BWT_ALPHABET
+inline size_t rl_block_count(const RLUnit* pUnits, uint8_t rank)
+{
+    __m128i v = _mm_loadu_si128((const __m128i*)pUnits);
+    __m128i symbols = _mm_and_si128(v, _mm_set1_epi8((char)RL_SYMBOL_MASK));
+    __m128i match = _mm_cmpeq_epi8(symbols, _mm_set1_epi8((char)(rank << RL_SYMBOL_SHIFT)));
+    return rl_block_sum(_mm_and_si128(_mm_and_si128(v, _mm_set1_epi8(RL_COUNT_MASK)), match));
+}
+
+#else
+
+// Portable versions of the above
+inline size_t rl_block_length(const RLUnit* pUnits)
+{
+    size_t sum = 0;
+    for(size_t i = 0; i < RL_BLOCK_UNITS; ++i)
+        sum += pUnits[i].data & RL_COUNT_MASK;
+    return sum;
+}
+
+inline size_t rl_block_count(const RLUnit* pUnits, uint8_t rank)
+{
+    uint8_t code = rank << RL_SYMBOL_SHIFT;
+    size_t sum = 0;
+    for(size_t i = 0; i < RL_BLOCK_UNITS; ++i)
+        sum += (pUnits[i].data & RL_SYMBOL_MASK) == code ? pUnits[i].data & RL_COUNT_MASK : 0;
+    return sum;
+}
+
+#endif
+
+// Add the counts of every symbol in the block of runs to ac
+inline void rl_block_add(AlphaCount64& ac, const RLUnit* pUnits)
+{
+    for(size_t i = 0; i < ALPHABET_SIZE; ++i)
+        ac.setByIdx(i, ac.getByIdx(i) + rl_block_count(pUnits, i));
+}
+
+// Subtract the counts of every symbol in the block of runs from ac
+inline void rl_block_subtract(AlphaCount64& ac, const RLUnit* pUnits)
+{
+    for(size_t i = 0; i < ALPHABET_SIZE; ++i)
+        ac.setByIdx(i, ac.getByIdx(i) - rl_block_count(pUnits, i));
+}
+
 #endif
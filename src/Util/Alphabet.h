@@ -236,6 +236,20 @@ class AlphaCount
             return out;
         }
 
+        // Return the sum of the basecounts for characters whose complement
+        // is lexo. lower than the complement of b. The complemented order
+        // is $,T,G,C,A.
+        inline size_t getComplementLessThan(char b) const
+        {
+            int stop = getBaseRank(b);
+            if(stop == 0)
+                return 0;
+            size_t out = m_counts[0];
+            for(int i = 4; i > stop; --i)
+                out += m_counts[i];
+            return out;
+        }
+
         // Returns the number of non-zero counts
         uint8_t getNumNonZero() const
         {
@@ -0,0 +1,479 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// BlockSeqReader - Read fasta or fastq records using
+// a pool of threads to decompress and parse the input.
+//
+#include <string.h>
+#include "BlockSeqReader.h"
+
+// The target number of bytes read from the file for each segment
+static const size_t SEGMENT_SIZE = 1 << 20;
+
+// The number of segments and batches per thread that can be in flight
+static const size_t IN_FLIGHT_PER_THREAD = 2;
+
+// The size of the buffer used for each call to inflate
+static const size_t INFLATE_BUFFER_SIZE = 1 << 16;
+
+// The BGZF header is a gzip header with an extra field holding the block size
+static const size_t BGZF_HEADER_SIZE = 12;
+
+//
+BlockSeqReader::BlockSeqReader(const std::string& filename, uint32_t flags, int numThreads) : m_mode(BM_PLAIN),
+                                                                                              m_flags(flags),
+                                                                                              m_nextStartsAtMember(true),
+                                                                                              m_inputDone(false),
+                                                                                              m_textDone(false),
+                                                                                              m_pCarry(NULL),
+                                                                                              m_warnCount(0),
+                                                                                              m_stopRequested(false)
+{
+    assert(numThreads > 0);
+    m_maxInFlight = IN_FLIGHT_PER_THREAD * numThreads;
+
+    m_file.open(filename.c_str(), std::ios::in | std::ios::binary);
+    if(!m_file.is_open())
+    {
+        std::cerr << "Error: could not open " << filename << " for read\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // Detect the format from the first header
+    unsigned char header[BGZF_HEADER_SIZE + 6];
+    m_file.read((char*)header, sizeof(header));
+    size_t n = m_file.gcount();
+    if(n >= 2 && header[0] == 0x1f && header[1] == 0x8b)
+    {
+        m_mode = BM_GZIP;
+        if(n == sizeof(header) && (header[3] & 4) && header[12] == 'B' && header[13] == 'C')
+            m_mode = BM_BGZF;
+    }
+    m_file.clear();
+    m_file.seekg(0);
+
+    int ret = pthread_mutex_init(&m_mutex, NULL);
+    ret |= pthread_cond_init(&m_taskCond, NULL);
+    ret |= pthread_cond_init(&m_doneCond, NULL);
+    if(ret != 0)
+    {
+        std::cerr << "Mutex initialization failed with error " << ret << ", aborting" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    m_threads.resize(numThreads);
+    for(size_t i = 0; i < m_threads.size(); ++i)
+    {
+        ret = pthread_create(&m_threads[i], 0, &BlockSeqReader::startThread, this);
+        if(ret != 0)
+        {
+            std::cerr << "Thread creation failed with error " << ret << ", aborting" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+//
+BlockSeqReader::~BlockSeqReader()
+{
+    // Finish the outstanding work before stopping the threads
+    for(SegmentQueue::iterator iter = m_segments.begin(); iter != m_segments.end(); ++iter)
+    {
+        wait(*iter);
+        delete *iter;
+    }
+
+    for(ParseQueue::iterator iter = m_batches.begin(); iter != m_batches.end(); ++iter)
+    {
+        wait(*iter);
+        delete *iter;
+    }
+
+    pthread_mutex_lock(&m_mutex);
+    m_stopRequested = true;
+    pthread_cond_broadcast(&m_taskCond);
+    pthread_mutex_unlock(&m_mutex);
+
+    for(size_t i = 0; i < m_threads.size(); ++i)
+        pthread_join(m_threads[i], NULL);
+
+    destroyStream(m_pCarry);
+    pthread_mutex_destroy(&m_mutex);
+    pthread_cond_destroy(&m_taskCond);
+    pthread_cond_destroy(&m_doneCond);
+}
+
+//
+bool BlockSeqReader::getBatch(SeqRecordBatch& batch)
+{
+    // A batch can be empty if its text only contained fasta records without
+    // sequence. Those batches are skipped.
+    do
+    {
+        fillBatches();
+        if(m_batches.empty())
+            return false;
+
+        ParseTask* pTask = m_batches.front();
+        m_batches.pop_front();
+        wait(pTask);
+        batch.swap(pTask->batch);
+        delete pTask;
+
+        // The pool only records the warnings and errors of the records
+        batch.report(m_warnCount);
+    } while(batch.empty());
+    return true;
+}
+
+//
+void BlockSeqReader::fillBatches()
+{
+    // Turn decompressed segments into tasks that parse complete records
+    while(!m_textDone && m_batches.size() < m_maxInFlight)
+    {
+        fillSegments();
+        if(m_segments.empty())
+        {
+            if(m_pCarry != NULL)
+            {
+                std::cerr << "Error: unexpected end of compressed file\n";
+                exit(EXIT_FAILURE);
+            }
+
+            // The remaining text is the end of the file
+            submitParse(m_leftover, m_leftover.size());
+            m_leftover.clear();
+            m_textDone = true;
+            break;
+        }
+
+        Segment* pSegment = m_segments.front();
+        m_segments.pop_front();
+        wait(pSegment);
+
+        std::string text;
+        resolveSegment(pSegment, text);
+        delete pSegment;
+
+        m_leftover.append(text);
+        size_t len = SeqRecordBatch::scan(m_leftover.data(), m_leftover.size(), false);
+        if(len > 0)
+        {
+            submitParse(m_leftover, len);
+            m_leftover.erase(0, len);
+        }
+    }
+}
+
+//
+void BlockSeqReader::submitParse(const std::string& text, size_t len)
+{
+    if(len == 0)
+        return;
+    ParseTask* pTask = new ParseTask;
+    pTask->batch.m_buffer.assign(text, 0, len);
+    pTask->flags = m_flags;
+    submit(pTask);
+    m_batches.push_back(pTask);
+}
+
+//
+void BlockSeqReader::fillSegments()
+{
+    while(!m_inputDone && m_segments.size() < m_maxInFlight)
+    {
+        Segment* pSegment = readSegment();
+        if(pSegment == NULL)
+        {
+            m_inputDone = true;
+            break;
+        }
+
+        // Plain text does not need any work. If a member is being decompressed
+        // by the reading thread it will likely continue into the new segment so
+        // it is not worth decompressing the segment speculatively.
+        pSegment->speculate = m_mode != BM_PLAIN && pSegment->startsAtMember && m_pCarry == NULL;
+        if(pSegment->speculate)
+            submit(pSegment);
+        else
+            pSegment->done = true;
+        m_segments.push_back(pSegment);
+    }
+}
+
+//
+void BlockSeqReader::resolveSegment(Segment* pSegment, std::string& text)
+{
+    if(m_mode == BM_PLAIN)
+    {
+        text.swap(pSegment->data);
+        return;
+    }
+
+    if(m_pCarry == NULL && pSegment->inflated)
+    {
+        // The previous segment ended at a member boundary so
+        // the speculative decompression is correct
+        text.swap(pSegment->text);
+        m_pCarry = pSegment->pStream;
+        pSegment->pStream = NULL;
+        return;
+    }
+
+    // Decompress the segment here, continuing the member from the previous segment
+    if(!inflateMembers(m_pCarry, pSegment->data, text))
+    {
+        std::cerr << "Error: the compressed input is corrupt\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+//
+BlockSeqReader::Segment* BlockSeqReader::readSegment()
+{
+    Segment* pSegment = new Segment;
+    if(m_mode == BM_PLAIN)
+    {
+        pSegment->data.resize(SEGMENT_SIZE);
+        m_file.read(&pSegment->data[0], SEGMENT_SIZE);
+        pSegment->data.resize(m_file.gcount());
+    }
+    else if(m_mode == BM_BGZF)
+    {
+        // Every block starts a gzip member
+        pSegment->startsAtMember = true;
+        while(pSegment->data.size() < SEGMENT_SIZE && readBGZFBlock(pSegment->data)) {}
+    }
+    else
+    {
+        // Top up the pending bytes to two segments
+        size_t have = m_pending.size();
+        if(have < 2 * SEGMENT_SIZE && m_file.good())
+        {
+            m_pending.resize(2 * SEGMENT_SIZE);
+            m_file.read(&m_pending[have], 2 * SEGMENT_SIZE - have);
+            m_pending.resize(have + m_file.gcount());
+        }
+
+        // Cut the segment at the first byte after SEGMENT_SIZE that looks like
+        // the start of a gzip header. If there is no such byte, the rest of
+        // the pending data is used.
+        size_t cut = m_pending.size();
+        bool found = false;
+        const unsigned char* pData = (const unsigned char*)m_pending.data();
+        for(size_t i = SEGMENT_SIZE; i + 4 <= m_pending.size(); ++i)
+        {
+            const void* pNext = memchr(pData + i, 0x1f, m_pending.size() - i);
+            if(pNext == NULL)
+                break;
+            i = (const unsigned char*)pNext - pData;
+            if(i + 4 <= m_pending.size() && pData[i + 1] == 0x8b && pData[i + 2] == 8 && (pData[i + 3] & 0xe0) == 0)
+            {
+                cut = i;
+                found = true;
+                break;
+            }
+        }
+
+        pSegment->data.assign(m_pending, 0, cut);
+        m_pending.erase(0, cut);
+        pSegment->startsAtMember = m_nextStartsAtMember;
+        m_nextStartsAtMember = found;
+    }
+
+    if(pSegment->data.empty())
+    {
+        delete pSegment;
+        return NULL;
+    }
+    return pSegment;
+}
+
+// Append the next BGZF block to out. Returns false at the end of the file.
+bool BlockSeqReader::readBGZFBlock(std::string& out)
+{
+    unsigned char header[BGZF_HEADER_SIZE];
+    m_file.read((char*)header, BGZF_HEADER_SIZE);
+    if(m_file.gcount() == 0)
+        return false;
+
+    bool valid = m_file.gcount() == (std::streamsize)BGZF_HEADER_SIZE && header[0] == 0x1f && header[1] == 0x8b && (header[3] & 4);
+    size_t xlen = header[10] | (header[11] << 8);
+    std::string extra(xlen, '\0');
+    if(valid)
+    {
+        m_file.read(&extra[0], xlen);
+        valid = m_file.gcount() == (std::streamsize)xlen;
+    }
+
+    // Find the BC subfield holding the block size
+    size_t blockSize = 0;
+    for(size_t i = 0; valid && i + 4 <= xlen; )
+    {
+        size_t slen = (unsigned char)extra[i + 2] | ((unsigned char)extra[i + 3] << 8);
+        if(extra[i] == 'B' && extra[i + 1] == 'C' && slen == 2 && i + 6 <= xlen)
+        {
+            blockSize = ((unsigned char)extra[i + 4] | ((unsigned char)extra[i + 5] << 8)) + 1;
+            break;
+        }
+        i += 4 + slen;
+    }
+
+    if(!valid || blockSize < BGZF_HEADER_SIZE + xlen)
+    {
+        std::cerr << "Error: the input is not a valid BGZF file\n";
+        exit(EXIT_FAILURE);
+    }
+
+    size_t start = out.size();
+    size_t remaining = blockSize - BGZF_HEADER_SIZE - xlen;
+    out.append((const char*)header, BGZF_HEADER_SIZE);
+    out.append(extra);
+    out.resize(start + blockSize);
+    m_file.read(&out[start + BGZF_HEADER_SIZE + xlen], remaining);
+    if(m_file.gcount() != (std::streamsize)remaining)
+    {
+        std::cerr << "Error: unexpected end of BGZF file\n";
+        exit(EXIT_FAILURE);
+    }
+    return true;
+}
+
+//
+bool BlockSeqReader::inflateMembers(z_stream*& pStream, const std::string& data, std::string& out)
+{
+    char buffer[INFLATE_BUFFER_SIZE];
+    size_t pos = 0;
+    while(pos < data.size())
+    {
+        if(pStream == NULL)
+        {
+            pStream = new z_stream;
+            memset(pStream, 0, sizeof(z_stream));
+
+            // Decode a gzip header and trailer
+            if(inflateInit2(pStream, 16 + MAX_WBITS) != Z_OK)
+            {
+                delete pStream;
+                pStream = NULL;
+                return false;
+            }
+        }
+
+        pStream->next_in = (Bytef*)(data.data() + pos);
+        pStream->avail_in = data.size() - pos;
+
+        int ret;
+        do
+        {
+            pStream->next_out = (Bytef*)buffer;
+            pStream->avail_out = INFLATE_BUFFER_SIZE;
+            ret = inflate(pStream, Z_NO_FLUSH);
+            out.append(buffer, INFLATE_BUFFER_SIZE - pStream->avail_out);
+
+            if(ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+            {
+                destroyStream(pStream);
+                return false;
+            }
+
+            // All of the data has been used and the member continues
+            if(ret != Z_STREAM_END && pStream->avail_in == 0 && pStream->avail_out != 0)
+                return true;
+        } while(ret != Z_STREAM_END);
+
+        // The member is finished, the next one starts with the unused input
+        pos = data.size() - pStream->avail_in;
+        destroyStream(pStream);
+    }
+    return true;
+}
+
+//
+void BlockSeqReader::destroyStream(z_stream*& pStream)
+{
+    if(pStream != NULL)
+    {
+        inflateEnd(pStream);
+        delete pStream;
+        pStream = NULL;
+    }
+}
+
+//
+BlockSeqReader::Segment::~Segment()
+{
+    destroyStream(pStream);
+}
+
+// Decompress the segment assuming it starts with a gzip member
+void BlockSeqReader::Segment::run()
+{
+    inflated = inflateMembers(pStream, data, text);
+    if(!inflated)
+        text.clear();
+}
+
+//
+void BlockSeqReader::ParseTask::run()
+{
+    // An incomplete record at the end of the file is ignored
+    batch.parse(true, flags);
+}
+
+//
+void BlockSeqReader::submit(Task* pTask)
+{
+    pthread_mutex_lock(&m_mutex);
+    pTask->done = false;
+    m_taskQueue.push_back(pTask);
+    pthread_cond_signal(&m_taskCond);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+//
+void BlockSeqReader::wait(Task* pTask)
+{
+    pthread_mutex_lock(&m_mutex);
+    while(!pTask->done)
+        pthread_cond_wait(&m_doneCond, &m_mutex);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+// Main worker loop
+void BlockSeqReader::runWorker()
+{
+    while(1)
+    {
+        pthread_mutex_lock(&m_mutex);
+        while(m_taskQueue.empty() && !m_stopRequested)
+            pthread_cond_wait(&m_taskCond, &m_mutex);
+
+        if(m_taskQueue.empty())
+        {
+            pthread_mutex_unlock(&m_mutex);
+            break;
+        }
+
+        Task* pTask = m_taskQueue.front();
+        m_taskQueue.pop_front();
+        pthread_mutex_unlock(&m_mutex);
+
+        pTask->run();
+
+        pthread_mutex_lock(&m_mutex);
+        pTask->done = true;
+        pthread_cond_broadcast(&m_doneCond);
+        pthread_mutex_unlock(&m_mutex);
+    }
+}
+
+// Thread entry point
+void* BlockSeqReader::startThread(void* obj)
+{
+    reinterpret_cast<BlockSeqReader*>(obj)->runWorker();
+    return NULL;
+}
@@ -0,0 +1,156 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// BlockSeqReader - Read fasta or fastq records using
+// a pool of threads to decompress and parse the input.
+//
+// The file is split into segments of about 1MB. For BGZF
+// files the segments are made of whole blocks, found using
+// the block sizes stored in the headers. For other gzip files
+// the segments are cut where a gzip header appears to start.
+// Each segment is decompressed by a thread on the assumption
+// that it starts with a gzip member. If the member before
+// it did not end at the segment boundary, the speculative
+// result is thrown away and the segment is decompressed
+// by the reading thread instead. Files with a single gzip
+// member are therefore decompressed serially.
+//
+// The decompressed text is cut after the last complete record
+// and the records are parsed into SeqRecordBatches by the pool.
+// The batches are returned in file order.
+//
+#ifndef BLOCKSEQREADER_H
+#define BLOCKSEQREADER_H
+
+#include <pthread.h>
+#include <deque>
+#include <fstream>
+#include <zlib.h>
+#include "Util.h"
+#include "SeqRecordBatch.h"
+
+class BlockSeqReader
+{
+    public:
+        BlockSeqReader(const std::string& filename, uint32_t flags, int numThreads);
+        ~BlockSeqReader();
+
+        // Swap the next batch of records into batch
+        // Returns false when the file is exhausted
+        bool getBatch(SeqRecordBatch& batch);
+
+    private:
+
+        enum BlockMode
+        {
+            BM_PLAIN,
+            BM_GZIP,
+            BM_BGZF
+        };
+
+        // Work performed by the thread pool
+        struct Task
+        {
+            Task() : done(false) {}
+            virtual ~Task() {}
+            virtual void run() = 0;
+            bool done;
+        };
+
+        // A range of the input file
+        struct Segment : public Task
+        {
+            Segment() : startsAtMember(false), speculate(false), inflated(false), pStream(NULL) {}
+            ~Segment();
+            void run();
+
+            std::string data;
+            std::string text;
+
+            // Set if the segment probably begins with a gzip header
+            bool startsAtMember;
+
+            // Set if the segment should be decompressed by the pool
+            bool speculate;
+
+            // Set if the speculative decompression succeeded. If the
+            // last member continues into the next segment, its stream
+            // is held in pStream.
+            bool inflated;
+            z_stream* pStream;
+        };
+
+        // Text containing complete records to be parsed
+        struct ParseTask : public Task
+        {
+            void run();
+
+            uint32_t flags;
+            SeqRecordBatch batch;
+        };
+
+        typedef std::deque<Segment*> SegmentQueue;
+        typedef std::deque<ParseTask*> ParseQueue;
+
+        // Decompress the gzip members in data, appending the text to out.
+        // If pStream is NULL a new member starts at the start of data, otherwise
+        // the member being decompressed by pStream continues. On return, pStream
+        // is set if the last member continues past the end of data.
+        // Returns false if the data is not valid.
+        static bool inflateMembers(z_stream*& pStream, const std::string& data, std::string& out);
+        static void destroyStream(z_stream*& pStream);
+
+        // Read the next segment from the file. Returns NULL at the end of the file.
+        Segment* readSegment();
+        bool readBGZFBlock(std::string& out);
+
+        // Keep the pool busy with segments
+        void fillSegments();
+
+        // Set text to the decompressed contents of the oldest segment
+        void resolveSegment(Segment* pSegment, std::string& text);
+
+        // Queue parse tasks until the pool is busy or the file is exhausted
+        void fillBatches();
+        void submitParse(const std::string& text, size_t len);
+
+        // Thread pool
+        void submit(Task* pTask);
+        void wait(Task* pTask);
+        void runWorker();
+        static void* startThread(void* obj);
+
+        std::ifstream m_file;
+        BlockMode m_mode;
+        uint32_t m_flags;
+        size_t m_maxInFlight;
+
+        // Bytes read from a gzip file that are not yet part of a segment
+        std::string m_pending;
+        bool m_nextStartsAtMember;
+        bool m_inputDone;
+        bool m_textDone;
+
+        // The gzip member that continues from the last resolved segment
+        z_stream* m_pCarry;
+
+        // Decompressed text that does not yet contain a complete record
+        std::string m_leftover;
+
+        // The number of quality length warnings printed
+        int m_warnCount;
+
+        SegmentQueue m_segments;
+        ParseQueue m_batches;
+
+        std::vector<pthread_t> m_threads;
+        std::deque<Task*> m_taskQueue;
+        pthread_mutex_t m_mutex;
+        pthread_cond_t m_taskCond;
+        pthread_cond_t m_doneCond;
+        bool m_stopRequested;
+};
+
+#endif
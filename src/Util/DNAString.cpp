@@ -44,6 +44,20 @@ DNAString& DNAString::operator=(const std::string& str)
     return *this;
 }
 
+//
+void DNAString::assign(const char* pData, size_t l)
+{
+    if(m_data != NULL && l == m_len)
+    {
+        memcpy(m_data, pData, l);
+        m_data[l] = '\0';
+        return;
+    }
+
+    _dealloc();
+    _alloc(pData, l);
+}
+
 //
 bool DNAString::operator==(const DNAString& other)
 {
@@ -27,6 +27,10 @@ class DNAString
         // Operators
         DNAString& operator=(const DNAString& dna);
         DNAString& operator=(const std::string& str);
+
+        // Set the string to the l characters at pData. The existing
+        // memory is reused if it is the right size.
+        void assign(const char* pData, size_t l);
         bool operator==(const DNAString& other);
 
         size_t length() const
@@ -0,0 +1,198 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// KmerCountCache - Bounded cache of k-mer counts that
+// can be shared between threads
+//
+#include "KmerCountCache.h"
+#include "Util.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <iostream>
+#include <limits>
+
+// Set on the keys of used entries
+#define KMER_CACHE_USED_BIT (1ull << 63)
+
+//
+KmerCountCache::KmerCountCache(int k, size_t maxBytes) : m_k(k)
+{
+    assert(k > 0 && k <= MAX_KMER_LENGTH);
+
+    // Use the largest power of two number of sets that fits in maxBytes
+    size_t maxSets = maxBytes / (sizeof(Entry) * SET_SIZE * NUM_SHARDS);
+    m_setsPerShard = 1;
+    while(m_setsPerShard * 2 <= maxSets)
+        m_setsPerShard *= 2;
+
+    for(size_t i = 0; i < NUM_SHARDS; ++i)
+    {
+        Shard& shard = m_shards[i];
+        int ret = pthread_mutex_init(&shard.mutex, NULL);
+        if(ret != 0)
+        {
+            std::cerr << "Mutex initialization in KmerCountCache failed with error " << ret << ", aborting" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        shard.pEntries = (Entry*)calloc(m_setsPerShard * SET_SIZE, sizeof(Entry));
+        if(shard.pEntries == NULL)
+        {
+            std::cerr << "KmerCountCache failed to allocate " << maxBytes << " bytes, aborting" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        shard.clock = 0;
+        shard.numLookups = 0;
+        shard.numHits = 0;
+        shard.numInserts = 0;
+        shard.numEvictions = 0;
+    }
+}
+
+//
+KmerCountCache::~KmerCountCache()
+{
+    for(size_t i = 0; i < NUM_SHARDS; ++i)
+    {
+        pthread_mutex_destroy(&m_shards[i].mutex);
+        free(m_shards[i].pEntries);
+    }
+}
+
+//
+bool KmerCountCache::lookup(const char* w, size_t& count)
+{
+    uint64_t key;
+    if(!makeKey(w, key))
+        return false;
+
+    Shard* pShard;
+    Entry* pSet = getSet(key, pShard);
+
+    bool found = false;
+    pthread_mutex_lock(&pShard->mutex);
+    pShard->numLookups += 1;
+    for(size_t i = 0; i < SET_SIZE; ++i)
+    {
+        if(pSet[i].key == key)
+        {
+            pSet[i].stamp = ++pShard->clock;
+            count = pSet[i].count;
+            pShard->numHits += 1;
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pShard->mutex);
+    return found;
+}
+
+//
+void KmerCountCache::insert(const char* w, size_t count)
+{
+    uint64_t key;
+    if(!makeKey(w, key))
+        return;
+
+    // Counts that do not fit are stored as the largest value that does
+    uint32_t value = count < std::numeric_limits<uint32_t>::max() ? count : std::numeric_limits<uint32_t>::max();
+
+    Shard* pShard;
+    Entry* pSet = getSet(key, pShard);
+
+    pthread_mutex_lock(&pShard->mutex);
+
+    // Use the entry for the key if another thread has added it,
+    // otherwise replace the least recently used entry. The clock
+    // is compared by distance so it may wrap around.
+    Entry* pTarget = &pSet[0];
+    uint32_t now = ++pShard->clock;
+    for(size_t i = 0; i < SET_SIZE; ++i)
+    {
+        if(pSet[i].key == key || pSet[i].key == 0)
+        {
+            pTarget = &pSet[i];
+            break;
+        }
+
+        if(now - pSet[i].stamp > now - pTarget->stamp)
+            pTarget = &pSet[i];
+    }
+
+    if(pTarget->key != key)
+    {
+        pShard->numInserts += 1;
+        if(pTarget->key != 0)
+            pShard->numEvictions += 1;
+    }
+
+    pTarget->key = key;
+    pTarget->count = value;
+    pTarget->stamp = now;
+    pthread_mutex_unlock(&pShard->mutex);
+}
+
+//
+size_t KmerCountCache::getNumLookups() const
+{
+    size_t n = 0;
+    for(size_t i = 0; i < NUM_SHARDS; ++i)
+        n += m_shards[i].numLookups;
+    return n;
+}
+
+//
+size_t KmerCountCache::getNumHits() const
+{
+    size_t n = 0;
+    for(size_t i = 0; i < NUM_SHARDS; ++i)
+        n += m_shards[i].numHits;
+    return n;
+}
+
+//
+void KmerCountCache::printStats(FILE* fp) const
+{
+    size_t numLookups = getNumLookups();
+    size_t numHits = getNumHits();
+    size_t numInserts = 0;
+    size_t numEvictions = 0;
+    for(size_t i = 0; i < NUM_SHARDS; ++i)
+    {
+        numInserts += m_shards[i].numInserts;
+        numEvictions += m_shards[i].numEvictions;
+    }
+
+    size_t bytes = NUM_SHARDS * m_setsPerShard * SET_SIZE * sizeof(Entry);
+    fprintf(fp, "Kmer count cache: %zu lookups, %zu hits (%.2lf%%), %zu inserts, %zu evictions, %.1lf MB\n",
+            numLookups, numHits, numLookups > 0 ? 100.0 * numHits / numLookups : 0.0,
+            numInserts, numEvictions, (double)bytes / (1024 * 1024));
+}
+
+//
+bool KmerCountCache::makeKey(const char* w, uint64_t& key) const
+{
+    if(!packCanonicalKmer(w, m_k, key))
+        return false;
+    key |= KMER_CACHE_USED_BIT;
+    return true;
+}
+
+//
+KmerCountCache::Entry* KmerCountCache::getSet(uint64_t key, Shard*& pShard)
+{
+    // Mix the bits of the key (the MurmurHash3 finalizer)
+    uint64_t h = key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+
+    pShard = &m_shards[h % NUM_SHARDS];
+    size_t set = (h / NUM_SHARDS) & (m_setsPerShard - 1);
+    return pShard->pEntries + set * SET_SIZE;
+}
@@ -0,0 +1,90 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// KmerCountCache - Bounded cache of k-mer counts that
+// can be shared between threads
+//
+// The k-mers are packed into 2 bits per base and stored
+// in their canonical form, the smaller of the k-mer and its
+// reverse complement, as the cached counts include both strands.
+// The table is split into shards that are each protected by
+// a mutex. Each shard is a set-associative hash table. When a
+// set is full, the least recently used entry is evicted.
+//
+#ifndef KMERCOUNTCACHE_H
+#define KMERCOUNTCACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
+
+class KmerCountCache
+{
+    public:
+
+        // The longest k-mer that can be packed into a key
+        static const int MAX_KMER_LENGTH = 31;
+
+        // Create a cache for k-mers of length k that uses
+        // at most maxBytes of memory for the table
+        KmerCountCache(int k, size_t maxBytes);
+        ~KmerCountCache();
+
+        // Look up the count of the k-mer starting at w. Returns false
+        // if the k-mer is not in the cache.
+        bool lookup(const char* w, size_t& count);
+
+        // Add the count of the k-mer starting at w to the cache
+        void insert(const char* w, size_t count);
+
+        // Print the number of lookups, the hit rate and the number of evictions
+        void printStats(FILE* fp = stdout) const;
+
+        size_t getNumLookups() const;
+        size_t getNumHits() const;
+
+    private:
+
+        struct Entry
+        {
+            uint64_t key; // 0 if the entry is unused
+            uint32_t count;
+            uint32_t stamp; // the time of the last access, for eviction
+        };
+
+        struct Shard
+        {
+            pthread_mutex_t mutex;
+            Entry* pEntries;
+            uint32_t clock;
+
+            size_t numLookups;
+            size_t numHits;
+            size_t numInserts;
+            size_t numEvictions;
+        };
+
+        // The number of entries in a set and the number of shards
+        static const size_t SET_SIZE = 4;
+        static const size_t NUM_SHARDS = 64;
+
+        // Caches cannot be copied
+        KmerCountCache(const KmerCountCache&);
+        KmerCountCache& operator=(const KmerCountCache&);
+
+        // Pack the canonical form of the k-mer at w into key.
+        // Returns false if the k-mer contains a symbol that is not A,C,G,T
+        bool makeKey(const char* w, uint64_t& key) const;
+
+        // Return the set the key belongs to in shard
+        Entry* getSet(uint64_t key, Shard*& pShard);
+
+        int m_k;
+        size_t m_setsPerShard;
+        Shard m_shards[NUM_SHARDS];
+};
+
+#endif
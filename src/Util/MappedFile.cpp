@@ -0,0 +1,56 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// MappedFile - Read-only memory mapping of a file.
+//
+#include "MappedFile.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//
+MappedFile::MappedFile(const std::string& filename) : m_filename(filename), m_pData(NULL), m_size(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd == -1)
+    {
+        std::cerr << "Error: could not open " << filename << " for mapping: " << strerror(errno) << "\n";
+        exit(EXIT_FAILURE);
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        std::cerr << "Error: could not stat " << filename << ": " << strerror(errno) << "\n";
+        exit(EXIT_FAILURE);
+    }
+    m_size = st.st_size;
+
+    if(m_size > 0)
+    {
+        void* ptr = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if(ptr == MAP_FAILED)
+        {
+            std::cerr << "Error: could not map " << filename << ": " << strerror(errno) << "\n";
+            exit(EXIT_FAILURE);
+        }
+        m_pData = static_cast<const char*>(ptr);
+    }
+
+    // The mapping remains valid after the descriptor is closed
+    close(fd);
+}
+
+//
+MappedFile::~MappedFile()
+{
+    if(m_pData != NULL)
+        munmap(const_cast<char*>(m_pData), m_size);
+}
@@ -0,0 +1,39 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// MappedFile - Read-only memory mapping of a file.
+// The mapping is shared so that multiple processes
+// loading the same file use a single copy of the
+// data in the page cache.
+//
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <stdint.h>
+#include <cstddef>
+
+class MappedFile
+{
+    public:
+        MappedFile(const std::string& filename);
+        ~MappedFile();
+
+        // Return a pointer to the data at the given offset into the file
+        inline const char* getData(size_t offset = 0) const { return m_pData + offset; }
+        inline size_t getSize() const { return m_size; }
+
+    private:
+
+        // Mappings cannot be copied
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+
+        std::string m_filename;
+        const char* m_pData;
+        size_t m_size;
+};
+
+#endif
@@ -70,10 +70,10 @@ Overlap MultiOverlap::getOverlap(size_t idx) const
 std::string MultiOverlap::simpleConsensus() const
 {
     std::string out;
+    PackedPileup pileup = getPackedPileup();
     for(size_t i = 0; i < m_rootSeq.size(); ++i)
     {
-        Pileup p = getPileup(i);
-        AlphaCount64 ac = p.getAlphaCount();
+        AlphaCount64 ac = pileup.countColumn(i);
         char maxBase;
         BaseCount maxCount;
         ac.getMax(maxBase, maxCount);
@@ -91,10 +91,10 @@ std::string MultiOverlap::simpleConsensus() const
 int MultiOverlap::countPotentialIncorrect(size_t cutoff) const
 {
     int count = 0;
+    PackedPileup pileup = getPackedPileup();
     for(size_t i = 0; i < m_rootSeq.size(); ++i)
     {
-        Pileup p = getPileup(i);
-        AlphaCount64 ac = p.getAlphaCount();
+        AlphaCount64 ac = pileup.countColumn(i);
         char maxBase;
         BaseCount maxCount;
         ac.getMax(maxBase, maxCount);
@@ -109,10 +109,10 @@ int MultiOverlap::countPotentialIncorrect(size_t cutoff) const
 int MultiOverlap::countBasesCovered() const
 {
     int count = 0;
+    PackedPileup pileup = getPackedPileup();
     for(size_t i = 0; i < m_rootSeq.size(); ++i)
     {
-        Pileup p = getPileup(i);
-        if(p.getDepth() > 1)
+        if(pileup.countColumn(i).getSum() > 1)
             ++count;
     }
     return count;
@@ -123,10 +123,10 @@ int MultiOverlap::countBasesCovered() const
 // prevalent base has a frequency greater than cutoff
 bool MultiOverlap::isConflicted(size_t cutoff) const
 {
+    PackedPileup pileup = getPackedPileup();
     for(size_t i = 0; i < m_rootSeq.size(); ++i)
     {
-        Pileup p = getPileup(i);
-        AlphaCount64 ac = p.getAlphaCount();
+        AlphaCount64 ac = pileup.countColumn(i);
 
         char order[5];
         ac.getSorted(order, 5);
@@ -157,11 +157,9 @@ void MultiOverlap::setPartition(size_t idx, int p)
 size_t MultiOverlap::getNumBases() const
 {
     size_t count = 0;
+    PackedPileup pileup = getPackedPileup();
     for(size_t i = 0; i < m_rootSeq.size(); ++i)
-    {
-        Pileup p = getPileup(i);
-        count += p.getDepth();
-    }
+        count += pileup.countColumn(i).getSum();
     return count;
 }
 
@@ -173,78 +171,80 @@ size_t MultiOverlap::getNumBases() const
 // are called from the entire set of overlaps.
 std::string MultiOverlap::consensusConflict(double /*p_error*/, int conflictCutoff)
 {
+    // The bases aligned to each position of the read are stored contiguously
+    // so the columns are counted a register at a time
+    PackedPileup pileup = getPackedPileup();
+
     // Calculate the frequency vector for each base of the read
     std::vector<AlphaCount64> acVec;
+    acVec.reserve(m_rootSeq.size());
     for(size_t i = 0; i < m_rootSeq.size(); ++i)
-    {
-        AlphaCount64 ac = getAlphaCount(i);
-        acVec.push_back(ac);
-    }
+        acVec.push_back(pileup.countColumn(i));
 
-    // Sort the alphacounts by frequency
-    StringVector sortedVec;
-    sortedVec.reserve(acVec.size());
+    // Tally, for every overlap, the conflicted positions at which
+    // it matches or mismatches the root read. A position is visited once
+    // and its column is scanned in row order.
+    std::vector<int> numMatch(m_overlaps.size(), 0);
+    std::vector<int> numMismatch(m_overlaps.size(), 0);
     for(size_t i = 0; i < acVec.size(); ++i)
     {
+        // If the second-most prevelent base is above the conflict cutoff,
+        // call this position conflicted
         char sorted[ALPHABET_SIZE];
         acVec[i].getSorted(sorted, ALPHABET_SIZE);
-        sortedVec.push_back(std::string(sorted, ALPHABET_SIZE));
+        int second = acVec[i].get(sorted[1]);
+        bool isConflict = second > conflictCutoff;
+
+        // Check if the reads match the root if:
+        // a) the read contains a basecall at this position (it overlaps
+        //  the read at this position)
+        // b) the root read base is one of the two most frequent bases 
+        //  (to filter out sequencing errors at this position in the root).
+        int rootCount = acVec[i].get(m_rootSeq[i]);
+        if(!isConflict || rootCount <= conflictCutoff)
+            continue;
+
+        const uint8_t* pColumn = pileup.getColumn(i);
+        uint8_t rootCell = pColumn[0];
+        for(size_t j = 0; j < m_overlaps.size(); ++j)
+        {
+            uint8_t b = pColumn[j + 1];
+            if(b == rootCell)
+                ++numMatch[j];
+            else if(b != PackedPileup::NO_BASE)
+                ++numMismatch[j];
+        }
     }
 
+    // The root read is always in partition 0
+    std::vector<uint8_t> rowMask(pileup.getStride(), 0);
+    rowMask[0] = PackedPileup::ROW_SELECTED;
+
     // Filter out overlaps that do not match the reference
     // at conflicted positions
     for(size_t j = 0; j < m_overlaps.size(); ++j)
     {
-        int numMatch = 0;
-        int numMismatch = 0;
-        int numConflicted = 0;
-        for(size_t i = 0; i < acVec.size(); ++i)
-        {
-            char rootBase = m_rootSeq[i];
-            std::string& sorted = sortedVec[i];
-            int second = acVec[i].get(sorted[1]);
-
-            // If the second-most prevelent base is above the conflict cutoff,
-            // call this position conflicted
-            bool isConflict = second > conflictCutoff;
-
-            // Get the basecall for read j at position i
-            char b = getMODBase(m_overlaps[j], i);
-
-            if(isConflict)
-            {
-                // Check if the read matches the root if:
-                // a) the read contains a basecall at this position (it overlaps
-                //  the read at this position)
-                // b) the root read base is one of the two most frequent bases 
-                //  (to filter out sequencing errors at this position in the root).
-                int rootCount = acVec[i].get(rootBase);
-                if(b != '\0' && rootCount > conflictCutoff)
-                {
-                    if(b == rootBase)
-                        ++numMatch;
-                    else
-                        ++numMismatch;
-                    ++numConflicted;
-                }
-            }
-        }
-
         // Set the overlap score to be the fraction of conflict bases that this read
         // matches the root read at. 
+        int numConflicted = numMatch[j] + numMismatch[j];
         double frac;
         if(numConflicted == 0)
             frac = 1.0f;
         else
-            frac = (double)numMatch/(double)numConflicted;
+            frac = (double)numMatch[j]/(double)numConflicted;
         m_overlaps[j].score = frac;
 
         // Filter out the read if there are any conflicted bases
         // that this read does not match the root read at
-        if(numConflicted > 0 && numMismatch > 0)
+        if(numConflicted > 0 && numMismatch[j] > 0)
+        {
             m_overlaps[j].partitionID = 1;
+        }
         else
+        {
             m_overlaps[j].partitionID = 0;
+            rowMask[j + 1] = PackedPileup::ROW_SELECTED;
+        }
     }
 
     // Calculate the consensus sequence using all the reads
@@ -255,10 +255,7 @@ std::string MultiOverlap::consensusConflict(double /*p_error*/, int conflictCuto
 
     for(size_t i = 0; i < m_rootSeq.size(); ++i)
     {
-        Pileup p0;
-        Pileup p1;
-        getPartitionedPileup(i, p0, p1);
-        AlphaCount64 ac = p0.getAlphaCount();
+        AlphaCount64 ac = pileup.countColumn(i, &rowMask[0]);
         
         size_t minSupport = CorrectionThresholds::Instance().getMinSupportLowQuality();
         if(!m_rootQual.empty())
@@ -320,9 +317,10 @@ std::string MultiOverlap::consensusConflict(double /*p_error*/, int conflictCuto
 //
 bool MultiOverlap::qcCheck() const
 {
+    PackedPileup pileup = getPackedPileup();
     for(size_t i = 0; i < m_rootSeq.size(); ++i)
     {
-        AlphaCount64 ac = getAlphaCount(i);
+        AlphaCount64 ac = pileup.countColumn(i);
         size_t callSupport = ac.get(m_rootSeq[i]);
         if(callSupport < 2)
             return false;
@@ -351,11 +349,9 @@ void MultiOverlap::countOverlaps(size_t& prefix_count, size_t& suffix_count) con
 double MultiOverlap::getMeanDepth() const
 {
     double depth = 0.0f;
+    PackedPileup pileup = getPackedPileup();
     for(size_t i = 0; i < m_rootSeq.size(); ++i)
-    {
-        Pileup p = getPileup(i);
-        depth += p.getDepth();
-    }
+        depth += pileup.countColumn(i).getSum();
     return depth / m_rootSeq.size();
 }
 
@@ -427,6 +423,16 @@ std::string MultiOverlap::calculateConsensusFromPartition(double p_error)
     return out;
 }
 
+// Pack the root and the overlapping sequences into a column-major matrix
+PackedPileup MultiOverlap::getPackedPileup() const
+{
+    PackedPileup pileup(m_rootSeq.size(), m_overlaps.size() + 1);
+    pileup.setRow(0, m_rootSeq, 0);
+    for(size_t i = 0; i < m_overlaps.size(); ++i)
+        pileup.setRow(i + 1, m_overlaps[i].seq, m_overlaps[i].offset);
+    return pileup;
+}
+
 // Return the base in mod that matches the base at
 // idx in the root seq. If mod does not overlap 
 // the root at this position, returns '\0'
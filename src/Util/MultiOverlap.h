@@ -12,6 +12,7 @@
 
 #include "Match.h"
 #include "Pileup.h"
+#include "PackedPileup.h"
 #include "DNADouble.h"
 
 class MultiOverlap
@@ -103,6 +104,10 @@ class MultiOverlap
 
     private:
 
+        // Pack the root and the overlapping sequences into a column-major
+        // matrix. The root is row 0 and overlap i is row i + 1.
+        PackedPileup getPackedPileup() const;
+
         AlphaCount64 getAlphaCount(int idx) const;
         Pileup getPileup(int idx) const;
         Pileup getPileup(int idx, int numElems) const;
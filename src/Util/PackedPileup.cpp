@@ -0,0 +1,192 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// PackedPileup - The bases of a multi-overlap stored
+// as a column-major matrix of base ranks.
+//
+#include <assert.h>
+#include <algorithm>
+#include "PackedPileup.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+const uint8_t PackedPileup::NO_BASE;
+const uint8_t PackedPileup::ROW_SELECTED;
+
+//
+PackedPileup::PackedPileup(size_t numColumns, size_t numRows) : m_numColumns(numColumns),
+                                                                m_numRows(numRows)
+{
+    m_stride = (numRows + PACKED_PILEUP_BLOCK - 1) / PACKED_PILEUP_BLOCK * PACKED_PILEUP_BLOCK;
+    m_data.resize(m_numColumns * m_stride, NO_BASE);
+}
+
+//
+void PackedPileup::setRow(size_t row, const std::string& seq, int offset)
+{
+    assert(row < m_numRows);
+
+    // Clip seq to the columns of the matrix
+    int first = offset < 0 ? -offset : 0;
+    int last = std::min((int)seq.size(), (int)m_numColumns - offset);
+    for(int i = first; i < last; ++i)
+        m_data[(i + offset) * m_stride + row] = encode(seq[i]);
+}
+
+//
+uint8_t PackedPileup::encode(char b)
+{
+    uint8_t rank = getBaseRank(b);
+    if(rank != 0)
+        return rank;
+
+    // Keep the character unless it could be mistaken for a rank of A, C, G, T or for NO_BASE
+    uint8_t c = static_cast<uint8_t>(b);
+    return (c < ALPHABET_SIZE || c == NO_BASE) ? 0 : c;
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+// Build the counts of a column from the counts of A, C, G and T
+// and the number of covered cells. The other cells count as rank 0.
+static inline AlphaCount64 makeAlphaCount(const size_t* counts, size_t covered)
+{
+    AlphaCount64 ac;
+    size_t numDNA = 0;
+    for(size_t r = 1; r < ALPHABET_SIZE; ++r)
+    {
+        ac.setByIdx(r, counts[r]);
+        numDNA += counts[r];
+    }
+    ac.setByIdx(0, covered - numDNA);
+    return ac;
+}
+
+#endif
+
+#if defined(__AVX2__)
+
+//
+AlphaCount64 PackedPileup::countColumn(size_t column) const
+{
+    size_t counts[ALPHABET_SIZE] = { 0 };
+    size_t covered = 0;
+    const uint8_t* pColumn = getColumn(column);
+    for(size_t j = 0; j < m_stride; j += PACKED_PILEUP_BLOCK)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(pColumn + j));
+        __m256i empty = _mm256_cmpeq_epi8(v, _mm256_set1_epi8((char)NO_BASE));
+        covered += PACKED_PILEUP_BLOCK - __builtin_popcount((uint32_t)_mm256_movemask_epi8(empty));
+        for(size_t r = 1; r < ALPHABET_SIZE; ++r)
+        {
+            __m256i match = _mm256_cmpeq_epi8(v, _mm256_set1_epi8((char)r));
+            counts[r] += __builtin_popcount((uint32_t)_mm256_movemask_epi8(match));
+        }
+    }
+    return makeAlphaCount(counts, covered);
+}
+
+//
+AlphaCount64 PackedPileup::countColumn(size_t column, const uint8_t* pRowMask) const
+{
+    size_t counts[ALPHABET_SIZE] = { 0 };
+    size_t covered = 0;
+    const uint8_t* pColumn = getColumn(column);
+    for(size_t j = 0; j < m_stride; j += PACKED_PILEUP_BLOCK)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(pColumn + j));
+        __m256i mask = _mm256_loadu_si256((const __m256i*)(pRowMask + j));
+        __m256i selected = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8((char)NO_BASE)), mask);
+        covered += __builtin_popcount((uint32_t)_mm256_movemask_epi8(selected));
+        for(size_t r = 1; r < ALPHABET_SIZE; ++r)
+        {
+            __m256i match = _mm256_and_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8((char)r)), mask);
+            counts[r] += __builtin_popcount((uint32_t)_mm256_movemask_epi8(match));
+        }
+    }
+    return makeAlphaCount(counts, covered);
+}
+
+#elif defined(__SSE2__)
+
+//
+AlphaCount64 PackedPileup::countColumn(size_t column) const
+{
+    size_t counts[ALPHABET_SIZE] = { 0 };
+    size_t covered = 0;
+    const uint8_t* pColumn = getColumn(column);
+    for(size_t j = 0; j < m_stride; j += PACKED_PILEUP_BLOCK)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pColumn + j));
+        __m128i empty = _mm_cmpeq_epi8(v, _mm_set1_epi8((char)NO_BASE));
+        covered += PACKED_PILEUP_BLOCK - __builtin_popcount(_mm_movemask_epi8(empty));
+        for(size_t r = 1; r < ALPHABET_SIZE; ++r)
+        {
+            __m128i match = _mm_cmpeq_epi8(v, _mm_set1_epi8((char)r));
+            counts[r] += __builtin_popcount(_mm_movemask_epi8(match));
+        }
+    }
+    return makeAlphaCount(counts, covered);
+}
+
+//
+AlphaCount64 PackedPileup::countColumn(size_t column, const uint8_t* pRowMask) const
+{
+    size_t counts[ALPHABET_SIZE] = { 0 };
+    size_t covered = 0;
+    const uint8_t* pColumn = getColumn(column);
+    for(size_t j = 0; j < m_stride; j += PACKED_PILEUP_BLOCK)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pColumn + j));
+        __m128i mask = _mm_loadu_si128((const __m128i*)(pRowMask + j));
+        __m128i selected = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)NO_BASE)), mask);
+        covered += __builtin_popcount(_mm_movemask_epi8(selected));
+        for(size_t r = 1; r < ALPHABET_SIZE; ++r)
+        {
+            __m128i match = _mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)r)), mask);
+            counts[r] += __builtin_popcount(_mm_movemask_epi8(match));
+        }
+    }
+    return makeAlphaCount(counts, covered);
+}
+
+#else
+
+// Portable versions of the above
+AlphaCount64 PackedPileup::countColumn(size_t column) const
+{
+    AlphaCount64 ac;
+    const uint8_t* pColumn = getColumn(column);
+    for(size_t j = 0; j < m_numRows; ++j)
+    {
+        if(pColumn[j] != NO_BASE)
+        {
+            size_t r = pColumn[j] < ALPHABET_SIZE ? pColumn[j] : 0;
+            ac.setByIdx(r, ac.getByIdx(r) + 1);
+        }
+    }
+    return ac;
+}
+
+AlphaCount64 PackedPileup::countColumn(size_t column, const uint8_t* pRowMask) const
+{
+    AlphaCount64 ac;
+    const uint8_t* pColumn = getColumn(column);
+    for(size_t j = 0; j < m_numRows; ++j)
+    {
+        if(pColumn[j] != NO_BASE && pRowMask[j] == ROW_SELECTED)
+        {
+            size_t r = pColumn[j] < ALPHABET_SIZE ? pColumn[j] : 0;
+            ac.setByIdx(r, ac.getByIdx(r) + 1);
+        }
+    }
+    return ac;
+}
+
+#endif
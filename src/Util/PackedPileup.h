@@ -0,0 +1,76 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// PackedPileup - The bases of a multi-overlap stored
+// as a column-major matrix of base ranks. Each column
+// holds one byte per row, padded to a multiple of the
+// SIMD register width, so the bases aligned to a position
+// of the root read are contiguous and can be counted
+// a register at a time. A, C, G and T are stored as their
+// AlphaCount ranks. Other symbols are stored as their character
+// so distinct symbols stay distinct, and are counted under
+// rank 0 as AlphaCount does.
+//
+#ifndef PACKEDPILEUP_H
+#define PACKEDPILEUP_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "Alphabet.h"
+
+#if defined(__AVX2__)
+#define PACKED_PILEUP_BLOCK 32
+#else
+#define PACKED_PILEUP_BLOCK 16
+#endif
+
+class PackedPileup
+{
+    public:
+
+        // The value of a cell that is not covered by its row
+        static const uint8_t NO_BASE = 0xFF;
+
+        // The value of a row in a row mask that selects the row
+        static const uint8_t ROW_SELECTED = 0xFF;
+
+        // Create an empty matrix of numColumns columns and numRows rows
+        PackedPileup(size_t numColumns, size_t numRows);
+
+        // Set the bases of row from seq. The first base of seq
+        // aligns to column offset, which may be negative.
+        void setRow(size_t row, const std::string& seq, int offset);
+
+        //
+        size_t getNumColumns() const { return m_numColumns; }
+        size_t getNumRows() const { return m_numRows; }
+
+        // The number of bytes in a column, including the padding.
+        // Row masks passed to countColumn must be this long.
+        size_t getStride() const { return m_stride; }
+
+        // Return the value stored in a cell for the symbol b
+        static uint8_t encode(char b);
+
+        // Return a pointer to the cells of the column
+        const uint8_t* getColumn(size_t column) const { return &m_data[column * m_stride]; }
+
+        // Count the bases in the column
+        AlphaCount64 countColumn(size_t column) const;
+
+        // Count the bases in the column of the rows that are
+        // set to ROW_SELECTED in pRowMask
+        AlphaCount64 countColumn(size_t column, const uint8_t* pRowMask) const;
+
+    private:
+
+        size_t m_numColumns;
+        size_t m_numRows;
+        size_t m_stride;
+        std::vector<uint8_t> m_data;
+};
+
+#endif
@@ -50,6 +50,19 @@ void ReadTable::reverseAll()
         m_table[i].seq.reverse();
 }
 
+//
+void ReadTable::addReverseComplements()
+{
+    size_t numReads = getCount();
+    m_table.reserve(2 * numReads);
+    for(size_t i = 0; i < numReads; ++i)
+    {
+        SeqItem read = m_table[i];
+        read.seq.reverseComplement();
+        addRead(read);
+    }
+}
+
 //
 void ReadTable::addRead(const SeqItem& r)
 {
@@ -29,6 +29,11 @@ class ReadTable
         // Reverse all the reads in this table
         void reverseAll();
 
+        // Append the reverse complement of every read to the table.
+        // The reverse complement of read i is stored at index i + n
+        // where n is the number of reads before the call.
+        void addReverseComplements();
+
         // Build a readid -> read index
         void indexReadsByID();
 
@@ -9,12 +9,22 @@
 #include <iostream>
 #include <algorithm>
 #include "SeqReader.h"
+#include "BlockSeqReader.h"
 #include "Util.h"
 
-SeqReader::SeqReader(std::string filename, uint32_t flags) : m_flags(flags)
+// The number of bytes read from the file for each batch
+static const size_t READ_CHUNK_SIZE = 1 << 16;
+
+SeqReader::SeqReader(std::string filename, uint32_t flags, int numThreads) : m_pHandle(NULL),
+                                                                             m_pBlockReader(NULL),
+                                                                             m_flags(flags),
+                                                                             m_batchPos(0),
+                                                                             m_warnCount(0)
 {
     if(filename == "-")
         m_pHandle = &std::cin;
+    else if(numThreads > 1)
+        m_pBlockReader = new BlockSeqReader(filename, flags, numThreads);
     else
         m_pHandle = createReader(filename);
 }
@@ -23,114 +33,54 @@ SeqReader::~SeqReader()
 {
     if(m_pHandle != &std::cin)
         delete m_pHandle;
+    delete m_pBlockReader;
 }
 
 // Extract an element from the file
 // Return true if successful
 bool SeqReader::get(SeqRecord& sr)
 {
-    static int warn_count = 0;
-    const int MAX_WARN = 10;
-    RecordType rt = RT_UNKNOWN;
-    std::string header;
-    while(m_pHandle->good())
+    while(m_batchPos == m_batch.size())
     {
-        getline(*m_pHandle, header);
-        if(header.empty())
-            continue;
-
-        if(header[0] == '>')
-        {
-            rt = RT_FASTA;
-            break;
-        }
-        else if(header[0] == '@')
-        {
-            rt = RT_FASTQ;
-            break;
-        }
+        if(!getBatch(m_batch))
+            return false;
+        m_batchPos = 0;
     }
 
-    if(rt == RT_UNKNOWN)
-    {
-        // No valid start found
-        return false;
-    }
-    
-    // Parse the rest of the record
-    bool validRecord = false;
-    std::string seq;
-    std::string qual;
-
-    if(rt == RT_FASTA)
-    {
-        std::string temp;
-        while(m_pHandle->good() && m_pHandle->peek() != '>' && m_pHandle->peek() != '@')
-        {
-            getline(*m_pHandle, temp);
-            if(m_pHandle->good() && temp.size() > 0)
-                seq.append(temp);
-        }
+    m_batch[m_batchPos++].toSeqRecord(sr);
+    return true;
+}
 
-        // The record is valid if we extracted at least 1 bp for the sequence
-        // at this point the eof may have been hit but we still want the data
-        validRecord = seq.size() > 0; 
-    }
-    else if(rt == RT_FASTQ)
-    {
-        std::string temp;
-        getline(*m_pHandle, seq);
-        getline(*m_pHandle, temp); //discard
-        getline(*m_pHandle, qual);
+//
+bool SeqReader::getBatch(SeqRecordBatch& batch)
+{
+    if(m_pBlockReader != NULL)
+        return m_pBlockReader->getBatch(batch);
 
-        // FASTQ is required to have 4 fields, we must not have hit the EOF by this point
-        if(seq.size() != qual.size() && warn_count++ < MAX_WARN)
-        {
-            std::cerr << "Warning, FASTQ quality string is not the same length as the sequence string for read " << header << "\n";
-        }
-        
-        // Fix [Issue GH-3]: Handle FASTQ records that have no sequence or quality value. We only
-        // emit a warning here as long as the record is properly formed.
-        if(seq.empty() || qual.empty())
-        {
-            std::cerr << "Warning, read " << header << " has no sequence or quality values\n";
-        }
-        validRecord = !m_pHandle->eof();
-    }
+    // Start the batch with the incomplete record from the last call
+    // and read until the batch holds at least one complete record
+    batch.clear();
+    std::string& buffer = batch.m_buffer;
+    buffer.swap(m_carry);
 
-    if(validRecord)
+    while(true)
     {
-        // Parse the id
-        size_t endPos = std::min(header.find_first_of(' '), header.find_first_of('\t'));
-        if(endPos != std::string::npos)
-        {
-            assert(endPos > 0);
-            sr.id = header.substr(1, endPos - 1);
-        }
-        else
+        bool atEOF = !m_pHandle->good();
+        if(!atEOF)
         {
-            sr.id = header.substr(1);
+            size_t have = buffer.size();
+            buffer.resize(have + READ_CHUNK_SIZE);
+            m_pHandle->read(&buffer[have], READ_CHUNK_SIZE);
+            buffer.resize(have + m_pHandle->gcount());
+            atEOF = !m_pHandle->good();
         }
 
-        // Convert the sequence string to upper case
-        if( !(m_flags & SRF_KEEP_CASE) )
-            std::transform(seq.begin(), seq.end(), seq.begin(), ::toupper);
-
-        // If the validation flag is set, ensure that there aren't any non-ACGT bases
-        if( !(m_flags & SRF_NO_VALIDATION) )
+        size_t consumed = batch.parse(atEOF, m_flags);
+        batch.report(m_warnCount);
+        if(!batch.empty() || atEOF)
         {
-            if(seq.find_first_not_of("ACGT") != std::string::npos)
-            {
-                std::cerr << "Error: read " << sr.id << " contains non-ACGT characters.\n";
-                std::cerr << "Please run sga preprocess on the data first.\n";
-                exit(EXIT_FAILURE);
-            }
+            m_carry.assign(buffer, consumed, std::string::npos);
+            return !batch.empty();
         }
-
-        sr.seq = seq;
-        sr.qual = qual;
-
     }
-
-    return validRecord;
 }
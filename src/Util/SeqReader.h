@@ -11,6 +11,7 @@
 
 #include <fstream>
 #include "Util.h"
+#include "SeqRecordBatch.h"
 
 enum RecordType
 {
@@ -22,17 +23,40 @@ enum RecordType
 static const uint32_t SRF_NO_VALIDATION = 1;
 static const uint32_t SRF_KEEP_CASE = 2;
 
+class BlockSeqReader;
+
 //
 class SeqReader
 {
     public:
-        SeqReader(std::string filename, uint32_t flags = 0);
+        // If numThreads is greater than one the file is decompressed
+        // and parsed by a pool of threads using BlockSeqReader
+        SeqReader(std::string filename, uint32_t flags = 0, int numThreads = 1);
         ~SeqReader();
+
+        // Extract the next record from the file
         bool get(SeqRecord& sr);
 
+        // Fill batch with the next records in the file. The records
+        // are parsed in place in the memory held by the batch so nothing
+        // is allocated per record. Returns false at the end of the file.
+        // Calls to get and getBatch cannot be mixed.
+        bool getBatch(SeqRecordBatch& batch);
+
     private:
         std::istream* m_pHandle;
+        BlockSeqReader* m_pBlockReader;
         uint32_t m_flags;
+
+        // Text read from the file after the last complete record
+        std::string m_carry;
+
+        // The records handed out by get
+        SeqRecordBatch m_batch;
+        size_t m_batchPos;
+
+        // The number of quality length warnings printed
+        int m_warnCount;
 };
 
 #endif
@@ -0,0 +1,263 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// SeqRecordBatch - A batch of fasta or fastq records
+// parsed in place in a text buffer.
+//
+#include <string.h>
+#include "SeqRecordBatch.h"
+#include "SeqReader.h"
+
+//
+void SeqRecordView::toSeqRecord(SeqRecord& sr) const
+{
+    sr.id.assign(id, idLength);
+    sr.seq.assign(seq, seqLength);
+    sr.qual.assign(qual, qualLength);
+}
+
+//
+void SeqRecordBatch::clear()
+{
+    m_buffer.clear();
+    m_entries.clear();
+    m_warnings.clear();
+    m_error.clear();
+}
+
+//
+SeqRecordView SeqRecordBatch::operator[](size_t i) const
+{
+    assert(i < m_entries.size());
+    const Entry& entry = m_entries[i];
+    const char* pBase = m_buffer.data();
+
+    SeqRecordView view;
+    view.id = pBase + entry.idStart;
+    view.idLength = entry.idLength;
+    view.seq = pBase + entry.seqStart;
+    view.seqLength = entry.seqLength;
+    view.qual = pBase + entry.qualStart;
+    view.qualLength = entry.qualLength;
+    return view;
+}
+
+//
+void SeqRecordBatch::swap(SeqRecordBatch& other)
+{
+    m_buffer.swap(other.m_buffer);
+    m_entries.swap(other.m_entries);
+    m_warnings.swap(other.m_warnings);
+    m_error.swap(other.m_error);
+}
+
+//
+void SeqRecordBatch::report(int& warnCount) const
+{
+    const int MAX_WARN = 10;
+    for(size_t i = 0; i < m_warnings.size(); ++i)
+    {
+        if(!m_warnings[i].limited || warnCount++ < MAX_WARN)
+            std::cerr << m_warnings[i].text;
+    }
+
+    if(!m_error.empty())
+    {
+        std::cerr << m_error;
+        exit(EXIT_FAILURE);
+    }
+}
+
+//
+size_t SeqRecordBatch::scan(const char* text, size_t len, bool atEOF)
+{
+    // The text is not written to when no entries are requested
+    return parseRecords(const_cast<char*>(text), len, atEOF, 0, NULL);
+}
+
+//
+size_t SeqRecordBatch::parse(bool atEOF, uint32_t flags)
+{
+    assert(m_entries.empty() && m_warnings.empty() && m_error.empty());
+    if(m_buffer.empty())
+        return 0;
+    return parseRecords(&m_buffer[0], m_buffer.size(), atEOF, flags, this);
+}
+
+// Find the end of the line starting at pos and the start of the following line.
+// The last line of the file does not need to end with a newline. Returns false
+// if the line is not complete.
+static inline bool nextLine(const char* text, size_t len, bool atEOF, size_t pos,
+                            size_t& line_end, size_t& next)
+{
+    if(pos >= len)
+        return false;
+
+    const char* pEnd = (const char*)memchr(text + pos, '\n', len - pos);
+    if(pEnd != NULL)
+    {
+        line_end = pEnd - text;
+        next = line_end + 1;
+        return true;
+    }
+    else if(atEOF)
+    {
+        line_end = len;
+        next = len;
+        return true;
+    }
+    return false;
+}
+
+// Records are parsed with the same rules as SeqReader::get used to.
+// Lines that do not start a record are skipped, a fasta record ends
+// at the next line starting with > or @ and a fastq record is 4 lines.
+size_t SeqRecordBatch::parseRecords(char* text, size_t len, bool atEOF,
+                                    uint32_t flags, SeqRecordBatch* pBatch)
+{
+    size_t consumed = 0;
+    size_t pos = 0;
+    size_t line_end;
+    size_t next;
+    while(nextLine(text, len, atEOF, pos, line_end, next))
+    {
+        size_t header_start = pos;
+        size_t header_end = line_end;
+        if(header_start == header_end || (text[header_start] != '>' && text[header_start] != '@'))
+        {
+            // Skip lines that do not start a record
+            pos = consumed = next;
+            continue;
+        }
+
+        Entry entry;
+        entry.seqStart = next;
+        entry.seqLength = 0;
+        entry.qualStart = 0;
+        entry.qualLength = 0;
+
+        if(text[header_start] == '>')
+        {
+            // Find the end of the record before joining the sequence lines
+            // so an incomplete record is left untouched
+            pos = next;
+            bool complete = false;
+            while(true)
+            {
+                if(pos == len)
+                {
+                    complete = atEOF;
+                    break;
+                }
+
+                if(text[pos] == '>' || text[pos] == '@')
+                {
+                    complete = true;
+                    break;
+                }
+
+                if(!nextLine(text, len, atEOF, pos, line_end, next))
+                    break;
+                pos = next;
+            }
+
+            if(!complete)
+                break;
+            consumed = pos;
+            if(pBatch == NULL)
+                continue;
+
+            // Join the lines of the sequence
+            size_t write = entry.seqStart;
+            size_t read = entry.seqStart;
+            while(read < consumed)
+            {
+                nextLine(text, len, true, read, line_end, next);
+                memmove(text + write, text + read, line_end - read);
+                write += line_end - read;
+                read = next;
+            }
+            entry.seqLength = write - entry.seqStart;
+
+            // Fasta records without a sequence are skipped
+            if(entry.seqLength == 0)
+                continue;
+        }
+        else
+        {
+            // Read the sequence, the separator and the quality lines
+            pos = next;
+            size_t seq_end;
+            if(!nextLine(text, len, atEOF, pos, seq_end, next))
+                break;
+            pos = next;
+            if(!nextLine(text, len, atEOF, pos, line_end, next))
+                break;
+            pos = next;
+            size_t qual_end;
+            if(!nextLine(text, len, atEOF, pos, qual_end, next))
+                break;
+            entry.seqLength = seq_end - entry.seqStart;
+            entry.qualStart = pos;
+            entry.qualLength = qual_end - pos;
+            pos = consumed = next;
+
+            if(pBatch == NULL)
+                continue;
+
+            std::string header(text + header_start, header_end - header_start);
+            if(entry.seqLength != entry.qualLength)
+            {
+                Warning warning = { true, "Warning, FASTQ quality string is not the same length as the sequence string for read " + header + "\n" };
+                pBatch->m_warnings.push_back(warning);
+            }
+
+            if(entry.seqLength == 0 || entry.qualLength == 0)
+            {
+                Warning warning = { false, "Warning, read " + header + " has no sequence or quality values\n" };
+                pBatch->m_warnings.push_back(warning);
+            }
+        }
+
+        // Parse the id
+        entry.idStart = header_start + 1;
+        entry.idLength = header_end - entry.idStart;
+        for(size_t i = entry.idStart; i < header_end; ++i)
+        {
+            if(text[i] == ' ' || text[i] == '\t')
+            {
+                entry.idLength = i - entry.idStart;
+                break;
+            }
+        }
+
+        // Convert the sequence string to upper case
+        char* pSeq = text + entry.seqStart;
+        if( !(flags & SRF_KEEP_CASE) )
+        {
+            for(size_t i = 0; i < entry.seqLength; ++i)
+                pSeq[i] = toupper(pSeq[i]);
+        }
+
+        // If the validation flag is set, ensure that there aren't any non-ACGT bases
+        if( !(flags & SRF_NO_VALIDATION) )
+        {
+            for(size_t i = 0; i < entry.seqLength; ++i)
+            {
+                char b = pSeq[i];
+                if(b != 'A' && b != 'C' && b != 'G' && b != 'T')
+                {
+                    pBatch->m_error = "Error: read " + std::string(text + entry.idStart, entry.idLength) + " contains non-ACGT characters.\n"
+                                      "Please run sga preprocess on the data first.\n";
+                    return consumed;
+                }
+            }
+        }
+
+        pBatch->m_entries.push_back(entry);
+    }
+
+    return consumed;
+}
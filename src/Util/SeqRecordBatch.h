@@ -0,0 +1,108 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// SeqRecordBatch - A batch of fasta or fastq records
+// parsed in place in a text buffer. The fields of each
+// record are views into the buffer so no memory is
+// allocated per record. The buffer is reused when the
+// batch is refilled.
+//
+#ifndef SEQRECORDBATCH_H
+#define SEQRECORDBATCH_H
+
+#include "Util.h"
+
+// A record whose fields point into the buffer of a SeqRecordBatch.
+// The view is only valid until the batch is cleared or refilled.
+struct SeqRecordView
+{
+    const char* id;
+    size_t idLength;
+    const char* seq;
+    size_t seqLength;
+    const char* qual;
+    size_t qualLength;
+
+    std::string getID() const { return std::string(id, idLength); }
+    std::string getSeq() const { return std::string(seq, seqLength); }
+    std::string getQual() const { return std::string(qual, qualLength); }
+
+    // Copy the record into sr, reusing the memory held by sr where possible
+    void toSeqRecord(SeqRecord& sr) const;
+};
+
+class SeqRecordBatch
+{
+    public:
+        SeqRecordBatch() {}
+
+        // Remove all the records, keeping the memory for the next fill
+        void clear();
+
+        size_t size() const { return m_entries.size(); }
+        bool empty() const { return m_entries.empty(); }
+        SeqRecordView operator[](size_t i) const;
+
+        void swap(SeqRecordBatch& other);
+
+        // Print the warnings raised while parsing the batch. warnCount is the
+        // number of quality length warnings the reader has printed so far.
+        // If a record could not be parsed the error is printed and the
+        // program exits. This must be called by the thread consuming the
+        // batches so the messages are printed in file order.
+        void report(int& warnCount) const;
+
+        // Return the number of characters at the start of text that make
+        // up complete records. If atEOF is set, the text is assumed to be
+        // the end of the file. The text is not modified.
+        static size_t scan(const char* text, size_t len, bool atEOF);
+
+        // The readers fill in the buffer directly
+        friend class SeqReader;
+        friend class BlockSeqReader;
+
+    private:
+
+        // The offsets of the fields of a record in the buffer
+        struct Entry
+        {
+            size_t idStart;
+            size_t idLength;
+            size_t seqStart;
+            size_t seqLength;
+            size_t qualStart;
+            size_t qualLength;
+        };
+        typedef std::vector<Entry> EntryVector;
+
+        // A warning about a record. The number of limited warnings
+        // printed by a reader is capped.
+        struct Warning
+        {
+            bool limited;
+            std::string text;
+        };
+        typedef std::vector<Warning> WarningVector;
+
+        // Parse the complete records in the buffer. The sequence is
+        // converted to upper case and validated according to the SeqReader
+        // flags. Multi-line fasta sequences are joined in place. Parsing
+        // stops at the first record that fails validation.
+        // Returns the number of characters consumed.
+        size_t parse(bool atEOF, uint32_t flags);
+
+        // Find the complete records at the start of text. If pBatch is not NULL the
+        // records, warnings and errors are parsed into it and the text is modified,
+        // otherwise the records are only counted.
+        static size_t parseRecords(char* text, size_t len, bool atEOF,
+                                   uint32_t flags, SeqRecordBatch* pBatch);
+
+        std::string m_buffer;
+        EntryVector m_entries;
+        WarningVector m_warnings;
+        std::string m_error;
+};
+
+#endif
@@ -8,50 +8,215 @@
 // memory pools. See SimplePool.h for description of allocation
 // strategy
 //
+// Each OpenMP thread allocates from its own set of pools so
+// threads do not contend for the allocator. Objects can be freed
+// by any thread. Pools that no longer hold any objects can be
+// returned to the system with releaseEmptyPools().
+//
 #ifndef SIMPLEALLOCATOR_H
 #define SIMPLEALLOCATOR_H
 
-#include <list>
+#include <vector>
 #include "SimplePool.h"
+#include "config.h"
+
+#if HAVE_OPENMP
+#include <omp.h>
+#endif
 
 template<class T>
 class SimpleAllocator
 {
     typedef SimplePool<T> StorageType;
-    typedef std::list<StorageType* > StorageList;
+    typedef std::vector<StorageType* > StorageList;
+
+    // The pools used by a single thread
+    struct ThreadCache
+    {
+        ThreadCache() : pCurrent(NULL), numReleased(0) {}
+        StorageList pools;
+        StorageType* pCurrent;
+        size_t numReleased;
+    };
 
     public:
-        SimpleAllocator() {}
+
+        static const int MAX_THREADS = 256;
+
+        SimpleAllocator()
+        {
+            for(int i = 0; i < MAX_THREADS; ++i)
+                m_pCaches[i] = NULL;
+        }
 
         ~SimpleAllocator()
         {
-            for(typename StorageList::iterator iter = m_pPoolList.begin(); iter != m_pPoolList.end(); ++iter)
+            for(int i = 0; i < MAX_THREADS; ++i)
             {
-                delete *iter;
+                if(m_pCaches[i] == NULL)
+                    continue;
+                for(size_t j = 0; j < m_pCaches[i]->pools.size(); ++j)
+                    StorageType::destroy(m_pCaches[i]->pools[j]);
+                delete m_pCaches[i];
+                m_pCaches[i] = NULL;
             }
-            m_pPoolList.clear();
         }
 
+        // Allocate from the pools of the calling thread
         void* alloc()
         {
-            if(m_pPoolList.empty() || m_pPoolList.back()->isFull())
+            ThreadCache* pCache = getCache();
+            if(pCache->pCurrent == NULL || pCache->pCurrent->isFull())
+            {
+                // look for a pool with freed slots before allocating new storage
+                pCache->pCurrent = NULL;
+                for(size_t i = 0; i < pCache->pools.size(); ++i)
+                {
+                    if(!pCache->pools[i]->isFull())
+                    {
+                        pCache->pCurrent = pCache->pools[i];
+                        break;
+                    }
+                }
+
+                if(pCache->pCurrent == NULL)
+                {
+                    pCache->pCurrent = StorageType::create();
+                    pCache->pools.push_back(pCache->pCurrent);
+                }
+            }
+            return pCache->pCurrent->alloc();
+        }
+
+        // Return the memory of an object to the pool it came from.
+        // The object may have been allocated by any thread.
+        static void dealloc(void* ptr)
+        {
+            if(ptr != NULL)
+                StorageType::getPool(ptr)->dealloc(ptr);
+        }
+
+        // Free the pools that do not hold any objects. This must
+        // not be called while other threads are using the allocator.
+        // Returns the number of pools that were freed.
+        size_t releaseEmptyPools()
+        {
+            size_t numReleased = 0;
+            for(int i = 0; i < MAX_THREADS; ++i)
+            {
+                ThreadCache* pCache = m_pCaches[i];
+                if(pCache == NULL)
+                    continue;
+
+                StorageList kept;
+                for(size_t j = 0; j < pCache->pools.size(); ++j)
+                {
+                    StorageType* pPool = pCache->pools[j];
+                    if(pPool->isEmpty())
+                    {
+                        pCache->numReleased += pPool->getNumReused();
+                        StorageType::destroy(pPool);
+                        ++numReleased;
+                    }
+                    else
+                    {
+                        kept.push_back(pPool);
+                    }
+                }
+                pCache->pools.swap(kept);
+                pCache->pCurrent = NULL;
+            }
+            return numReleased;
+        }
+
+        // Memory statistics, in bytes. These are not synchronized
+        // with alloc/dealloc.
+
+        // Memory held by the pools
+        size_t getReservedBytes() const
+        {
+            return countPools() * StorageType::POOL_BYTES;
+        }
+
+        // Memory used by objects that have not been freed
+        size_t getLiveBytes() const
+        {
+            size_t n = 0;
+            for(int i = 0; i < MAX_THREADS; ++i)
             {
-                // new storage must be allocated
-                m_pPoolList.push_back(new StorageType);
+                if(m_pCaches[i] == NULL)
+                    continue;
+                for(size_t j = 0; j < m_pCaches[i]->pools.size(); ++j)
+                    n += m_pCaches[i]->pools[j]->getNumLive();
             }
+            return n * sizeof(T);
+        }
 
-            // allocate from the last pool
-            return m_pPoolList.back()->alloc();
+        // Memory of freed objects that is waiting to be reused
+        size_t getFreeBytes() const
+        {
+            size_t n = 0;
+            for(int i = 0; i < MAX_THREADS; ++i)
+            {
+                if(m_pCaches[i] == NULL)
+                    continue;
+                for(size_t j = 0; j < m_pCaches[i]->pools.size(); ++j)
+                    n += m_pCaches[i]->pools[j]->getNumFree();
+            }
+            return n * sizeof(T);
         }
 
-        void dealloc(void* /*ptr*/)
+        // Total memory of freed objects that has been handed out again
+        size_t getReclaimedBytes() const
         {
-            // deallocation not tracked in this strategy
+            size_t n = 0;
+            for(int i = 0; i < MAX_THREADS; ++i)
+            {
+                if(m_pCaches[i] == NULL)
+                    continue;
+                n += m_pCaches[i]->numReleased;
+                for(size_t j = 0; j < m_pCaches[i]->pools.size(); ++j)
+                    n += m_pCaches[i]->pools[j]->getNumReused();
+            }
+            return n * sizeof(T);
         }
 
     private:
 
-        StorageList m_pPoolList;
+        // Not copyable, the pools are owned by the allocator
+        SimpleAllocator(const SimpleAllocator&);
+        SimpleAllocator& operator=(const SimpleAllocator&);
+
+        // Get the pools of the calling thread, creating them if necessary.
+        // Only the thread itself touches its entry so no locking is needed.
+        ThreadCache* getCache()
+        {
+#if HAVE_OPENMP
+            int threadID = omp_get_thread_num();
+#else
+            int threadID = 0;
+#endif
+            if(threadID >= MAX_THREADS)
+            {
+                std::cerr << "SimpleAllocator supports at most " << MAX_THREADS << " threads, exiting\n";
+                abort();
+            }
+
+            if(m_pCaches[threadID] == NULL)
+                m_pCaches[threadID] = new ThreadCache;
+            return m_pCaches[threadID];
+        }
+
+        size_t countPools() const
+        {
+            size_t n = 0;
+            for(int i = 0; i < MAX_THREADS; ++i)
+                if(m_pCaches[i] != NULL)
+                    n += m_pCaches[i]->pools.size();
+            return n;
+        }
+
+        ThreadCache* m_pCaches[MAX_THREADS];
 };
 
 #endif
@@ -4,68 +4,151 @@
 // Released under the GPL license
 //-----------------------------------------------
 //
-// SimplePool - Zero-overhead templated memory pool 
-// The design is based on the premise that the allocation
-// of the objects have a lifetime the length of the program's
-// execution so they are never freed. Should only be used when
-// the number of objects is bounded so the pool does not constantly grow.
+// SimplePool - Zero-overhead templated memory pool
+// The objects are carved out of a single fixed-size block
+// of memory. The block is aligned to its own size and starts
+// with the pool itself, so the pool an object belongs to can be
+// found from the address of the object. This lets an object
+// be freed without knowing which allocator it came from.
+//
+// Freed slots are kept on a list and handed out again before
+// the unused part of the pool. A pool should only be allocated
+// from by one thread at a time but objects can be freed by any
+// thread. Frees are pushed onto a lock-free list which the
+// allocating thread takes over when it runs out of free slots.
 //
-// Not thread-safe.
-// 
 #ifndef SIMPLEPOOL_H
 #define SIMPLEPOOL_H
 
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <iostream>
+#include <new>
+
 template<class T>
 class SimplePool
 {
     public:
 
-        SimplePool()
+        // The size and alignment of the block of memory, in bytes
+        static const size_t POOL_BYTES = 1 << 20;
+
+        // Create a pool in a newly allocated block of memory
+        static SimplePool* create()
         {
-            size_t bytes_per_object = sizeof(T);
-            size_t total_bytes = NUM_OBJECTS * bytes_per_object;
-            m_pPool = malloc(total_bytes);
-            if(m_pPool == NULL)
+            void* pBlock = NULL;
+            if(posix_memalign(&pBlock, POOL_BYTES, POOL_BYTES) != 0)
             {
-                std::cerr << "SimpleStorage failed to allocate " << total_bytes << 
+                std::cerr << "SimplePool failed to allocate " << POOL_BYTES <<
                 " bytes for memory pool, exiting\n";
                 abort();
             }
-            m_capacity = total_bytes;
-            m_used = 0;
+            return new(pBlock) SimplePool;
         }
 
-        ~SimplePool()
+        // Free the block of memory. Any objects still in the pool
+        // must not be used after this call.
+        static void destroy(SimplePool* pPool)
         {
-            free(m_pPool);
+            pPool->~SimplePool();
+            free(pPool);
         }
-    
-        // Return a pointer to the next unused block of memory
+
+        // Return the pool that the object at ptr was allocated from
+        static SimplePool* getPool(void* ptr)
+        {
+            return (SimplePool*)((uintptr_t)ptr & ~(uintptr_t)(POOL_BYTES - 1));
+        }
+
+        // Return a pointer to a free block of memory, preferring
+        // slots of objects that have been freed
         void* alloc()
         {
+            if(m_pFreeList == NULL && m_pRemoteFreeList != NULL)
+                m_pFreeList = __sync_lock_test_and_set(&m_pRemoteFreeList, (FreeSlot*)NULL);
+
+            ++m_numAllocated;
+            if(m_pFreeList != NULL)
+            {
+                FreeSlot* pSlot = m_pFreeList;
+                m_pFreeList = pSlot->pNext;
+                ++m_numReused;
+                return pSlot;
+            }
+
             assert(m_used < m_capacity);
-            void* pNext = (char*)m_pPool + m_used;
-            m_used += sizeof(T);
+            void* pNext = m_pSlots + m_used * sizeof(T);
+            ++m_used;
             return pNext;
         }
 
-        // Do not track deallocations
-        void dealloc(void* /*ptr*/)
+        // Return the slot of an object to the pool. This can
+        // be called by any thread.
+        void dealloc(void* ptr)
         {
-            // does nothing
+            FreeSlot* pSlot = (FreeSlot*)ptr;
+            FreeSlot* pHead;
+            do
+            {
+                pHead = m_pRemoteFreeList;
+                pSlot->pNext = pHead;
+            } while(!__sync_bool_compare_and_swap(&m_pRemoteFreeList, pHead, pSlot));
+            __sync_fetch_and_add(&m_numFreed, 1);
         }
 
-        bool isFull()
+        bool isFull() const
         {
-            return m_used >= m_capacity;
+            return m_pFreeList == NULL && m_pRemoteFreeList == NULL && m_used >= m_capacity;
         }
 
+        // The following are not synchronized with alloc/dealloc
+        bool isEmpty() const { return m_numAllocated == m_numFreed; }
+
+        // Number of objects that are currently allocated
+        size_t getNumLive() const { return m_numAllocated - m_numFreed; }
+
+        // Number of freed slots that have not been handed out again
+        size_t getNumFree() const { return m_numFreed - m_numReused; }
+
+        // Number of allocations that were served from a freed slot
+        size_t getNumReused() const { return m_numReused; }
+
     private:
 
-        void* m_pPool;
+        // A freed slot holds the link to the next free slot
+        struct FreeSlot
+        {
+            FreeSlot* pNext;
+        };
+
+        SimplePool() : m_pFreeList(NULL), m_pRemoteFreeList(NULL), m_used(0),
+                       m_numAllocated(0), m_numFreed(0), m_numReused(0)
+        {
+            size_t header_bytes = (sizeof(*this) + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+            m_pSlots = (char*)this + header_bytes;
+            m_capacity = (POOL_BYTES - header_bytes) / sizeof(T);
+        }
+
+        ~SimplePool() {}
+
+        // Not copyable, the pool lives at the start of its own block
+        SimplePool(const SimplePool&);
+        SimplePool& operator=(const SimplePool&);
+
+        static const size_t SLOT_ALIGNMENT = 16;
+
+        char* m_pSlots;
+        FreeSlot* m_pFreeList;
+        FreeSlot* volatile m_pRemoteFreeList;
+
+        // Capacity and number of slots used, in objects
         size_t m_capacity;
         size_t m_used;
-        static const size_t NUM_OBJECTS = 50*1024;
+
+        size_t m_numAllocated;
+        volatile size_t m_numFreed;
+        size_t m_numReused;
 };
 
 #endif
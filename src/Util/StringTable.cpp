@@ -0,0 +1,62 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// StringTable - Append-only store of NUL-terminated
+// strings packed into large blocks
+//
+#include <string.h>
+#include "StringTable.h"
+
+const size_t StringTable::BLOCK_SIZE;
+
+//
+StringTable::StringTable() : m_blockUsed(0), m_blockCapacity(0), m_allocatedBytes(0)
+{
+
+}
+
+//
+StringTable::~StringTable()
+{
+    clear();
+}
+
+//
+const char* StringTable::add(const char* str, size_t len)
+{
+    size_t required = len + 1;
+    if(m_blocks.empty() || m_blockUsed + required > m_blockCapacity)
+    {
+        // Strings longer than a block get a block of their own
+        size_t capacity = std::max(required, BLOCK_SIZE);
+        m_blocks.push_back(new char[capacity]);
+        m_blockUsed = 0;
+        m_blockCapacity = capacity;
+        m_allocatedBytes += capacity;
+    }
+
+    char* pOut = m_blocks.back() + m_blockUsed;
+    memcpy(pOut, str, len);
+    pOut[len] = '\0';
+    m_blockUsed += required;
+    return pOut;
+}
+
+//
+void StringTable::clear()
+{
+    for(size_t i = 0; i < m_blocks.size(); ++i)
+        delete [] m_blocks[i];
+    m_blocks.clear();
+    m_blockUsed = 0;
+    m_blockCapacity = 0;
+    m_allocatedBytes = 0;
+}
+
+//
+size_t StringTable::getMemSize() const
+{
+    return sizeof(*this) + m_allocatedBytes + m_blocks.capacity() * sizeof(char*);
+}
@@ -0,0 +1,48 @@
+//-----------------------------------------------
+// Copyright 2013 Wellcome Trust Sanger Institute
+// Released under the GPL
+//-----------------------------------------------
+//
+// StringTable - Append-only store of NUL-terminated
+// strings packed into large blocks. Strings are never
+// moved once added so pointers into the table remain valid
+// until the table is cleared or destroyed. This avoids a
+// separate heap allocation for each of a large number of
+// short strings, such as the names of the vertices of a graph.
+//
+#ifndef STRINGTABLE_H
+#define STRINGTABLE_H
+
+#include "Util.h"
+
+class StringTable
+{
+    public:
+        StringTable();
+        ~StringTable();
+
+        // Copy the string into the table and return a pointer to the copy
+        const char* add(const char* str, size_t len);
+        const char* add(const std::string& str) { return add(str.data(), str.size()); }
+
+        // Release all the strings
+        void clear();
+
+        // The number of bytes allocated by the table
+        size_t getMemSize() const;
+
+    private:
+
+        // Not copyable
+        StringTable(const StringTable&);
+        StringTable& operator=(const StringTable&);
+
+        static const size_t BLOCK_SIZE = 1 << 20;
+
+        std::vector<char*> m_blocks;
+        size_t m_blockUsed;
+        size_t m_blockCapacity;
+        size_t m_allocatedBytes;
+};
+
+#endif
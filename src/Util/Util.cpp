@@ -39,6 +39,34 @@ std::string reverseComplementIUPAC(const std::string& seq)
     return out;
 }
 
+//
+bool packCanonicalKmer(const char* w, int k, uint64_t& code)
+{
+    assert(k > 0 && k <= 32);
+    uint64_t fwd = 0;
+    uint64_t rc = 0;
+    for(int i = 0; i < k; ++i)
+    {
+        uint64_t c;
+        switch(w[i])
+        {
+            case 'A': c = 0; break;
+            case 'C': c = 1; break;
+            case 'G': c = 2; break;
+            case 'T': c = 3; break;
+            default: return false;
+        }
+
+        // The complement of a base is 3 - c. Base i of the k-mer
+        // is base k - 1 - i of the reverse complement.
+        fwd = (fwd << 2) | c;
+        rc |= (3 - c) << 2 * i;
+    }
+
+    code = fwd < rc ? fwd : rc;
+    return true;
+}
+
 // Reverse a sequence
 std::string reverse(const std::string& seq)
 {
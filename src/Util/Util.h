@@ -196,6 +196,11 @@ std::string reverseComplement(const std::string& seq);
 std::string complement(const std::string& seq);
 std::string reverse(const std::string& seq);
 
+// Pack the k-mer starting at w, or its reverse complement if it is smaller,
+// into 2 bits per base. Returns false if the k-mer contains a symbol other
+// than A,C,G,T. The k-mer must be at most 32 bases long.
+bool packCanonicalKmer(const char* w, int k, uint64_t& code);
+
 // Reverse/complement functions, allowing a full IUPAC alphabet
 std::string reverseComplementIUPAC(const std::string& seq);
 std::string complementIUPAC(const std::string& seq);
@@ -0,0 +1,137 @@
+#! /usr/bin/env python
+#
+# sga-correct-benchmark.py - Time the overlap-based error
+# correction of synthetic reads at increasing depths of coverage.
+#
+# Reads with substitution errors are sampled from both strands
+# of a random genome, indexed and corrected with
+# sga correct --algorithm=overlap. The overlap search costs about
+# the same at every depth while the consensus over the multi-overlap
+# of each read grows with the depth, so the time per read shows the
+# cost of the consensus. When more than one sga executable is given
+# every executable corrects the same reads and the corrected reads
+# must be identical.
+#
+import getopt
+import os
+import random
+import subprocess
+import sys
+import time
+
+# Params
+sgaList = ["sga"]
+genomeSize = 50000
+readLength = 100
+coverages = [20, 50, 100, 200]
+errorRate = 0.01
+minOverlap = 45
+threads = 1
+outDir = "sga-correct-benchmark"
+seed = 1
+
+def usage():
+    print('usage: sga-correct-benchmark.py [options]')
+    print('Time the overlap-based error correction of synthetic reads')
+    print('Options:')
+    print('    --sga=LIST          comma separated list of sga executables to compare (default: sga)')
+    print('    -g, --genome=INT    simulate a genome of INT bases (default: ' + str(genomeSize) + ')')
+    print('    -l, --length=INT    simulate reads of INT bases (default: ' + str(readLength) + ')')
+    print('    -c, --coverage=LIST comma separated list of coverages to simulate (default: 20,50,100,200)')
+    print('    -e, --error-rate=F  introduce substitutions in the reads at rate F (default: ' + str(errorRate) + ')')
+    print('    -m, --min-overlap=INT  minimum overlap length (default: ' + str(minOverlap) + ')')
+    print('    -t, --threads=INT   use INT threads to correct the reads (default: ' + str(threads) + ')')
+    print('    -o, --out-dir=DIR   write the files to DIR (default: ' + outDir + ')')
+    print('    -s, --seed=INT      seed for the random number generator (default: ' + str(seed) + ')')
+
+def reverseComplement(seq):
+    comp = {'A' : 'T', 'C' : 'G', 'G' : 'C', 'T' : 'A'}
+    return ''.join([comp[b] for b in reversed(seq)])
+
+# Write reads with substitution errors sampled uniformly from both strands of the genome
+def simulateReads(filename, genome, coverage):
+    numReads = genomeSize * coverage // readLength
+    out = open(filename, 'w')
+    for i in range(numReads):
+        pos = random.randint(0, genomeSize - readLength)
+        seq = list(genome[pos:pos + readLength])
+        for j in range(readLength):
+            if random.random() < errorRate:
+                seq[j] = random.choice([b for b in 'ACGT' if b != seq[j]])
+        seq = ''.join(seq)
+        if random.randint(0, 1) == 1:
+            seq = reverseComplement(seq)
+        out.write('>read' + str(i) + '\n' + seq + '\n')
+    out.close()
+    return numReads
+
+# Run a command and return its wall clock time
+def run(args):
+    start = time.time()
+    proc = subprocess.Popen(args, stdout=open(os.devnull, 'w'), stderr=subprocess.PIPE, universal_newlines=True)
+    err = proc.communicate()[1]
+    if proc.returncode != 0:
+        sys.stderr.write(err)
+        print('Error: ' + ' '.join(args) + ' failed')
+        sys.exit(1)
+    return time.time() - start
+
+try:
+    opts, args = getopt.gnu_getopt(sys.argv[1:], 'g:l:c:e:m:t:o:s:h', ['sga=', 'genome=', 'length=', 'coverage=', 'error-rate=',
+                                                                     'min-overlap=', 'threads=', 'out-dir=', 'seed=', 'help'])
+except getopt.GetoptError as err:
+    print(str(err))
+    usage()
+    sys.exit(2)
+
+for (oflag, oarg) in opts:
+    if oflag == '--sga':
+        sgaList = oarg.split(',')
+    elif oflag in ('-g', '--genome'):
+        genomeSize = int(oarg)
+    elif oflag in ('-l', '--length'):
+        readLength = int(oarg)
+    elif oflag in ('-c', '--coverage'):
+        coverages = [int(c) for c in oarg.split(',')]
+    elif oflag in ('-e', '--error-rate'):
+        errorRate = float(oarg)
+    elif oflag in ('-m', '--min-overlap'):
+        minOverlap = int(oarg)
+    elif oflag in ('-t', '--threads'):
+        threads = int(oarg)
+    elif oflag in ('-o', '--out-dir'):
+        outDir = oarg
+    elif oflag in ('-s', '--seed'):
+        seed = int(oarg)
+    elif oflag in ('-h', '--help'):
+        usage()
+        sys.exit(0)
+
+if len(args) > 0 or readLength > genomeSize or minOverlap >= readLength:
+    usage()
+    sys.exit(2)
+
+random.seed(seed)
+if not os.path.isdir(outDir):
+    os.makedirs(outDir)
+os.chdir(outDir)
+
+genome = ''.join([random.choice('ACGT') for i in range(genomeSize)])
+for c in coverages:
+    prefix = 'reads' + str(c)
+    numReads = simulateReads(prefix + '.fa', genome, c)
+    run([sgaList[0], 'index', '-t', str(threads), prefix + '.fa'])
+    print('Simulated ' + str(numReads) + ' reads of length ' + str(readLength) + ' (' + str(c) + 'X)')
+
+    firstOut = None
+    for (i, sga) in enumerate(sgaList):
+        outFile = prefix + '.' + str(i) + '.ec.fa'
+        secs = run([sga, 'correct', '-a', 'overlap', '-t', str(threads), '-m', str(minOverlap), '-o', outFile, prefix + '.fa'])
+        print('  %s: %.2fs (%.1fus per read)' % (sga, secs, secs * 1e6 / numReads))
+
+        out = open(outFile).read()
+        if firstOut is None:
+            firstOut = out
+        elif out != firstOut:
+            print('Error: the reads corrected by ' + sga + ' differ from those corrected by ' + sgaList[0])
+            sys.exit(1)
@@ -0,0 +1,137 @@
+#! /usr/bin/env python
+#
+# sga-tr-benchmark.py - Time the transitive reduction of a
+# synthetic high-coverage string graph with different numbers
+# of threads.
+#
+# A random genome is sampled with error-free reads, which are
+# indexed and overlapped with sga overlap --exhaustive so the
+# graph keeps all of its transitive edges. The graph is then
+# reduced by sga assemble --transitive-reduction for each thread
+# count and the time reported by the reduction timer is printed.
+# For comparison the time to compute only the irreducible overlaps
+# is also reported.
+#
+import getopt
+import os
+import random
+import re
+import subprocess
+import sys
+import time
+
+# Params
+sga = "sga"
+genomeSize = 200000
+readLength = 100
+coverage = 100
+minOverlap = 45
+threadCounts = [1, 2, 4, 8]
+outDir = "sga-tr-benchmark"
+seed = 1
+
+def usage():
+    print('usage: sga-tr-benchmark.py [options]')
+    print('Time the transitive reduction of a synthetic high-coverage string graph')
+    print('Options:')
+    print('    --sga=FILE          use FILE as the sga executable (default: sga)')
+    print('    -g, --genome=INT    simulate a genome of INT bases (default: ' + str(genomeSize) + ')')
+    print('    -l, --length=INT    simulate reads of INT bases (default: ' + str(readLength) + ')')
+    print('    -c, --coverage=INT  simulate reads to INT-fold coverage (default: ' + str(coverage) + ')')
+    print('    -m, --min-overlap=INT  minimum overlap length (default: ' + str(minOverlap) + ')')
+    print('    -t, --threads=LIST  comma separated list of thread counts (default: 1,2,4,8)')
+    print('    -o, --out-dir=DIR   write the files to DIR (default: ' + outDir + ')')
+    print('    -s, --seed=INT      seed for the random number generator (default: ' + str(seed) + ')')
+
+def reverseComplement(seq):
+    comp = {'A' : 'T', 'C' : 'G', 'G' : 'C', 'T' : 'A'}
+    return ''.join([comp[b] for b in reversed(seq)])
+
+# Write error-free reads sampled uniformly from both strands of a random genome
+def simulateReads(filename):
+    genome = ''.join([random.choice('ACGT') for i in range(genomeSize)])
+    numReads = genomeSize * coverage // readLength
+    out = open(filename, 'w')
+    for i in range(numReads):
+        pos = random.randint(0, genomeSize - readLength)
+        seq = genome[pos:pos + readLength]
+        if random.randint(0, 1) == 1:
+            seq = reverseComplement(seq)
+        out.write('>read' + str(i) + '\n' + seq + '\n')
+    out.close()
+    return numReads
+
+# Run a command and return its wall clock time and stderr
+def run(args):
+    start = time.time()
+    proc = subprocess.Popen(args, stdout=open(os.devnull, 'w'), stderr=subprocess.PIPE, universal_newlines=True)
+    err = proc.communicate()[1]
+    if proc.returncode != 0:
+        sys.stderr.write(err)
+        print('Error: ' + ' '.join(args) + ' failed')
+        sys.exit(1)
+    return (time.time() - start, err)
+
+try:
+    opts, args = getopt.gnu_getopt(sys.argv[1:], 'g:l:c:m:t:o:s:h', ['sga=', 'genome=', 'length=', 'coverage=',
+                                                                   'min-overlap=', 'threads=', 'out-dir=', 'seed=', 'help'])
+except getopt.GetoptError as err:
+    print(str(err))
+    usage()
+    sys.exit(2)
+
+for (oflag, oarg) in opts:
+    if oflag == '--sga':
+        sga = oarg
+    elif oflag in ('-g', '--genome'):
+        genomeSize = int(oarg)
+    elif oflag in ('-l', '--length'):
+        readLength = int(oarg)
+    elif oflag in ('-c', '--coverage'):
+        coverage = int(oarg)
+    elif oflag in ('-m', '--min-overlap'):
+        minOverlap = int(oarg)
+    elif oflag in ('-t', '--threads'):
+        threadCounts = [int(t) for t in oarg.split(',')]
+    elif oflag in ('-o', '--out-dir'):
+        outDir = oarg
+    elif oflag in ('-s', '--seed'):
+        seed = int(oarg)
+    elif oflag in ('-h', '--help'):
+        usage()
+        sys.exit(0)
+
+if len(args) > 0 or readLength > genomeSize or minOverlap >= readLength:
+    usage()
+    sys.exit(2)
+
+random.seed(seed)
+if not os.path.isdir(outDir):
+    os.makedirs(outDir)
+os.chdir(outDir)
+
+numReads = simulateReads('reads.fa')
+print('Simulated ' + str(numReads) + ' reads of length ' + str(readLength) + ' from a ' + str(genomeSize) + ' base genome (' + str(coverage) + 'X)')
+
+maxThreads = str(max(threadCounts))
+run([sga, 'index', '-t', maxThreads, 'reads.fa'])
+
+(secs, err) = run([sga, 'overlap', '-t', maxThreads, '-m', str(minOverlap), '-o', 'irreducible.asqg.gz', 'reads.fa'])
+print('Irreducible overlap with ' + maxThreads + ' threads: %.2fs' % secs)
+
+(secs, err) = run([sga, 'overlap', '-t', maxThreads, '-m', str(minOverlap), '--exhaustive', '-o', 'exhaustive.asqg.gz', 'reads.fa'])
+print('Exhaustive overlap with ' + maxThreads + ' threads: %.2fs' % secs)
+
+timerRE = re.compile(r'\[timer - transitive reduction\] wall clock: ([0-9.]+)s')
+baseSecs = 0
+for t in threadCounts:
+    (secs, err) = run([sga, 'assemble', '-t', str(t), '--transitive-reduction', '-o', 'tr' + str(t), 'exhaustive.asqg.gz'])
+    match = timerRE.search(err)
+    if match is None:
+        print('Error: the transitive reduction time was not reported')
+        sys.exit(1)
+    trSecs = float(match.group(1))
+    if baseSecs == 0:
+        baseSecs = trSecs
+    speedup = baseSecs / trSecs if trSecs > 0 else 0
+    print('Transitive reduction with %d threads: %.2fs (%.2fx), assemble total: %.2fs' % (t, trSecs, speedup, secs))